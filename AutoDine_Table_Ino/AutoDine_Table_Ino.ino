@@ -25,6 +25,9 @@
 #include <Wire.h>
 #include <WiFi.h>
 #include <freertos/semphr.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 /* ─── AutoDine source files ─────────────────────────────────────────────── */
 extern "C" {
@@ -33,7 +36,14 @@ extern "C" {
 #include "state_machine.h"
 #include "ui_screens.h"
 #include "autodine_net.h"
+#include "perf_monitor.h"
+#include "anim_governor.h"
+#include "hardware_compat.h"
 }
+#if DISP_RENDER_MODE == DISP_RENDER_DIRECT
+#include <esp_lcd_panel_rgb.h>
+#include <esp_lcd_panel_ops.h>
+#endif
 
 /* ─── LGFX class (proven working from Elecrow color test) ──────────────── */
 class LGFX : public lgfx::LGFX_Device {
@@ -95,9 +105,23 @@ static LGFX lcd;
 /* ─── Touch (official Elecrow touch.h / TAMC_GT911) ────────────────────── */
 #include "touch.h"
 
-/* ─── LVGL draw buffer ── 800×40 partial (official pattern) ────────────── */
+/* ─── LVGL draw buffers ─────────────────────────────────────────────────
+ * PARTIAL: 800×40 stripe in internal RAM (official pattern).
+ * DIRECT : the RGB peripheral is driven by esp_lcd with its two PSRAM
+ *          framebuffers, which LVGL renders into directly; a finished
+ *          frame is swapped in at VSYNC (pointer flip, no copy to the
+ *          panel). Falls back to PARTIAL + LovyanGFX if that fails.     */
+#define PARTIAL_BUF_LINES  40
 static lv_disp_draw_buf_t draw_buf;
-static lv_color_t         disp_buf[800 * 40];
+static lv_color_t         disp_stripe[LCD_H_RES * PARTIAL_BUF_LINES];
+static bool               s_direct_mode = false;
+
+/* ─── Render stats (compare PARTIAL vs DIRECT) ─────────────────────────── */
+static uint32_t s_stat_frames    = 0;   /* completed frames (last flush)   */
+static uint32_t s_stat_px        = 0;   /* pixels pushed to the panel      */
+static uint32_t s_stat_flush_us  = 0;   /* time spent inside my_disp_flush */
+static uint32_t s_stat_lvgl_us   = 0;   /* time spent in lv_timer_handler  */
+static uint32_t s_stat_start_ms  = 0;
 
 /* ─── LVGL mutex (used by ui_screens.c and state_machine.c) ────────────── */
 static SemaphoreHandle_t _lvgl_mux = NULL;
@@ -109,10 +133,198 @@ extern "C" void lvgl_release(void) {
   xSemaphoreGiveRecursive(_lvgl_mux);
 }
 
+#if LVGL_LOCK_DEBUG
+extern "C" bool lvgl_lock_held(void) {
+  return xSemaphoreGetMutexHolder(_lvgl_mux) == xTaskGetCurrentTaskHandle();
+}
+extern "C" void lvgl_lock_violation(const char *where) {
+  Serial.printf("[LVGL] %s called without lvgl_acquire() on task '%s'\n",
+                where, pcTaskGetName(NULL));
+  Serial.flush();
+  abort();
+}
+#endif
+
+/* ─── UI / net job queues (see hardware_compat.h) ──────────────────────── */
+typedef struct { task_job_fn fn; void *arg; } task_job_t;
+static QueueHandle_t _ui_jobs  = NULL;
+static QueueHandle_t _net_jobs = NULL;
+static TaskHandle_t  _ui_task  = NULL;
+static TaskHandle_t  _net_task = NULL;
+
+/* The UI task must never wait on a queue; the net task may wait briefly
+ * for the UI to drain so a result is not dropped. */
+static bool task_post(QueueHandle_t q, task_job_fn fn, void *arg)
+{
+  if (!q || !fn) return false;
+  task_job_t job = { fn, arg };
+  TickType_t wait = (xTaskGetCurrentTaskHandle() == _ui_task) ? 0 : pdMS_TO_TICKS(100);
+  return xQueueSend(q, &job, wait) == pdTRUE;
+}
+extern "C" bool ui_post(task_job_fn fn, void *arg)  { return task_post(_ui_jobs,  fn, arg); }
+extern "C" bool net_post(task_job_fn fn, void *arg) { return task_post(_net_jobs, fn, arg); }
+
+/* ─── DIRECT mode: esp_lcd RGB panel, num_fbs = 2 ─────────────────────────
+ * LVGL draws into the back framebuffer while the front one is scanned
+ * out. The last flush of a frame hands the back buffer to esp_lcd, which
+ * switches scan-out to it at the next VSYNC. The UI task waits for that
+ * edge before taking the LVGL lock again, then copies the frame's dirty
+ * areas into the new back buffer (LVGL 8.3 does not keep the two in
+ * sync) — that buffer is no longer on screen, so the copy cannot tear. */
+#if DISP_RENDER_MODE == DISP_RENDER_DIRECT
+#define DIRECT_DIRTY_MAX  32                 /* LV_INV_BUF_SIZE */
+static esp_lcd_panel_handle_t s_panel = NULL;
+static lv_color_t            *s_fb[2] = { NULL, NULL };
+static SemaphoreHandle_t      _vsync_sem = NULL;
+static volatile bool          s_swap_pending = false;   /* ISR side      */
+static bool                   s_presented    = false;   /* UI task side  */
+static lv_area_t              s_dirty[DIRECT_DIRTY_MAX];
+static uint8_t                s_dirty_n = 0;
+static bool                   s_dirty_all = false;
+static lv_color_t            *s_front = NULL;   /* last presented buffer */
+
+static bool IRAM_ATTR panel_vsync_cb(esp_lcd_panel_handle_t panel,
+                                     const esp_lcd_rgb_panel_event_data_t *edata,
+                                     void *ctx)
+{
+  BaseType_t woken = pdFALSE;
+  if (s_swap_pending) {            /* first edge after draw_bitmap: swapped */
+    s_swap_pending = false;
+    xSemaphoreGiveFromISR(_vsync_sem, &woken);
+  }
+  return woken == pdTRUE;
+}
+
+/* Same timings and pins as the LGFX bus config above */
+static bool direct_panel_init(void)
+{
+  esp_lcd_rgb_panel_config_t cfg = {};
+  cfg.clk_src                    = LCD_CLK_SRC_DEFAULT;
+  cfg.timings.pclk_hz            = 15000000;
+  cfg.timings.h_res              = LCD_H_RES;
+  cfg.timings.v_res              = LCD_V_RES;
+  cfg.timings.hsync_pulse_width  = 48;
+  cfg.timings.hsync_back_porch   = 40;
+  cfg.timings.hsync_front_porch  = 40;
+  cfg.timings.vsync_pulse_width  = 31;
+  cfg.timings.vsync_back_porch   = 13;
+  cfg.timings.vsync_front_porch  = 1;
+  cfg.timings.flags.pclk_active_neg = 1;
+  cfg.data_width         = 16;
+  cfg.bits_per_pixel     = 16;
+  cfg.num_fbs            = 2;
+  cfg.psram_trans_align  = 64;
+  cfg.hsync_gpio_num     = GPIO_NUM_39;
+  cfg.vsync_gpio_num     = GPIO_NUM_40;
+  cfg.de_gpio_num        = GPIO_NUM_41;
+  cfg.pclk_gpio_num      = GPIO_NUM_0;
+  cfg.disp_gpio_num      = -1;
+  const int data_pins[16] = { 15, 7, 6, 5, 4, 9, 46, 3, 8, 16, 1, 14, 21, 47, 48, 45 };
+  for (int i = 0; i < 16; i++) cfg.data_gpio_nums[i] = data_pins[i];
+  cfg.flags.fb_in_psram  = 1;
+
+  if (esp_lcd_new_rgb_panel(&cfg, &s_panel) != ESP_OK) return false;
+  void *fb0 = NULL, *fb1 = NULL;
+  if (esp_lcd_panel_reset(s_panel) != ESP_OK ||
+      esp_lcd_panel_init(s_panel) != ESP_OK ||
+      esp_lcd_rgb_panel_get_frame_buffer(s_panel, 2, &fb0, &fb1) != ESP_OK) {
+    esp_lcd_panel_del(s_panel);
+    s_panel = NULL;
+    return false;
+  }
+  s_fb[0] = (lv_color_t *)fb0;
+  s_fb[1] = (lv_color_t *)fb1;
+  s_front = s_fb[0];                 /* esp_lcd starts scanning fb0 */
+  _vsync_sem = xSemaphoreCreateBinary();
+  esp_lcd_rgb_panel_event_callbacks_t cbs = {};
+  cbs.on_vsync = panel_vsync_cb;
+  esp_lcd_rgb_panel_register_event_callbacks(s_panel, &cbs, NULL);
+  return true;
+}
+
+/* Copy one rectangle between two full-frame buffers */
+static void fb_copy_area(lv_color_t *dst, const lv_color_t *src,
+                         const lv_area_t *a)
+{
+  uint32_t w = (uint32_t)(a->x2 - a->x1 + 1);
+  for (lv_coord_t y = a->y1; y <= a->y2; y++) {
+    uint32_t ofs = (uint32_t)y * LCD_H_RES + a->x1;
+    memcpy(&dst[ofs], &src[ofs], w * sizeof(lv_color_t));
+  }
+}
+
+/* LVGL calls flush once per dirty area with the whole back buffer. The
+ * areas are remembered for the sync copy; the last one presents. */
+static void direct_flush(lv_disp_drv_t *disp, const lv_area_t *area,
+                         lv_color_t *color_p)
+{
+  uint32_t px = (uint32_t)lv_area_get_size(area);
+  if (s_dirty_n < DIRECT_DIRTY_MAX) s_dirty[s_dirty_n++] = *area;
+  else                              s_dirty_all = true;
+  s_stat_px += px;
+  PERF_FLUSH(0, px);
+  if (!lv_disp_flush_is_last(disp)) { lv_disp_flush_ready(disp); return; }
+
+  /* A framebuffer of the panel's own: esp_lcd only switches to it */
+  esp_lcd_panel_draw_bitmap(s_panel, 0, 0, LCD_H_RES, LCD_V_RES, color_p);
+  s_front        = color_p;
+  s_presented    = true;
+  s_swap_pending = true;             /* after draw_bitmap: see the ISR */
+  s_stat_frames++;
+  /* flush_ready comes from direct_swap_sync once the swap happened;
+   * until then LVGL will not render into either buffer */
+}
+
+/* UI task, before lvgl_acquire: block until a presented frame is on
+ * screen. Never holds the LVGL lock while waiting. */
+static bool direct_swap_wait(void)
+{
+  if (!s_presented) return false;
+  s_presented = false;
+  if (xSemaphoreTake(_vsync_sem, pdMS_TO_TICKS(50)) != pdTRUE) {
+    s_swap_pending = false;          /* panel stalled: do not wedge LVGL */
+    Serial.println("[DISP] VSYNC timeout");
+  }
+  return true;
+}
+
+/* UI task, inside lvgl_acquire, after direct_swap_wait returned true */
+static void direct_swap_sync(lv_disp_drv_t *disp)
+{
+  lv_color_t *back = (s_front == s_fb[0]) ? s_fb[1] : s_fb[0];
+  if (s_dirty_all) {
+    memcpy(back, s_front, (size_t)LCD_H_RES * LCD_V_RES * sizeof(lv_color_t));
+  } else {
+    for (uint8_t i = 0; i < s_dirty_n; i++) fb_copy_area(back, s_front, &s_dirty[i]);
+  }
+  s_dirty_n   = 0;
+  s_dirty_all = false;
+  lv_disp_flush_ready(disp);
+}
+
+/* LVGL spinning on a pending swap (only a forced lv_refr_now gets here,
+ * the UI task syncs before every lv_timer_handler): finish it in place */
+static void direct_wait_cb(lv_disp_drv_t *disp)
+{
+  if (direct_swap_wait()) direct_swap_sync(disp);
+}
+#endif
+
 /* ─── LVGL flush (official Elecrow pattern: pushImageDMA) ──────────────── */
 static void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area,
                            lv_color_t *color_p)
 {
+  uint32_t t0 = micros();
+
+#if DISP_RENDER_MODE == DISP_RENDER_DIRECT
+  if (s_direct_mode) {
+    direct_flush(disp, area, color_p);
+    s_stat_flush_us += micros() - t0;
+    PERF_FLUSH(micros() - t0, 0);
+    return;
+  }
+#endif
+
   uint32_t w = (uint32_t)(area->x2 - area->x1 + 1);
   uint32_t h = (uint32_t)(area->y2 - area->y1 + 1);
 
@@ -124,30 +336,202 @@ static void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area,
                    (lgfx::rgb565_t *)&color_p->full);
 #endif
 
+  s_stat_px += w * h;
+  if (lv_disp_flush_is_last(disp)) s_stat_frames++;
+  s_stat_flush_us += micros() - t0;
+  PERF_FLUSH(micros() - t0, w * h);
   lv_disp_flush_ready(disp);
 }
 
-/* ─── LVGL touch read ───────────────────────────────────────────────────── */
+/* ─── Draw buffer setup (DISP_RENDER_MODE in app_config.h) ─────────────── */
+static void disp_buffers_init(lv_disp_drv_t *drv)
+{
+#if DISP_RENDER_MODE == DISP_RENDER_DIRECT
+  if (s_direct_mode) {
+    const size_t fb_px = (size_t)LCD_H_RES * LCD_V_RES;
+    /* fb0 is on screen at start: LVGL's first frame goes to fb1 */
+    lv_disp_draw_buf_init(&draw_buf, s_fb[1], s_fb[0], fb_px);
+    drv->direct_mode = 1;
+    drv->wait_cb     = direct_wait_cb;
+    Serial.println("[DISP] DIRECT mode: esp_lcd 2 framebuffers in PSRAM, swap on VSYNC");
+    return;
+  }
+#endif
+  lv_disp_draw_buf_init(&draw_buf, disp_stripe, NULL, LCD_H_RES * PARTIAL_BUF_LINES);
+  Serial.println("[DISP] PARTIAL mode: 800x40 stripe buffer");
+}
+
+/* Periodic FPS / load line so both modes can be compared on the serial log */
+static void disp_stats_tick(void)
+{
+#if DISP_STATS_INTERVAL_MS > 0
+  uint32_t now = millis();
+  uint32_t dt  = now - s_stat_start_ms;
+  if (dt < DISP_STATS_INTERVAL_MS) return;
+  Serial.printf("[DISP] %s fps=%.1f px/s=%lu flush=%.1f%% lvgl=%.1f%%\n",
+                s_direct_mode ? "direct" : "partial",
+                s_stat_frames * 1000.0f / dt,
+                (unsigned long)((uint64_t)s_stat_px * 1000 / dt),
+                s_stat_flush_us / (dt * 10.0f),
+                s_stat_lvgl_us  / (dt * 10.0f));
+  s_stat_frames = s_stat_px = s_stat_flush_us = s_stat_lvgl_us = 0;
+  s_stat_start_ms = now;
+#endif
+}
+
+/* One call per completed refresh: feeds the animation governor + profiler */
+static void disp_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+  anim_gov_frame(time_ms);
+  sm_trace_render(time_ms);  /* screen-switch cost (state trace) */
+  touch_ring_flushed();      /* closes a pending tap -> frame measurement */
+  PERF_MONITOR(drv, time_ms, px);
+}
+
+/* ─── LVGL touch read ─────────────────────────────────────────────────────
+ * Drains the touch ring: no I2C here. One sample per call, and LVGL is asked
+ * to call again while more are queued, so a tap shorter than the read
+ * period still arrives as press + release. With nothing queued the last
+ * state holds (a finger resting still produces no new samples). */
 static void my_touchpad_read(lv_indev_drv_t *indev_driver,
                               lv_indev_data_t *data)
 {
-  if (touch_has_signal()) {
-    if (touch_touched()) {
-      data->state   = LV_INDEV_STATE_PR;
-      data->point.x = touch_last_x;
-      data->point.y = touch_last_y;
-    } else if (touch_released()) {
-      data->state = LV_INDEV_STATE_REL;
+  touch_sample_t s;
+  if (touch_next(&s)) data->continue_reading = touch_ring_pending();
+  data->point.x = touch_last_x;
+  data->point.y = touch_last_y;
+  data->state   = touch_last_pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+  /* A finger on the glass freezes looping animations (touch first) */
+  anim_gov_touch(touch_last_pressed);
+}
+
+/* ─── LVGL tick ─────────────────────────────────────────────────────────
+ * With LV_TICK_CUSTOM (millis) in lv_conf.h LVGL reads the clock itself;
+ * otherwise a 1 ms esp_timer feeds lv_tick_inc() so animation timing does
+ * not depend on how often the UI task happens to run. */
+#if !LV_TICK_CUSTOM
+static void lv_tick_cb(void *arg) { lv_tick_inc(1); }
+
+static void lv_tick_start(void)
+{
+  esp_timer_create_args_t args = {};
+  args.callback = lv_tick_cb;
+  args.name     = "lv_tick";
+  esp_timer_handle_t t;
+  if (esp_timer_create(&args, &t) == ESP_OK) esp_timer_start_periodic(t, 1000);
+}
+#endif
+
+/* ─── Serial console (UI task, inside lvgl_acquire) ────────────────────────
+ *  p            toggle the profiler overlay          (AUTODINE_PROFILE)
+ *  t X Y [N]    inject N synthetic taps at X,Y        (TOUCH_LAT_HARNESS)
+ *  l            print the touch latency report now    (TOUCH_LAT_HARNESS)
+ *  s            print the state trace + dwell times   (SM_TRACE_RING)
+ * 'p' acts on its own at the start of a line; the rest end with a newline. */
+#if AUTODINE_PROFILE || TOUCH_LAT_HARNESS || SM_TRACE_RING
+static void serial_console_poll(void)
+{
+  static char line[32];
+  static uint8_t len = 0;
+
+  while (Serial.available()) {
+    char c = (char)Serial.read();
+    if (c == 'p' && len == 0) { PERF_OVERLAY_TOGGLE(); continue; }
+    if (c != '\n' && c != '\r') {
+      if (len < sizeof(line) - 1) line[len++] = c;
+      continue;
     }
-  } else {
+    line[len] = '\0';
+    len = 0;
+#if SM_TRACE_RING
+    if (line[0] == 's') { sm_trace_dump(); continue; }
+#endif
+#if TOUCH_LAT_HARNESS
+    int x, y, n = 1;
+    if (sscanf(line, "t %d %d %d", &x, &y, &n) >= 2) {
+      int q = touch_inject_tap((int16_t)x, (int16_t)y, n);
+      Serial.printf("[LAT] injected %d tap(s) at %d,%d\n", q, x, y);
+    } else if (line[0] == 'l') {
+      touch_lat_report();
+    }
+#endif
+  }
+}
+#endif
+
+/* ─── UI task (UI_TASK_CORE): LVGL, state machine, queued UI jobs ────── */
+static void ui_task(void *arg)
+{
+  for (;;) {
+    PERF_LOOP_MARK();
+#if DISP_RENDER_MODE == DISP_RENDER_DIRECT
+    bool swapped = direct_swap_wait();     /* outside the LVGL lock */
+    lvgl_acquire();
+    if (swapped) direct_swap_sync(lv_disp_get_default()->driver);
+#else
+    lvgl_acquire();
+#endif
+    uint32_t t_lv = micros();
+    uint32_t next_ms = lv_timer_handler();
+    s_stat_lvgl_us += micros() - t_lv;
+    PERF_LVGL(micros() - t_lv);
+    anim_gov_tick();
+
+    /* Results handed back by the net task; run outside any LVGL callback */
+    task_job_t job;
+    while (xQueueReceive(_ui_jobs, &job, 0) == pdTRUE) job.fn(job.arg);
+
+    sm_update();
+    PERF_TICK();
+#if AUTODINE_PROFILE || TOUCH_LAT_HARNESS || SM_TRACE_RING
+    serial_console_poll();
+#endif
+    lvgl_release();
+    disp_stats_tick();
+    touch_ring_tick();
+
+    if (next_ms > UI_TASK_PERIOD_MS) next_ms = UI_TASK_PERIOD_MS;
+    vTaskDelay(pdMS_TO_TICKS(next_ms ? next_ms : 1));
   }
 }
 
-/* ─── WiFi + first menu fetch ───────────────────────────────────────────── */
+/* ─── Net task (NET_TASK_CORE): WiFi, HTTP, polling ─────────────────────── */
 static bool s_wifi_done    = false;
 static bool s_menu_fetched = false;
 static unsigned long s_wifi_start = 0;
 
+static void wifi_up_job(void *arg) { ui_set_wifi_connected(true); }
+
+static void net_task(void *arg)
+{
+  for (;;) {
+    /* Jobs posted from LVGL callbacks; the wait doubles as the task period */
+    task_job_t job;
+    if (xQueueReceive(_net_jobs, &job, pdMS_TO_TICKS(NET_TASK_PERIOD_MS)) == pdTRUE) {
+      job.fn(job.arg);
+      while (xQueueReceive(_net_jobs, &job, 0) == pdTRUE) job.fn(job.arg);
+    }
+
+    /* Deferred flags, live menu and payment polling */
+    ui_check_deferred();
+
+    /* === WiFi connection check (non-blocking, first 10s) */
+    if (!s_wifi_done && (millis() - s_wifi_start < 10000)) {
+      if (WiFi.status() == WL_CONNECTED) {
+        s_wifi_done = true;
+        Serial.printf("WiFi OK: %s\n", WiFi.localIP().toString().c_str());
+        ui_post(wifi_up_job, NULL);
+      }
+    }
+
+    /* === Fetch menu once after WiFi is up */
+    if (s_wifi_done && !s_menu_fetched) {
+      s_menu_fetched = true;   /* set first so we don't retry on failure */
+      ui_menu_post(net_fetch_menu());   /* parsed here, laid out on the UI task */
+    }
+  }
+}
+
 /* ══════════════════════════════════════════════════════════════════════════ */
 void setup()
 {
@@ -162,9 +546,16 @@ void setup()
   pinMode(2, OUTPUT);
   digitalWrite(2, HIGH);
 
-  /* Display */
-  lcd.begin();
-  lcd.fillScreen(TFT_BLACK);
+  /* Display: DIRECT owns the RGB peripheral through esp_lcd; LovyanGFX
+   * drives it otherwise, or when the framebuffers cannot be allocated */
+#if DISP_RENDER_MODE == DISP_RENDER_DIRECT
+  s_direct_mode = direct_panel_init();
+  if (!s_direct_mode) Serial.println("[DISP] esp_lcd panel failed - falling back to PARTIAL mode");
+#endif
+  if (!s_direct_mode) {
+    lcd.begin();
+    lcd.fillScreen(TFT_BLACK);
+  }
 
   /* Touch */
   touch_init();
@@ -172,71 +563,61 @@ void setup()
   /* LVGL mutex + init */
   _lvgl_mux = xSemaphoreCreateRecursiveMutex();
   lv_init();
-  lv_disp_draw_buf_init(&draw_buf, disp_buf, NULL, 800 * 40);
 
   static lv_disp_drv_t disp_drv;
   lv_disp_drv_init(&disp_drv);
-  disp_drv.hor_res  = 800;
-  disp_drv.ver_res  = 480;
+  disp_buffers_init(&disp_drv);
+  disp_drv.hor_res  = LCD_H_RES;
+  disp_drv.ver_res  = LCD_V_RES;
   disp_drv.flush_cb = my_disp_flush;
   disp_drv.draw_buf = &draw_buf;
+  disp_drv.monitor_cb = disp_monitor_cb;
   lv_disp_drv_register(&disp_drv);
 
   static lv_indev_drv_t indev_drv;
   lv_indev_drv_init(&indev_drv);
   indev_drv.type    = LV_INDEV_TYPE_POINTER;
   indev_drv.read_cb = my_touchpad_read;
-  lv_indev_drv_register(&indev_drv);
+  lv_indev_t *indev = lv_indev_drv_register(&indev_drv);
+  /* Reads are ring pops now, so poll LVGL's side often */
+  lv_timer_set_period(indev->driver->read_timer, TOUCH_LVGL_READ_MS);
+
+  /* Queues first: a resumed screen posts its fetches on entry; they
+   * run once the net task starts */
+  _ui_jobs  = xQueueCreate(TASK_QUEUE_LEN, sizeof(task_job_t));
+  _net_jobs = xQueueCreate(TASK_QUEUE_LEN, sizeof(task_job_t));
 
   /* App init */
   sm_init();
   cart_clear();
   lvgl_acquire();
   ui_init();
-  ui_show_screen(STATE_SPLASH);
+  bool resumed = ui_resume_session();
+  if (!resumed) ui_show_screen(STATE_SPLASH);
+  PERF_INIT();
   lvgl_release();
+  Serial.printf("[UI] Boot-to-%s %lu ms%s, free heap %u B\n",
+                sm_state_name(sm_get()), millis(), resumed ? " (resumed)" : "",
+                (unsigned)ESP.getFreeHeap());
 
-  /* Start WiFi (non-blocking — checked in loop) */
+  /* Start WiFi (non-blocking — checked in net_task) */
   WiFi.begin(WIFI_SSID, WIFI_PASS);
   s_wifi_start = millis();
-  Serial.println("Setup done — entering loop");
+
+#if !LV_TICK_CUSTOM
+  lv_tick_start();
+#endif
+  xTaskCreatePinnedToCore(ui_task,  "ui",  UI_TASK_STACK,  NULL, UI_TASK_PRIO,
+                          &_ui_task,  UI_TASK_CORE);
+  xTaskCreatePinnedToCore(net_task, "net", NET_TASK_STACK, NULL, NET_TASK_PRIO,
+                          &_net_task, NET_TASK_CORE);
+  Serial.printf("Setup done — ui task on core %d, net task on core %d\n",
+                UI_TASK_CORE, NET_TASK_CORE);
 }
 
 /* ══════════════════════════════════════════════════════════════════════════ */
+/* All work happens in ui_task / net_task; the Arduino loop task is not needed */
 void loop()
 {
-  /* === LVGL tick + handler (official pattern) */
-  /* LVGL tick is driven by LV_TICK_CUSTOM (millis) in lv_conf.h */
-  lvgl_acquire();
-  lv_timer_handler();
-  sm_update();
-  lvgl_release();
-
-  /* Handle blocking network calls (UPI/Append) outside the mutex */
-  ui_check_deferred();
-
-  /* === WiFi connection check (non-blocking, first 10s) */
-  if (!s_wifi_done && (millis() - s_wifi_start < 10000)) {
-    if (WiFi.status() == WL_CONNECTED) {
-      s_wifi_done = true;
-      Serial.printf("WiFi OK: %s\n", WiFi.localIP().toString().c_str());
-      lvgl_acquire();
-      ui_set_wifi_connected(true);
-      lvgl_release();
-    }
-  }
-
-  /* === Fetch menu once after WiFi is up */
-  if (s_wifi_done && !s_menu_fetched) {
-    s_menu_fetched = true;   /* set first so we don't retry on failure */
-    char *json = net_fetch_menu();
-    if (json) {
-      lvgl_acquire();
-      ui_menu_load(json);
-      lvgl_release();
-      free(json);
-    }
-  }
-
-  delay(5);
+  vTaskDelete(NULL);
 }
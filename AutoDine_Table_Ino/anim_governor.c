@@ -0,0 +1,189 @@
+/* =====================================================================
+ *  anim_governor.c — AutoDine V4.0 adaptive animation governor
+ * ===================================================================== */
+#include "anim_governor.h"
+#include "autodine_net.h"
+
+#define GOV_SLOTS  8   /* looping animations alive at once */
+
+typedef struct {
+    lv_obj_t           *obj;      /* NULL = free slot */
+    lv_anim_exec_xcb_t  exec;
+    int32_t             from, to;
+    uint32_t            time_ms;
+    int32_t             last;     /* last value handed to exec */
+    bool                running;
+} gov_loop_t;
+
+static gov_loop_t   s_loops[GOV_SLOTS];
+static anim_level_t s_level = ANIM_LVL_FULL;
+
+/* Current window */
+static uint32_t s_win_start  = 0;
+static uint32_t s_win_sum_ms = 0;
+static uint32_t s_win_frames = 0;
+static uint8_t  s_hot_windows = 0;
+static uint32_t s_cool_ms     = 0;
+
+static bool     s_touch_down = false;
+static uint32_t s_touch_up_ms = 0;
+
+static const char *level_name(anim_level_t l)
+{
+    switch (l) {
+    case ANIM_LVL_FULL:    return "full";
+    case ANIM_LVL_REDUCED: return "reduced";
+    case ANIM_LVL_STATIC:  return "static";
+    default:               return "paused";
+    }
+}
+
+static bool touch_hold(void)
+{
+    return s_touch_down || lv_tick_elaps(s_touch_up_ms) < ANIM_GOV_TOUCH_HOLD_MS;
+}
+
+/* lv_anim var is the slot, so a deleted obj is never dereferenced */
+static void loop_exec_cb(void *var, int32_t v)
+{
+    gov_loop_t *g = (gov_loop_t *)var;
+    if (!g->obj || touch_hold()) return;   /* freeze in place */
+
+    if (s_level == ANIM_LVL_REDUCED && g->to != g->from) {
+        int32_t span = g->to - g->from;
+        int32_t step = (int32_t)((v - g->from) * ANIM_GOV_REDUCED_STEPS + span / 2) / span;
+        v = g->from + step * span / ANIM_GOV_REDUCED_STEPS;
+    }
+    if (v == g->last) return;              /* nothing to invalidate */
+    g->last = v;
+    g->exec(g->obj, v);
+}
+
+static void loop_start(gov_loop_t *g)
+{
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, g);
+    lv_anim_set_exec_cb(&a, loop_exec_cb);
+    lv_anim_set_values(&a, g->from, g->to);
+    lv_anim_set_time(&a, g->time_ms);
+    lv_anim_set_playback_time(&a, g->time_ms);
+    lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_in_out);
+    lv_anim_start(&a);
+    g->running = true;
+}
+
+static void loop_stop(gov_loop_t *g)
+{
+    if (g->running) lv_anim_del(g, NULL);
+    g->running = false;
+    if (g->obj && g->last != g->from) {
+        g->last = g->from;
+        g->exec(g->obj, g->from);          /* static fallback: rest value */
+    }
+}
+
+static void loop_obj_deleted_cb(lv_event_t *e)
+{
+    gov_loop_t *g = (gov_loop_t *)lv_event_get_user_data(e);
+    if (g->running) lv_anim_del(g, NULL);
+    g->running = false;
+    g->obj     = NULL;
+}
+
+void anim_gov_loop(lv_obj_t *obj, lv_anim_exec_xcb_t exec,
+                   int32_t from, int32_t to, uint32_t time_ms)
+{
+    if (!obj || !exec) return;
+    gov_loop_t *g = NULL;
+    for (int i = 0; i < GOV_SLOTS; i++) {
+        if (s_loops[i].obj == obj && s_loops[i].exec == exec) { g = &s_loops[i]; break; }
+        if (!g && !s_loops[i].obj) g = &s_loops[i];
+    }
+    if (!g) { exec(obj, from); return; }
+
+    if (g->obj == obj) {
+        loop_stop(g);                      /* restart an existing loop */
+    } else {
+        g->obj = obj;
+        g->exec = exec;
+        lv_obj_add_event_cb(obj, loop_obj_deleted_cb, LV_EVENT_DELETE, g);
+    }
+    g->from    = from;
+    g->to      = to;
+    g->time_ms = time_ms;
+    g->last    = from;
+    exec(obj, from);
+    if (s_level <= ANIM_LVL_REDUCED) loop_start(g);
+}
+
+void anim_gov_frame(uint32_t time_ms)
+{
+    s_win_sum_ms += time_ms;
+    s_win_frames++;
+}
+
+void anim_gov_touch(bool pressed)
+{
+    if (s_touch_down && !pressed) s_touch_up_ms = lv_tick_get();
+    s_touch_down = pressed;
+}
+
+static void set_level(anim_level_t lvl, uint32_t avg_ms)
+{
+    if (lvl == s_level) return;
+    bool was_running = s_level <= ANIM_LVL_REDUCED;
+    bool run         = lvl <= ANIM_LVL_REDUCED;
+    s_level = lvl;
+    for (int i = 0; i < GOV_SLOTS; i++) {
+        gov_loop_t *g = &s_loops[i];
+        if (!g->obj) continue;
+        if (was_running && !run) loop_stop(g);
+        else if (!was_running && run) loop_start(g);
+    }
+    net_log("[ANIM] level %s (avg frame %lums)\n", level_name(lvl),
+            (unsigned long)avg_ms);
+}
+
+void anim_gov_tick(void)
+{
+#if ANIM_GOV_ENABLE
+    uint32_t el = lv_tick_elaps(s_win_start);
+    if (el < ANIM_GOV_WINDOW_MS) return;
+
+    /* A window with no refresh at all is idle, i.e. light load */
+    uint32_t avg = s_win_frames ? s_win_sum_ms / s_win_frames : 0;
+    s_win_start  = lv_tick_get();
+    s_win_sum_ms = s_win_frames = 0;
+
+    if (avg > ANIM_FRAME_BUDGET_MS) {
+        s_cool_ms = 0;
+        if (++s_hot_windows >= ANIM_GOV_DOWN_WINDOWS) {
+            s_hot_windows = 0;
+            if (s_level < ANIM_LVL_PAUSED) set_level((anim_level_t)(s_level + 1), avg);
+        }
+    } else if (avg * 100 < ANIM_FRAME_BUDGET_MS * 60u) {
+        s_hot_windows = 0;
+        s_cool_ms += el;
+        if (s_cool_ms >= ANIM_GOV_RECOVER_MS) {
+            s_cool_ms = 0;
+            if (s_level > ANIM_LVL_FULL) set_level((anim_level_t)(s_level - 1), avg);
+        }
+    } else {
+        s_hot_windows = 0;                 /* in the hysteresis band: hold */
+        s_cool_ms     = 0;
+    }
+#endif
+}
+
+anim_level_t anim_gov_level(void) { return s_level; }
+
+uint32_t anim_gov_time(uint32_t ms)
+{
+    switch (s_level) {
+    case ANIM_LVL_STATIC: return ms / 2;
+    case ANIM_LVL_PAUSED: return 0;
+    default:              return ms;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+/* =====================================================================
+ *  anim_governor.h — AutoDine V4.0 adaptive animation governor
+ *
+ *  Watches render time per refresh (disp monitor_cb) and steps the
+ *  decorative animations down when frames run over budget:
+ *
+ *    FULL     every animation as designed
+ *    REDUCED  looping animations snap to ANIM_GOV_REDUCED_STEPS values,
+ *             so they invalidate a few times per cycle, not every frame
+ *    STATIC   looping animations stop at their rest value; one-shot
+ *             animations and screen transitions run at half length
+ *    PAUSED   as STATIC, and one-shots / transitions are instant
+ *
+ *  It steps back up one level after ANIM_GOV_RECOVER_MS of light load.
+ *  While a finger is down, looping animations freeze in place so touch
+ *  handling gets the frame budget. All calls: UI task, inside lvgl_acquire.
+ * ===================================================================== */
+#include "app_config.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ANIM_LVL_FULL = 0,
+    ANIM_LVL_REDUCED,
+    ANIM_LVL_STATIC,
+    ANIM_LVL_PAUSED
+} anim_level_t;
+
+/* Feed one completed refresh (from the display monitor_cb) */
+void anim_gov_frame(uint32_t time_ms);
+
+/* Touch state from the indev read_cb */
+void anim_gov_touch(bool pressed);
+
+/* Re-evaluate the level once per UI pass; applies level changes */
+void anim_gov_tick(void);
+
+anim_level_t anim_gov_level(void);
+
+/* Duration to use for a one-shot animation or screen transition */
+uint32_t anim_gov_time(uint32_t ms);
+
+/* Start a looping from -> to -> from animation on obj, owned by the
+ * governor (stopped automatically when obj is deleted). time_ms is one
+ * direction. If the governor is full or the level is STATIC/PAUSED, obj
+ * is left at `from`. */
+void anim_gov_loop(lv_obj_t *obj, lv_anim_exec_xcb_t exec,
+                   int32_t from, int32_t to, uint32_t time_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,10 +15,138 @@
 #define LCD_H_RES   800
 #define LCD_V_RES   480
 
+/* ---------- Render mode ----------
+ * DISP_RENDER_PARTIAL: 800x40 stripe buffer in internal RAM (Elecrow pattern).
+ * DISP_RENDER_DIRECT : esp_lcd RGB panel with two PSRAM framebuffers; LVGL
+ *                      direct mode renders into the back one and it is
+ *                      swapped in at VSYNC, so screen transitions do not
+ *                      tear. Needs OPI PSRAM and arduino-esp32 3.x (IDF 5). */
+#define DISP_RENDER_PARTIAL  0
+#define DISP_RENDER_DIRECT   1
+#define DISP_RENDER_MODE     DISP_RENDER_PARTIAL
+#define DISP_STATS_INTERVAL_MS  5000   /* FPS / flush-load log period (0 = off) */
+
+/* ---------- Screens ----------
+ * Splash and menu stay resident; other screens are built on first use and
+ * the least recently used is deleted when their total LVGL heap exceeds
+ * this budget. */
+#define UI_SCREEN_MEM_BUDGET    (40 * 1024)
+#define UI_PREWARM_MS           600     /* splash up -> menu built (UI task) */
+
+/* Menu cards blit a pre-rendered background+shadow image (ui_theme card
+ * skin, PSRAM) instead of drawing a 30px shadow on every scroll frame. */
+#define UI_CARD_SKINS           1
+
+/* ---------- Cart (cart.c) ----------
+ * Items come from a pool grown CART_CHUNK_ITEMS at a time (PSRAM when
+ * available) and kept for reuse; CART_HARD_CAP bounds a single cart. */
+#define CART_HARD_CAP           128     /* unique items; <= 256 */
+#define CART_CHUNK_ITEMS        16
+#define CART_MAX_SEATS          6       /* seats 1..N; seat 0 = shared by the table */
+#define BILL_LEDGER_MAX         64      /* submitted (item, seat) lines kept for the instant bill */
+
+/* ---------- Tasks ----------
+ * LVGL (render, touch, state machine) owns one core; WiFi, HTTP and all
+ * polling run on the other, so a slow request never stalls a frame.
+ * The WiFi driver itself lives on core 0, next to the net task. */
+#define UI_TASK_CORE            1
+#define UI_TASK_PRIO            3
+#define UI_TASK_STACK           (12 * 1024)
+#define UI_TASK_PERIOD_MS       5       /* max sleep between lv_timer_handler runs */
+#define NET_TASK_CORE           0
+#define NET_TASK_PRIO           2
+#define NET_TASK_STACK          (8 * 1024)
+#define NET_TASK_PERIOD_MS      20      /* deferred-flag / WiFi check cadence      */
+#define TASK_QUEUE_LEN          16      /* ui_post / net_post depth                */
+#define LVGL_LOCK_DEBUG         0       /* 1 = abort if LVGL is used without lvgl_acquire() */
+
+/* ---------- State machine (state_machine.c) ----------
+ * Screens, timers and net completions post events; the UI task applies
+ * them through the transition table once per pass. */
+#define SM_QUEUE_LEN            16      /* pending events; power of two       */
+#define SM_TRACE                1       /* "[SM]" line per transition / drop  */
+/* Transition trace ring + dwell histograms ("s" on the serial console
+ * dumps them; batches go to POST /api/trace for floor-wide analysis) */
+#define SM_TRACE_RING           64      /* transitions kept (0 = off)          */
+#define SM_TRACE_RENDER_MS      600     /* refreshes after a switch charged to it */
+#define SM_TRACE_UPLOAD_MS      60000   /* batch upload period (0 = never)     */
+#define SM_TRACE_BATCH          16      /* transitions per POST                */
+
+/* ---------- Session resume (session_store.c) ----------
+ * The session is snapshotted to NVS on every transition and, while the
+ * guest edits the cart or pays seat by seat, every SESSION_SAVE_MS —
+ * written only when it changed. After a reset the table reopens on the
+ * same screen and re-checks the order with the server in the background. */
+#define SESSION_RESUME          1
+#define SESSION_SAVE_MS         2000
+
+/* ---------- Prefetch (ui_screens.c) ----------
+ * The bill is fetched (server "preview": no status change) as soon as the
+ * food is served, the UPI link as soon as the bill is up, so both screens
+ * open without a round trip. An append drops whatever was prefetched. */
+#define PREFETCH_ENABLE         1
+
+/* ---------- Live cart (ui_screens.c) ----------
+ * Cart edits stream to the server (POST /api/cart/delta) as one batch per
+ * window, for the kitchen's live-demand view; the order is then a commit
+ * of the server's copy. Any lost batch falls back to the full order post. */
+#define LIVE_CART_SYNC          1
+#define LIVE_CART_BATCH_MS      400
+
+/* ---------- Touch (touch.h, touch_ring.c) ----------
+ * The GT911 is read only by the touch task: woken by its INT line when
+ * TOUCH_GT911_INT is wired, otherwise polling. Changed samples go into a
+ * lock-free ring that LVGL's read_cb drains without any I2C traffic. */
+#define TOUCH_TASK_CORE         0
+#define TOUCH_TASK_PRIO         4       /* above net: a read never waits on HTTP  */
+#define TOUCH_TASK_STACK        (3 * 1024)
+#define TOUCH_POLL_ACTIVE_MS    8       /* poll / INT watchdog while a finger is down */
+#define TOUCH_POLL_IDLE_MS      25      /* fallback poller with no finger down    */
+#define TOUCH_LVGL_READ_MS      10      /* indev read period (ring only, no I2C)  */
+#define TOUCH_STATS_MS          10000   /* "[TOUCH]" latency log period (0 = off) */
+
+/* ---------- Animation governor (anim_governor.c) ----------
+ * Render time per refresh is averaged over short windows; sustained
+ * over-budget windows step decorative animation down one level
+ * (full -> reduced -> static -> paused), a quiet spell steps it back up. */
+#define ANIM_GOV_ENABLE         1
+#define ANIM_FRAME_BUDGET_MS    40      /* avg render+flush per refresh        */
+#define ANIM_GOV_WINDOW_MS      250
+#define ANIM_GOV_DOWN_WINDOWS   3       /* consecutive hot windows to step down */
+#define ANIM_GOV_RECOVER_MS     2000    /* time under 60% of budget to step up  */
+#define ANIM_GOV_REDUCED_STEPS  6       /* values per half-cycle when reduced   */
+#define ANIM_GOV_TOUCH_HOLD_MS  250     /* loops stay frozen after finger lift  */
+
 /* ---------- Timeouts ---------- */
 #define NET_TIMEOUT_MS          8000
+/* Order / append / served carry an operation id the server dedups, so
+ * they retry fast instead of waiting NET_TIMEOUT_MS once. Worst case
+ * NET_OP_TRIES x timeout + 200+400+800 ms backoff. */
+#define NET_OP_TIMEOUT_MS       2500
+#define NET_OP_TRIES            4
+#define NET_OP_BACKOFF_MS       200
 #define ORDER_POLL_INTERVAL_MS  3000
 #define PAYMENT_POLL_MS         3000
+#define MENU_AVAIL_POLL_MS      5000    /* GET /api/menu/availability (menu screen) */
+#define MENU_REFRESH_MS         60000   /* full GET /api/menu re-diff              */
+
+/* ---------- Diagnostics ---------- */
+#define UI_CART_TIMING          0       /* log +/- tap -> cart panel update in us */
+#define UI_SCROLL_BENCH         0       /* time 60 forced menu scroll frames once */
+
+/* Frame profiler (perf_monitor.c): overlay + "[PERF]" serial records.
+ * Keep 0 for release builds — everything compiles out. */
+#define AUTODINE_PROFILE        0
+#define PERF_REPORT_MS          1000    /* record / overlay refresh period   */
+#define PERF_OVERLAY_DEFAULT    1       /* overlay visible at boot ('p' toggles) */
+
+/* Touch-to-photon harness (touch_ring.c): tags event callbacks so each
+ * tap is timed sample -> read_cb -> callback -> refresh. Serial console
+ * "t X Y [N]" injects N synthetic taps, "l" prints the report. */
+#define TOUCH_LAT_HARNESS       0
+#define TOUCH_LAT_TRACE         0       /* one "[LAT]" line per interaction   */
+#define TOUCH_SYN_HOLD_MS       80      /* synthetic press -> release         */
+#define TOUCH_SYN_TAP_MS        400     /* spacing of repeated synthetic taps */
 
 /* ---------- Table Label (D1 — eliminate hardcoded strings) ---------- */
 #define _STRINGIFY(x)  #x
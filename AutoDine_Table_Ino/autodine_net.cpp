@@ -9,9 +9,15 @@
  * NEW FUNCTIONS ADDED (V4.0 Bug Fixes):
  *   net_append_order()   — POST /api/order/append (BUG 1 Fix: add-more-items)
  *   net_payment_timeout()— POST /api/payment/timeout (Razorpay QR timeout)
+ *
+ * Order placement, append and "served" are idempotent (http_post_op):
+ * each carries an X-Op-Id the server dedups, so they retry on short
+ * timeouts instead of waiting NET_TIMEOUT_MS once. So is the live-cart
+ * commit that replaces the order post when LIVE_CART_SYNC streamed it.
  */
 #include "autodine_net.h"
 #include "app_config.h"
+#include "session_store.h"
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <Arduino.h>
@@ -39,7 +45,7 @@ bool net_is_wifi_ok(void)
 /* ═══════════════════════════════════════════════════════════════════
  *  Bug 11 — JSON string escaper for user-supplied comment text
  * ═══════════════════════════════════════════════════════════════════ */
-static void json_escape(const char *src, char *dst, int dst_len)
+void net_json_escape(const char *src, char *dst, int dst_len)
 {
     int di = 0;
     for (int i = 0; src[i] && di < dst_len - 3; i++) {
@@ -63,14 +69,17 @@ static void json_escape(const char *src, char *dst, int dst_len)
 }
 
 /* ── Low-level helpers ─────────────────────────────────────────────── */
+static int s_get_code;                         /* status of the last http_get */
+
 static char *http_get(const char *url)
 {
+    s_get_code = 0;
     if (WiFi.status() != WL_CONNECTED) return NULL;
     Serial.printf("[HTTP] GET: %s\n", url);
     http_safe_end();                          /* safety: end before begin */
     http.begin(url);
     http.setTimeout(NET_TIMEOUT_MS);
-    int code = http.GET();
+    int code = s_get_code = http.GET();
     Serial.printf("[HTTP] Code: %d\n", code);
     if (code != 200) { http.end(); return NULL; }
     String body = http.getString();
@@ -81,18 +90,50 @@ static char *http_get(const char *url)
     return buf;
 }
 
-static String http_post_str(const char *url, const char *body_json)
+/* ── Idempotent mutations ─────────────────────────────────────────────
+ * Operation id "t<table>-<boot epoch>-<seq>": unique per table, boot
+ * and request. Every attempt of one request sends the same id; the
+ * server stores the first reply under it and replays it for repeats,
+ * so a retry after a lost response is never a second order or ticket. */
+static uint32_t s_op_seq;
+
+void net_op_id_new(char *buf, int len)
 {
-    if (WiFi.status() != WL_CONNECTED) return "";
-    Serial.printf("[HTTP] POST: %s\n", url);
-    http_safe_end();                          /* safety */
-    http.begin(url);
-    http.setTimeout(NET_TIMEOUT_MS);
-    http.addHeader("Content-Type", "application/json");
-    int code = http.POST((uint8_t *)body_json, strlen(body_json));
-    Serial.printf("[HTTP] Code: %d\n", code);
-    String resp = (code == 200 || code == 201) ? http.getString() : "";
-    http.end();
+    snprintf(buf, len, "t%d-%lu-%lu", TABLE_NUMBER,
+             (unsigned long)session_store_boot_epoch(), (unsigned long)++s_op_seq);
+}
+
+/* Up to NET_OP_TRIES attempts of NET_OP_TIMEOUT_MS with doubling
+ * backoff. Transport errors and 5xx (incl. "in progress") retry; a 4xx
+ * is final. Returns the 200/201 body or "", and the last code.
+ * op_id = the caller's id for the logical operation, so a guest's
+ * second tap after all tries failed is still the same op; NULL mints
+ * one for this call only. */
+static String http_post_op(const char *url, const char *body_json,
+                           const char *op_id, int *code_out)
+{
+    char op[NET_OP_ID_LEN];
+    if (op_id && op_id[0]) snprintf(op, sizeof(op), "%s", op_id);
+    else                   net_op_id_new(op, sizeof(op));
+    String resp;
+    int code = -1;
+    uint32_t backoff = NET_OP_BACKOFF_MS;
+    for (int attempt = 1; attempt <= NET_OP_TRIES; attempt++) {
+        if (WiFi.status() != WL_CONNECTED) break;
+        http_safe_end();                      /* safety */
+        http.begin(url);
+        http.setConnectTimeout(NET_OP_TIMEOUT_MS);
+        http.setTimeout(NET_OP_TIMEOUT_MS);
+        http.addHeader("Content-Type", "application/json");
+        http.addHeader("X-Op-Id", op);
+        code = http.POST((uint8_t *)body_json, strlen(body_json));
+        Serial.printf("[HTTP] POST %s op %s try %d: %d\n", url, op, attempt, code);
+        if (code == 200 || code == 201) { resp = http.getString(); http.end(); break; }
+        http.end();
+        if (code >= 400 && code < 500) break;
+        if (attempt < NET_OP_TRIES) { delay(backoff); backoff *= 2; }
+    }
+    if (code_out) *code_out = code;
     return resp;
 }
 
@@ -120,10 +161,20 @@ char *net_fetch_menu(void)
  * cart_json must already be the full body with "table" and "items" keys.
  * Returns 0 on success, fills *out_order_id.
  */
-int net_place_order(const char *cart_json, int *out_order_id)
+int net_place_order(const char *cart_json, const char *cart_id, const char *op_id,
+                    int *out_order_id)
 {
     if (WiFi.status() != WL_CONNECTED) return -1;
-    String resp = http_post_str(SERVER_BASE_URL "/api/order", cart_json);
+    /* {"table":N,...} -> {"cart_id":"...","table":N,...} */
+    char *body = NULL;
+    if (cart_id && cart_json[0] == '{') {
+        size_t len = strlen(cart_json) + strlen(cart_id) + 16;
+        body = (char *)malloc(len);
+        if (!body) return -1;
+        snprintf(body, len, "{\"cart_id\":\"%s\",%s", cart_id, cart_json + 1);
+    }
+    String resp = http_post_op(SERVER_BASE_URL "/api/order", body ? body : cart_json, op_id, NULL);
+    free(body);
     if (resp.length() == 0) return -1;
     /* Parse {"ok":true,"order_id":N} with flexible spacing */
     const char *p = strstr(resp.c_str(), "\"order_id\"");
@@ -140,22 +191,70 @@ int net_place_order(const char *cart_json, int *out_order_id)
  * Server does NOT create a new order — it appends items to the existing one.
  * Returns 0 on success, -1 on failure.
  */
-int net_append_order(int order_id, const char *new_items_json)
+int net_append_order(int order_id, const char *new_items_json, const char *cart_id,
+                     const char *op_id)
 {
     if (WiFi.status() != WL_CONNECTED) return -1;
     /* new_items_json is the raw items JSON array string, e.g. [{"id":1,...}]
      * We wrap it into: {"order_id":X,"items":[...]}
-     * Maximum body size: 4096 bytes should be sufficient for any realistic cart */
-    char body[4096];
-    snprintf(body, sizeof(body),
-             "{\"order_id\":%d,\"items\":%s}",
-             order_id, new_items_json ? new_items_json : "[]");
-    String resp = http_post_str(SERVER_BASE_URL "/api/order/append", body);
+     * Sized from the input: a CART_HARD_CAP cart is far past the old
+     * 4096-byte stack buffer (and the net task stack). */
+    const char *items = new_items_json ? new_items_json : "[]";
+    size_t len  = strlen(items) + 40 + (cart_id ? strlen(cart_id) + 16 : 0);
+    char  *body = (char *)malloc(len);
+    if (!body) return -1;
+    int n = snprintf(body, len, "{\"order_id\":%d,", order_id);
+    if (cart_id) n += snprintf(body + n, len - n, "\"cart_id\":\"%s\",", cart_id);
+    snprintf(body + n, len - n, "\"items\":%s}", items);
+    String resp = http_post_op(SERVER_BASE_URL "/api/order/append", body, op_id, NULL);
+    free(body);
     if (resp.length() == 0) return -1;
     /* Server returns same order_id: {"ok":true,"order_id":X} */
     return 0;
 }
 
+/* ── Live cart ── POST /api/cart/delta, /api/order/commit ──────────────
+ * While the guest browses, +/- changes stream as small numbered batches;
+ * the order is then a commit of what the server already holds. */
+
+/* Returns 0 when applied (or a repeat), -2 when the server refused the
+ * batch (seq gap: live sync is over for this cart), -1 on transport. */
+int net_cart_delta(const char *json)
+{
+    int code = http_post(SERVER_BASE_URL "/api/cart/delta", json);
+    if (code == 200) return 0;
+    return code == 409 ? -2 : -1;
+}
+
+/* append_oid > 0 appends to that order. items / subtotal (rupees) are
+ * what the table believes the cart holds; the server checks them.
+ * Returns 0 and *out_order_id, -2 when the server cannot commit this
+ * cart (caller posts the full cart instead), -1 on transport. */
+int net_commit_cart(const char *cart_id, int seq, int append_oid,
+                    int items, int subtotal, const char *op_id, int *out_order_id)
+{
+    if (WiFi.status() != WL_CONNECTED) return -1;
+    char body[160];
+    int n = snprintf(body, sizeof(body),
+                     "{\"cart_id\":\"%s\",\"seq\":%d,\"items\":%d,\"subtotal\":%d",
+                     cart_id, seq, items, subtotal);
+    if (append_oid > 0)
+        n += snprintf(body + n, sizeof(body) - n, ",\"order_id\":%d", append_oid);
+    snprintf(body + n, sizeof(body) - n, "}");
+    int code;
+    String resp = http_post_op(SERVER_BASE_URL "/api/order/commit", body, op_id, &code);
+    if (code == 409 || code == 404) return -2;
+    if (resp.length() == 0) return -1;
+    const char *p = strstr(resp.c_str(), "\"order_id\"");
+    if (p && out_order_id) {
+        p = strchr(p, ':');
+        if (p) { p++; while (*p == ' ') p++; *out_order_id = atoi(p); }
+    }
+    Serial.printf("[ORDER] Committed cart %s seq %d -> order_id %d\n", cart_id, seq,
+                  out_order_id ? *out_order_id : -1);
+    return 0;
+}
+
 /* GET /api/order/status?order_id=N */
 void net_get_order_status(int order_id, char *out_buf, int buf_len)
 {
@@ -192,7 +291,9 @@ int net_food_served(int order_id)
 {
     char body[48];
     snprintf(body, sizeof(body), "{\"order_id\":%d}", order_id);
-    return http_post(SERVER_BASE_URL "/api/order/food-served", body) == 200 ? 0 : -1;
+    int code;
+    http_post_op(SERVER_BASE_URL "/api/order/food-served", body, NULL, &code);
+    return code == 200 ? 0 : -1;
 }
 
 /* POST /api/buzz  (waiter call = pattern 1) */
@@ -203,11 +304,14 @@ int net_call_waiter(int order_id)
                      "{\"pattern\":1}") == 200 ? 0 : -1;
 }
 
-/* ── Bill ── POST /api/order/bill  body: {"order_id":N} ────────────── */
-char *net_request_bill(int order_id)
+/* ── Bill ── POST /api/order/bill  body: {"order_id":N[,"preview":true]}
+ * preview = prefetch: the server returns the bill without moving the
+ * order to billing or notifying the kitchen. ─────────────────────────── */
+char *net_request_bill(int order_id, bool preview)
 {
-    char body[48];
-    snprintf(body, sizeof(body), "{\"order_id\":%d}", order_id);
+    char body[64];
+    snprintf(body, sizeof(body), "{\"order_id\":%d%s}", order_id,
+             preview ? ",\"preview\":true" : "");
     if (WiFi.status() != WL_CONNECTED) return NULL;
     http_safe_end();                          /* safety */
     http.begin(SERVER_BASE_URL "/api/order/bill");
@@ -222,23 +326,38 @@ char *net_request_bill(int order_id)
     return buf;
 }
 
-/* ── Payment ─────────────────────────────────────────────────────────── */
+/* ── Payment ─────────────────────────────────────────────────────────────
+ * seat >= 0 pays one split-bill group (shared = 0); seat < 0 the whole
+ * table, exactly as before seats existed. */
 
-/* POST /api/payment/method  body: {"order_id":N,"method":"..."} */
-int net_select_payment(int order_id, const char *method)
+/* ",\"seat\":N" for JSON bodies, "" for the whole table */
+static const char *seat_field(int seat, char *buf, int len)
 {
-    char body[96];
+    if (seat < 0) buf[0] = '\0';
+    else snprintf(buf, len, ",\"seat\":%d", seat);
+    return buf;
+}
+
+/* POST /api/payment/method  body: {"order_id":N,"method":"..."[,"seat":S]} */
+int net_select_payment(int order_id, int seat, const char *method)
+{
+    char body[112], sf[20];
     snprintf(body, sizeof(body),
-             "{\"order_id\":%d,\"method\":\"%s\"}", order_id, method);
+             "{\"order_id\":%d,\"method\":\"%s\"%s}", order_id, method,
+             seat_field(seat, sf, sizeof(sf)));
     return http_post(SERVER_BASE_URL "/api/payment/method", body) == 200 ? 0 : -1;
 }
 
-/* GET /api/payment/status?order_id=N */
-void net_get_payment_status(int order_id, char *out_buf, int buf_len)
+/* GET /api/payment/status?order_id=N[&seat=S] */
+void net_get_payment_status(int order_id, int seat, char *out_buf, int buf_len)
 {
     char url[160];
-    snprintf(url, sizeof(url),
-             SERVER_BASE_URL "/api/payment/status?order_id=%d", order_id);
+    if (seat < 0)
+        snprintf(url, sizeof(url),
+                 SERVER_BASE_URL "/api/payment/status?order_id=%d", order_id);
+    else
+        snprintf(url, sizeof(url),
+                 SERVER_BASE_URL "/api/payment/status?order_id=%d&seat=%d", order_id, seat);
     char *resp = http_get(url);
     if (resp) {
         const char *p = strstr(resp, "\"status\"");
@@ -263,14 +382,15 @@ void net_get_payment_status(int order_id, char *out_buf, int buf_len)
     }
 }
 
-/* POST /api/razorpay/create-order  body: {"order_id":N}
+/* POST /api/razorpay/create-order  body: {"order_id":N[,"seat":S][,"preview":true]}
  * Returns malloc'd JSON string with qr_url, amount_paise, plink_id.
- * Caller must free().
+ * Caller must free(). preview = prefetch: the method is not set yet.
  */
-char *net_create_razorpay_order(int order_id)
+char *net_create_razorpay_order(int order_id, int seat, bool preview)
 {
-    char body[48];
-    snprintf(body, sizeof(body), "{\"order_id\":%d}", order_id);
+    char body[80], sf[20];
+    snprintf(body, sizeof(body), "{\"order_id\":%d%s%s}", order_id,
+             seat_field(seat, sf, sizeof(sf)), preview ? ",\"preview\":true" : "");
     if (WiFi.status() != WL_CONNECTED) return NULL;
     http_safe_end();                          /* safety */
     http.begin(SERVER_BASE_URL "/api/razorpay/create-order");
@@ -285,13 +405,17 @@ char *net_create_razorpay_order(int order_id)
     return buf;
 }
 
-/* GET /api/razorpay/status/<order_id>
+/* GET /api/razorpay/status/<order_id>[?seat=S]
  * Polls Razorpay Payment Link status.
  * Writes "paid", "pending", or "error" into out_buf. */
-void net_get_razorpay_status(int order_id, char *out_buf, int buf_len)
+void net_get_razorpay_status(int order_id, int seat, char *out_buf, int buf_len)
 {
     char url[160];
-    snprintf(url, sizeof(url), SERVER_BASE_URL "/api/razorpay/status/%d", order_id);
+    if (seat < 0)
+        snprintf(url, sizeof(url), SERVER_BASE_URL "/api/razorpay/status/%d", order_id);
+    else
+        snprintf(url, sizeof(url), SERVER_BASE_URL "/api/razorpay/status/%d?seat=%d",
+                 order_id, seat);
     char *resp = http_get(url);
     if (resp) {
         const char *p = strstr(resp, "\"status\"");
@@ -313,13 +437,14 @@ void net_get_razorpay_status(int order_id, char *out_buf, int buf_len)
     } else strncpy(out_buf, "error", buf_len);
 }
 
-/* NEW: Returns the FULL JSON response from /api/order/status?order_id=N */
+/* NEW: Returns the FULL JSON response from /api/order/status?order_id=N
+ * 0 = ok, -2 = server has no such order, -1 = no answer */
 int net_get_order_json(int order_id, char *out_buf, int buf_len)
 {
     char url[160];
     snprintf(url, sizeof(url), SERVER_BASE_URL "/api/order/status?order_id=%d", order_id);
     char *resp = http_get(url);
-    if (!resp) return -1;
+    if (!resp) return s_get_code == 404 ? -2 : -1;
     
     strncpy(out_buf, resp, buf_len - 1);
     out_buf[buf_len - 1] = '\0';
@@ -331,10 +456,11 @@ int net_get_order_json(int order_id, char *out_buf, int buf_len)
  * Called when 5-minute UPI countdown expires without payment.
  * Returns 0 on success, -1 on failure.
  */
-int net_payment_timeout(int order_id)
+int net_payment_timeout(int order_id, int seat)
 {
-    char body[48];
-    snprintf(body, sizeof(body), "{\"order_id\":%d}", order_id);
+    char body[64], sf[20];
+    snprintf(body, sizeof(body), "{\"order_id\":%d%s}", order_id,
+             seat_field(seat, sf, sizeof(sf)));
     return http_post(SERVER_BASE_URL "/api/payment/timeout", body) == 200 ? 0 : -1;
 }
 
@@ -343,7 +469,7 @@ int net_submit_feedback(int order_id, int stars, const char *comment)
 {
     /* Bug 11 Fix: escape user-supplied comment to prevent JSON injection */
     char escaped[512];
-    json_escape(comment ? comment : "", escaped, sizeof(escaped));
+    net_json_escape(comment ? comment : "", escaped, sizeof(escaped));
 
     char body[640];
     snprintf(body, sizeof(body),
@@ -366,6 +492,12 @@ char *net_get_availability(void)
     return http_get(SERVER_BASE_URL "/api/menu/availability");
 }
 
+/* ── Trace ─ POST /api/trace  body: sm_trace_json() ──────────────────── */
+int net_post_trace(const char *json)
+{
+    return http_post(SERVER_BASE_URL "/api/trace", json) == 200 ? 0 : -1;
+}
+
 /* Logging bridge for C files */
 void net_log(const char *fmt, ...)
 {
@@ -15,30 +15,48 @@ bool net_is_wifi_ok(void);
 /* Menu */
 char *net_fetch_menu(void);
 
-/* Orders */
-int  net_place_order(const char *cart_json, int *out_order_id);
+/* Idempotent ops: one id per logical operation, reused on every retry
+ * ("t<table>-<boot epoch>-<seq>"; the epoch read may touch flash) */
+#define NET_OP_ID_LEN 40
+void net_op_id_new(char *buf, int len);
+
+/* Escape a string for a JSON "..." value (truncates to fit dst) */
+void net_json_escape(const char *src, char *dst, int dst_len);
+
+/* Orders (op_id: see above; NULL = a fresh id for this call).
+ * cart_id: live cart the server may still hold for this order, dropped
+ * once it is placed (NULL = none) */
+int  net_place_order(const char *cart_json, const char *cart_id, const char *op_id,
+                     int *out_order_id);
 int  net_food_served(int order_id);
 int  net_call_waiter(int order_id);
 void net_get_order_status(int order_id, char *out_buf, int buf_len);
-int  net_get_order_json(int order_id, char *out_buf, int buf_len);
+int  net_get_order_json(int order_id, char *out_buf, int buf_len);  /* -2 = unknown order */
 
 /* BUG 1 FIX: Append items to an existing order (append_mode flow) */
 /* POST /api/order/append  body: {"order_id":X,"items":[...]} */
-int  net_append_order(int order_id, const char *new_items_json);
+int  net_append_order(int order_id, const char *new_items_json, const char *cart_id,
+                      const char *op_id);
 
-/* Bill */
-char *net_request_bill(int order_id);
+/* Live cart (LIVE_CART_SYNC): delta batches, then commit as an order or
+ * an append (append_oid > 0). -2 = server refused: post the full cart. */
+int  net_cart_delta(const char *json);
+int  net_commit_cart(const char *cart_id, int seq, int append_oid,
+                     int items, int subtotal, const char *op_id, int *out_order_id);
 
-/* Payment */
-int   net_select_payment(int order_id, const char *method);
-void  net_get_payment_status(int order_id, char *out_buf, int buf_len);
-char *net_create_razorpay_order(int order_id);
+/* Bill. preview = prefetch: no status change / kitchen notify */
+char *net_request_bill(int order_id, bool preview);
+
+/* Payment — seat >= 0 pays one split-bill group, seat < 0 the whole table */
+int   net_select_payment(int order_id, int seat, const char *method);
+void  net_get_payment_status(int order_id, int seat, char *out_buf, int buf_len);
+char *net_create_razorpay_order(int order_id, int seat, bool preview);
 
 /* Poll Razorpay payment link status: GET /api/razorpay/status/<order_id> */
-void  net_get_razorpay_status(int order_id, char *out_buf, int buf_len);
+void  net_get_razorpay_status(int order_id, int seat, char *out_buf, int buf_len);
 
 /* NEW: report payment timeout to server */
-int   net_payment_timeout(int order_id);
+int   net_payment_timeout(int order_id, int seat);
 
 /* Logging / Delay wrappers (Bridging C and C++ Arduino funciones) */
 void net_log(const char *fmt, ...);
@@ -53,6 +71,9 @@ int net_buzz(int pattern);
 /* Availability */
 char *net_get_availability(void);
 
+/* State-machine trace batch (sm_trace_json body) */
+int net_post_trace(const char *json);
+
 #ifdef __cplusplus
 }
 #endif
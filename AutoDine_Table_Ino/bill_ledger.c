@@ -0,0 +1,143 @@
+/* =====================================================================
+ *  bill_ledger.c — AutoDine V4.0 local bill ledger
+ * ===================================================================== */
+#include "bill_ledger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void bill_ledger_reset(bill_ledger_t *l)
+{
+    l->count    = 0;
+    l->overflow = false;
+}
+
+const bill_line_t *bill_ledger_find(const bill_ledger_t *l, int id, int seat)
+{
+    for (int i = 0; i < l->count; i++)
+        if (l->lines[i].id == id && l->lines[i].seat == seat) return &l->lines[i];
+    return NULL;
+}
+
+bool bill_ledger_add(bill_ledger_t *l, int id, int seat, const char *name,
+                     int qty, int price)
+{
+    if (qty <= 0) return true;
+    if (seat < 0 || seat > CART_MAX_SEATS) seat = 0;
+    bill_line_t *ln = (bill_line_t *)bill_ledger_find(l, id, seat);
+    if (ln) {
+        ln->qty  += qty;
+        ln->price = price;          /* latest submission wins */
+        return true;
+    }
+    if (l->count >= BILL_LEDGER_MAX) { l->overflow = true; return false; }
+    ln = &l->lines[l->count++];
+    ln->id    = id;
+    ln->seat  = seat;
+    ln->qty   = qty;
+    ln->price = price;
+    snprintf(ln->name, sizeof(ln->name), "%s", name ? name : "");
+    return true;
+}
+
+int bill_ledger_subtotal(const bill_ledger_t *l)
+{
+    int sub = 0;
+    for (int i = 0; i < l->count; i++) sub += l->lines[i].qty * l->lines[i].price;
+    return sub;
+}
+
+int bill_ledger_diff(const bill_ledger_t *a, const bill_ledger_t *b)
+{
+    int n = 0;
+    for (int i = 0; i < a->count; i++) {
+        const bill_line_t *o = bill_ledger_find(b, a->lines[i].id, a->lines[i].seat);
+        if (!o || o->qty != a->lines[i].qty || o->price != a->lines[i].price) n++;
+    }
+    for (int i = 0; i < b->count; i++)
+        if (!bill_ledger_find(a, b->lines[i].id, b->lines[i].seat)) n++;
+    return n;
+}
+
+/* ---- Minimal JSON field readers, bounded to one flat object ---- */
+
+static const char *obj_end(const char *p)
+{
+    for (const char *c = p + 1; *c; c++) {
+        if (*c == '"') {
+            c++;
+            while (*c && *c != '"') { if (*c == '\\' && c[1]) c++; c++; }
+            if (!*c) return NULL;
+        } else if (*c == '}') {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+static const char *field(const char *p, const char *end, const char *key)
+{
+    size_t kl = strlen(key);
+    for (const char *c = p; c && c < end; c++) {
+        c = strchr(c, '"');
+        if (!c || c >= end) return NULL;
+        if (strncmp(c + 1, key, kl) == 0 && c[kl + 1] == '"') {
+            const char *v = strchr(c + kl + 2, ':');
+            if (!v || v >= end) return NULL;
+            v++;
+            while (*v == ' ') v++;
+            return v;
+        }
+    }
+    return NULL;
+}
+
+static int field_int(const char *p, const char *end, const char *key, int dflt)
+{
+    const char *v = field(p, end, key);
+    return v ? atoi(v) : dflt;
+}
+
+static void field_str(const char *p, const char *end, const char *key,
+                      char *out, int len)
+{
+    const char *v = field(p, end, key);
+    out[0] = '\0';
+    if (!v || *v != '"') return;
+    v++;
+    const char *q = strchr(v, '"');
+    if (!q || q > end) return;
+    int n = (int)(q - v);
+    if (n >= len) n = len - 1;
+    memcpy(out, v, n);
+    out[n] = '\0';
+}
+
+int bill_ledger_add_json(bill_ledger_t *l, const char *json)
+{
+    if (!json) return -1;
+    const char *p = strstr(json, "\"items\"");
+    p = strchr(p ? p : json, '[');
+    if (!p) return -1;
+
+    int n = 0;
+    while ((p = strchr(p, '{')) != NULL) {
+        const char *e = obj_end(p);
+        if (!e) break;
+        char name[CART_MAX_NAME];
+        /* Server rows carry their own doc "id"; the dish is "item_id" */
+        int id = field(p, e, "item_id") ? field_int(p, e, "item_id", 0)
+                                        : field_int(p, e, "id", 0);
+        field_str(p, e, "item_name", name, sizeof(name));
+        if (!name[0]) field_str(p, e, "name", name, sizeof(name));
+        bill_ledger_add(l, id, field_int(p, e, "seat", 0), name,
+                        field_int(p, e, "qty", 0), field_int(p, e, "price", 0));
+        n++;
+        /* The array ends before the next object of the outer document */
+        const char *close = strchr(e, ']');
+        const char *next  = strchr(e, '{');
+        if (!next || (close && close < next)) break;
+        p = e;
+    }
+    return n;
+}
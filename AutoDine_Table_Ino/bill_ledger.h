@@ -0,0 +1,59 @@
+#pragma once
+/* =====================================================================
+ *  bill_ledger.h — AutoDine V4.0 local bill ledger
+ *
+ *  Every item the table has successfully submitted (first order and
+ *  each "Add More") is folded into a ledger, keyed by (menu id, seat).
+ *  The bill screen renders from it the moment it opens; the server's
+ *  bill, parsed into a second ledger, then replaces it and any line
+ *  that differs (kitchen removed an item, price changed) is flagged.
+ *
+ *  The same parser reads both shapes: the order body we posted
+ *  ({"id","name","qty","price","seat"}) and the server bill
+ *  ({"item_id","item_name","qty","price","seat"}). Prices are rupees.
+ * ===================================================================== */
+#include "app_config.h"
+#include "cart.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int  id;                   /* menu item id (0 = unknown) */
+    int  seat;
+    int  qty;
+    int  price;                /* rupees per unit */
+    char name[CART_MAX_NAME];
+} bill_line_t;
+
+typedef struct {
+    int         count;
+    bool        overflow;      /* lines dropped: not usable as a bill */
+    bill_line_t lines[BILL_LEDGER_MAX];
+} bill_ledger_t;
+
+void bill_ledger_reset(bill_ledger_t *l);
+
+/* Fold one line in (qty adds up on the same id + seat) */
+bool bill_ledger_add(bill_ledger_t *l, int id, int seat, const char *name,
+                     int qty, int price);
+
+/* Fold in every object of the JSON's "items" array (or its first array
+ * when there is no "items" key). Returns lines read, -1 on bad input. */
+int  bill_ledger_add_json(bill_ledger_t *l, const char *json);
+
+const bill_line_t *bill_ledger_find(const bill_ledger_t *l, int id, int seat);
+
+/* Rupees, same rounding as the server: GST = floor(5%) of the subtotal */
+int  bill_ledger_subtotal(const bill_ledger_t *l);
+static inline int bill_ledger_gst(int subtotal) { return subtotal * 5 / 100; }
+
+/* Lines whose qty or price differ between a and b, plus lines only one
+ * side has */
+int  bill_ledger_diff(const bill_ledger_t *a, const bill_ledger_t *b);
+
+#ifdef __cplusplus
+}
+#endif
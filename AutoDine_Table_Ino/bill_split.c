@@ -0,0 +1,78 @@
+/* =====================================================================
+ *  bill_split.c — AutoDine V4.0 per-seat split bill
+ * ===================================================================== */
+#include "bill_split.h"
+#include <stdio.h>
+#include <string.h>
+
+void bill_split_reset(bill_split_t *b)
+{
+    memset(b, 0, sizeof(*b));
+}
+
+bill_seat_t *bill_split_seat(bill_split_t *b, int seat)
+{
+    for (int i = 0; i < b->count; i++)
+        if (b->seats[i].seat == seat) return &b->seats[i];
+    return NULL;
+}
+
+void bill_split_add(bill_split_t *b, int seat, int qty, int price)
+{
+    if (seat < 0 || seat > CART_MAX_SEATS) seat = 0;   /* unknown -> shared */
+    bill_seat_t *s = bill_split_seat(b, seat);
+    if (!s) {
+        /* Keep groups sorted by seat: insertion into at most 7 slots */
+        int i = b->count++;
+        while (i > 0 && b->seats[i - 1].seat > seat) {
+            b->seats[i] = b->seats[i - 1];
+            i--;
+        }
+        s = &b->seats[i];
+        memset(s, 0, sizeof(*s));
+        s->seat = seat;
+    }
+    s->subtotal += qty * price;
+}
+
+void bill_split_finish(bill_split_t *b)
+{
+    b->subtotal = 0;
+    for (int i = 0; i < b->count; i++) b->subtotal += b->seats[i].subtotal;
+    b->gst   = b->subtotal * 5 / 100;
+    b->total = b->subtotal + b->gst;
+
+    int left = b->gst;
+    for (int i = 0; i < b->count; i++) {
+        b->seats[i].gst = b->seats[i].subtotal * 5 / 100;
+        left -= b->seats[i].gst;
+    }
+    /* left < count always; hand out by largest remainder */
+    bool got[CART_MAX_SEATS + 1] = { false };
+    while (left-- > 0) {
+        int best = -1, best_rem = -1;
+        for (int i = 0; i < b->count; i++) {
+            int rem = b->seats[i].subtotal * 5 % 100;
+            if (!got[i] && rem > best_rem) { best = i; best_rem = rem; }
+        }
+        if (best < 0) break;
+        got[best] = true;
+        b->seats[best].gst++;
+    }
+    for (int i = 0; i < b->count; i++)
+        b->seats[i].total = b->seats[i].subtotal + b->seats[i].gst;
+}
+
+int bill_split_unpaid(const bill_split_t *b)
+{
+    int n = 0;
+    for (int i = 0; i < b->count; i++) n += !b->seats[i].paid;
+    return n;
+}
+
+const char *bill_seat_name(int seat, char *buf, int len)
+{
+    if (seat <= 0) snprintf(buf, len, "Shared");
+    else           snprintf(buf, len, "Seat %d", seat);
+    return buf;
+}
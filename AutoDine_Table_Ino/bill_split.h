@@ -0,0 +1,51 @@
+#pragma once
+/* =====================================================================
+ *  bill_split.h — AutoDine V4.0 per-seat split bill
+ *
+ *  Built from the bill's own item lines (each carries its "seat"), so
+ *  the bill screen shows the split without another request. Amounts are
+ *  whole rupees, like the server's bill. GST is charged on the table
+ *  subtotal (floor 5%) and shared out with the same rule the server
+ *  uses for per-seat payments (_bill_split in server.py):
+ *
+ *    seat GST = floor(seat subtotal * 5 / 100), then the rupees left
+ *    over go one each to the seats with the largest dropped fraction,
+ *    lower seat number first on ties.
+ *
+ *  So the seat totals always add up to the table total.
+ * ===================================================================== */
+#include "app_config.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BILL_SEAT_ALL   (-1)   /* pay / show the whole table */
+
+typedef struct {
+    int  seat;                 /* 0 = shared, 1..CART_MAX_SEATS */
+    int  subtotal, gst, total; /* rupees */
+    bool paid;
+} bill_seat_t;
+
+typedef struct {
+    int         count;         /* groups with items, ascending seat */
+    bill_seat_t seats[CART_MAX_SEATS + 1];
+    int         subtotal, gst, total;
+} bill_split_t;
+
+void bill_split_reset(bill_split_t *b);
+void bill_split_add(bill_split_t *b, int seat, int qty, int price);
+void bill_split_finish(bill_split_t *b);     /* allocate GST, fill totals */
+
+/* Group for seat, or NULL */
+bill_seat_t *bill_split_seat(bill_split_t *b, int seat);
+int  bill_split_unpaid(const bill_split_t *b);   /* groups not yet paid */
+
+/* "Seat 3" / "Shared" */
+const char *bill_seat_name(int seat, char *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,111 +7,262 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#ifdef ARDUINO
+#include "esp_heap_caps.h"
+#endif
 
-static cart_item_t s_items[CART_MAX_ITEMS];
-static int         s_count = 0;
+/* ---- Pool --------------------------------------------------
+ * Items live in fixed-size nodes carved from CART_CHUNK_ITEMS-node chunks
+ * (PSRAM when present). Chunks are only ever added, up to CART_HARD_CAP
+ * nodes; a removed or cleared item returns its node to the free list, so
+ * after the first large order the cart stops touching the heap at all. */
+typedef struct cart_node {
+    cart_item_t       item;       /* first: a cart_item_t * is its node  */
+    struct cart_node *prev;       /* insertion order (in the cart)       */
+    struct cart_node *next;       /* insertion order, or the free list   */
+} cart_node_t;
+
+#define CART_MAX_CHUNKS  ((CART_HARD_CAP + CART_CHUNK_ITEMS - 1) / CART_CHUNK_ITEMS)
+
+static cart_node_t *s_chunks[CART_MAX_CHUNKS];
+static int          s_chunk_count = 0;
+static cart_node_t *s_free = NULL;
+
+/* Display order (insertion order), what cart_first/cart_next walk. A
+ * removal unlinks one node, so nothing behind it moves or renumbers. */
+static cart_node_t *s_head = NULL, *s_tail = NULL;
+static int          s_count = 0;
+
+/* (id, seat) -> node index: open addressing, linear probing, no tombstones
+ * (deletes back-shift the probe run). Nodes never move, so only the
+ * removed item's bucket changes on delete. */
+#if   CART_HARD_CAP <= 32
+#define CART_INDEX_BITS  6
+#elif CART_HARD_CAP <= 64
+#define CART_INDEX_BITS  7
+#elif CART_HARD_CAP <= 128
+#define CART_INDEX_BITS  8
+#elif CART_HARD_CAP <= 256
+#define CART_INDEX_BITS  9
+#else
+#error "CART_HARD_CAP above 256: widen the index"
+#endif
+#define CART_INDEX_SIZE  (1u << CART_INDEX_BITS)   /* >= 2 * CART_HARD_CAP */
+static cart_node_t *s_index[CART_INDEX_SIZE];
+
+/* Running totals, maintained by add/remove so the UI can read them on
+ * every tap without rescanning the cart */
+static int         s_total_qty      = 0;
+static int         s_subtotal_paise = 0;
+static int         s_gst_paise      = 0;
+static int         s_seat_paise[CART_MAX_SEATS + 1];
+static int         s_seat = 0;          /* active seat for add/remove */
+
+static void *chunk_alloc(size_t sz)
+{
+#ifdef ARDUINO
+    void *p = heap_caps_malloc(sz, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p) return p;
+#endif
+    return malloc(sz);
+}
+
+static cart_node_t *node_get(void)
+{
+    if (!s_free) {
+        if (s_chunk_count >= CART_MAX_CHUNKS) return NULL;
+        int n = CART_HARD_CAP - s_chunk_count * CART_CHUNK_ITEMS;
+        if (n > CART_CHUNK_ITEMS) n = CART_CHUNK_ITEMS;
+        cart_node_t *c = (cart_node_t *)chunk_alloc(sizeof(cart_node_t) * n);
+        if (!c) return NULL;
+        s_chunks[s_chunk_count++] = c;
+        for (int i = n - 1; i >= 0; i--) { c[i].next = s_free; s_free = &c[i]; }
+    }
+    cart_node_t *nd = s_free;
+    s_free = nd->next;
+    return nd;
+}
+
+static void node_put(cart_node_t *nd)
+{
+    nd->next = s_free;
+    s_free = nd;
+}
+
+static inline uint32_t index_home(int id, int seat)
+{
+    uint32_t key = (uint32_t)id * (CART_MAX_SEATS + 1) + (uint32_t)seat;
+    return (key * 2654435761u) >> (32 - CART_INDEX_BITS);
+}
+
+/* Bucket holding (id, seat), or the empty bucket where it would go */
+static uint32_t index_find(int id, int seat)
+{
+    uint32_t b = index_home(id, seat);
+    while (s_index[b] && (s_index[b]->item.id != id || s_index[b]->item.seat != seat))
+        b = (b + 1) & (CART_INDEX_SIZE - 1);
+    return b;
+}
+
+static void index_erase(uint32_t b)
+{
+    uint32_t hole = b;
+    s_index[hole] = NULL;
+    for (;;) {
+        b = (b + 1) & (CART_INDEX_SIZE - 1);
+        if (!s_index[b]) return;
+        uint32_t home = index_home(s_index[b]->item.id, s_index[b]->item.seat);
+        /* Move back unless its home lies cyclically in (hole, b] */
+        if (((b - home) & (CART_INDEX_SIZE - 1)) >=
+            ((b - hole) & (CART_INDEX_SIZE - 1))) {
+            s_index[hole] = s_index[b];
+            s_index[b]    = NULL;
+            hole = b;
+        }
+    }
+}
+
+static inline void totals_add(int seat, int price_paise)
+{
+    s_seat_paise[seat] += price_paise;
+    s_subtotal_paise   += price_paise;
+    s_gst_paise = s_subtotal_paise * 5 / 100;   /* 5% GST, on the subtotal */
+}
 
 void cart_clear(void)
 {
-    memset(s_items, 0, sizeof(s_items));
+    for (cart_node_t *nd = s_head, *nx; nd; nd = nx) { nx = nd->next; node_put(nd); }
+    memset(s_index, 0, sizeof(s_index));
+    s_head = s_tail = NULL;
     s_count = 0;
+    s_total_qty = 0;
+    s_subtotal_paise = 0;
+    s_gst_paise = 0;
+    memset(s_seat_paise, 0, sizeof(s_seat_paise));
+    /* s_seat survives: a guest keeps their seat across orders */
 }
 
-void cart_add(int id, const char *name, int price_paise, bool is_veg)
+void cart_set_seat(int seat)
 {
-    /* Check if item already exists */
-    for (int i = 0; i < s_count; i++) {
-        if (s_items[i].id == id) {
-            s_items[i].qty++;
-            return;
-        }
+    if (seat >= 0 && seat <= CART_MAX_SEATS) s_seat = seat;
+}
+
+int cart_get_seat(void) { return s_seat; }
+
+bool cart_add(int id, const char *name, int price_paise, bool is_veg)
+{
+    uint32_t b = index_find(id, s_seat);
+    if (s_index[b]) {
+        cart_item_t *it = &s_index[b]->item;
+        it->qty++;
+        s_total_qty++;
+        totals_add(s_seat, it->price_paise);
+        return true;
     }
     /* New item */
-    if (s_count >= CART_MAX_ITEMS) {
-        return;
-    }
-    s_items[s_count].id          = id;
-    s_items[s_count].price_paise = price_paise;
-    s_items[s_count].is_veg      = is_veg;
-    s_items[s_count].qty         = 1;
-    strncpy(s_items[s_count].name, name, CART_MAX_NAME - 1);
-    s_items[s_count].name[CART_MAX_NAME - 1] = '\0';
+    cart_node_t *nd = s_count < CART_HARD_CAP ? node_get() : NULL;
+    if (!nd) return false;
+    nd->item.id          = id;
+    nd->item.price_paise = price_paise;
+    nd->item.is_veg      = is_veg;
+    nd->item.qty         = 1;
+    nd->item.seat        = (uint8_t)s_seat;
+    strncpy(nd->item.name, name, CART_MAX_NAME - 1);
+    nd->item.name[CART_MAX_NAME - 1] = '\0';
+    nd->prev = s_tail;
+    nd->next = NULL;
+    if (s_tail) s_tail->next = nd; else s_head = nd;
+    s_tail = nd;
     s_count++;
+    s_index[b] = nd;
+    s_total_qty++;
+    totals_add(s_seat, price_paise);
+    return true;
 }
 
 void cart_remove_one(int id)
 {
-    for (int i = 0; i < s_count; i++) {
-        if (s_items[i].id == id) {
-            s_items[i].qty--;
-            if (s_items[i].qty <= 0) {
-                /* Remove slot — shift left */
-                memmove(&s_items[i], &s_items[i+1],
-                        sizeof(cart_item_t) * (s_count - i - 1));
-                s_count--;
-            }
-            return;
-        }
-    }
+    uint32_t b = index_find(id, s_seat);
+    cart_node_t *nd = s_index[b];
+    if (!nd) return;
+
+    nd->item.qty--;
+    s_total_qty--;
+    totals_add(s_seat, -nd->item.price_paise);
+    if (nd->item.qty > 0) return;
+
+    /* Last unit: unlink it; its neighbours close the gap */
+    index_erase(b);
+    if (nd->prev) nd->prev->next = nd->next; else s_head = nd->next;
+    if (nd->next) nd->next->prev = nd->prev; else s_tail = nd->prev;
+    s_count--;
+    node_put(nd);
 }
 
-int cart_get_qty(int id)
+int cart_get_qty(int id) { return cart_get_qty_seat(id, s_seat); }
+
+int cart_get_qty_seat(int id, int seat)
 {
-    for (int i = 0; i < s_count; i++) {
-        if (s_items[i].id == id) return s_items[i].qty;
-    }
-    return 0;
+    if (seat < 0 || seat > CART_MAX_SEATS) return 0;
+    cart_node_t *nd = s_index[index_find(id, seat)];
+    return nd ? nd->item.qty : 0;
 }
 
-int cart_item_count(void)  { return s_count; }
-
-int cart_total_items(void)
+int cart_seat_subtotal_paise(int seat)
 {
-    int total = 0;
-    for (int i = 0; i < s_count; i++) total += s_items[i].qty;
-    return total;
+    return (seat >= 0 && seat <= CART_MAX_SEATS) ? s_seat_paise[seat] : 0;
 }
 
-int cart_subtotal_paise(void)
+const cart_item_t *cart_first(void)
 {
-    int total = 0;
-    for (int i = 0; i < s_count; i++) {
-        total += s_items[i].price_paise * s_items[i].qty;
-    }
-    return total;
+    return s_head ? &s_head->item : NULL;
 }
 
-int cart_gst_paise(void)
+const cart_item_t *cart_next(const cart_item_t *it)
 {
-    return cart_subtotal_paise() * 5 / 100;  /* 5% GST */
+    const cart_node_t *nd = it ? ((const cart_node_t *)it)->next : NULL;
+    return nd ? &nd->item : NULL;
 }
 
-int cart_grand_total_paise(void)
+size_t cart_pool_bytes(void)
 {
-    return cart_subtotal_paise() + cart_gst_paise();
+    size_t n = 0;
+    for (int c = 0; c < s_chunk_count; c++) {
+        int k = CART_HARD_CAP - c * CART_CHUNK_ITEMS;
+        n += sizeof(cart_node_t) * (k > CART_CHUNK_ITEMS ? CART_CHUNK_ITEMS : k);
+    }
+    return n;
 }
 
+int cart_item_count(void)  { return s_count; }
+
+int cart_total_items(void)       { return s_total_qty; }
+int cart_subtotal_paise(void)    { return s_subtotal_paise; }
+int cart_gst_paise(void)         { return s_gst_paise; }
+int cart_grand_total_paise(void) { return s_subtotal_paise + s_gst_paise; }
+
 char *cart_to_json(void)
 {
     /* D3 Fix: Ensure buffer is large enough for all item names + JSON overhead.
      * Old: buf_size = 256 + s_count * 120  (could overflow with long names)
      * New: buf_size = 256 + s_count * (CART_MAX_NAME + 80)
      */
-    size_t buf_size = 256 + (size_t)s_count * (CART_MAX_NAME + 80);
+    size_t buf_size = 256 + (size_t)s_count * (CART_MAX_NAME + 92);   /* + "seat" */
     char  *buf      = malloc(buf_size);
     if (!buf) return NULL;
 
     int offset = 0;
     offset += snprintf(buf + offset, buf_size - offset,
                        "{\"table\":%d,\"items\":[", TABLE_NUMBER);
-    for (int i = 0; i < s_count; i++) {
+    for (const cart_node_t *nd = s_head; nd; nd = nd->next) {
         offset += snprintf(buf + offset, buf_size - offset,
-                           "{\"id\":%d,\"name\":\"%s\",\"qty\":%d,\"price\":%d}%s",
-                           s_items[i].id,
-                           s_items[i].name,
-                           s_items[i].qty,
-                           s_items[i].price_paise / 100,
-                           (i < s_count - 1) ? "," : "");
+                           "{\"id\":%d,\"name\":\"%s\",\"qty\":%d,\"price\":%d,\"seat\":%d}%s",
+                           nd->item.id,
+                           nd->item.name,
+                           nd->item.qty,
+                           nd->item.price_paise / 100,
+                           nd->item.seat,
+                           nd->next ? "," : "");
     }
     offset += snprintf(buf + offset, buf_size - offset,
                        "],\"subtotal\":%d,\"gst\":%d,\"total\":%d}",
@@ -120,5 +271,3 @@ char *cart_to_json(void)
                        cart_grand_total_paise() / 100);
     return buf;
 }
-
-const cart_item_t *cart_get_items(void) { return s_items; }
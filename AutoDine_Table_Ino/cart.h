@@ -2,10 +2,11 @@
 /* =====================================================================
  *  cart.h — AutoDine V4.0 in-memory cart
  * ===================================================================== */
+#include "app_config.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-#define CART_MAX_ITEMS   32
 #define CART_MAX_NAME    64
 #define CART_MAX_DESC    128
 
@@ -15,10 +16,21 @@ typedef struct {
     int      price_paise;   /* price in paise (₹ × 100) */
     int      qty;
     bool     is_veg;
+    uint8_t  seat;          /* 0 = shared, 1..CART_MAX_SEATS */
 } cart_item_t;
 
+/* Seats: add/remove/get_qty act on the active seat, so the same dish
+ * can sit on two seats as two lines. The seat travels in cart_to_json
+ * and comes back on the bill for the split (bill_split.h). */
+void cart_set_seat(int seat);
+int  cart_get_seat(void);
+int  cart_get_qty_seat(int id, int seat);
+int  cart_seat_subtotal_paise(int seat);
+
 void cart_clear(void);
-void cart_add(int id, const char *name, int price_paise, bool is_veg);
+/* false if id is new and the cart already holds CART_HARD_CAP items
+ * (or the pool could not grow) */
+bool cart_add(int id, const char *name, int price_paise, bool is_veg);
 void cart_remove_one(int id);
 int  cart_get_qty(int id);
 int  cart_item_count(void);         /* unique items */
@@ -30,4 +42,11 @@ int  cart_grand_total_paise(void);
 /* Serialise cart to JSON string (caller must free) */
 char *cart_to_json(void);
 
-const cart_item_t *cart_get_items(void);
+/* Walk the items in order of first add: cart_first(), then cart_next()
+ * until NULL. Pointers stay valid until that item is removed or the cart
+ * cleared; removing the current item ends the walk. */
+const cart_item_t *cart_first(void);
+const cart_item_t *cart_next(const cart_item_t *it);
+
+/* Pool memory currently held (chunks are kept across cart_clear) */
+size_t cart_pool_bytes(void);
@@ -1,12 +1,36 @@
 /* hardware_compat.h — stub so ESP-IDF .c files compile in Arduino
  * Provides lvgl_acquire / lvgl_release declarations.
- * The actual implementations are in AutoDine_Table_Ino.ino (extern "C"). */
+ * The actual implementations are in AutoDine_Table_Ino.ino (extern "C").
+ *
+ * Tasks: LVGL runs in the UI task (UI_TASK_CORE), HTTP/WiFi in the net
+ * task (NET_TASK_CORE). They talk through two job queues:
+ *   ui_post()  — fn(arg) runs on the UI task, inside lvgl_acquire()
+ *   net_post() — fn(arg) runs on the net task, no LVGL lock held
+ * Both return false if the queue is full; the caller then still owns arg.
+ * LVGL callbacks must never block on HTTP — post a net job instead and
+ * hand the result back with ui_post(). */
 #pragma once
+#include <stdbool.h>
+#include "app_config.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
 void lvgl_acquire(void);
 void lvgl_release(void);
+
+typedef void (*task_job_fn)(void *arg);
+bool ui_post(task_job_fn fn, void *arg);
+bool net_post(task_job_fn fn, void *arg);
+
+#if LVGL_LOCK_DEBUG
+/* True if the calling task holds the LVGL mutex */
+bool lvgl_lock_held(void);
+void lvgl_lock_violation(const char *where);   /* logs, then aborts */
+#define LVGL_ASSERT_LOCKED() \
+    do { if (!lvgl_lock_held()) lvgl_lock_violation(__func__); } while (0)
+#else
+#define LVGL_ASSERT_LOCKED() ((void)0)
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,310 @@
+/* =====================================================================
+ *  menu_model.c — AutoDine V4.0 parsed menu store
+ * ===================================================================== */
+#include "menu_model.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define MENU_GROW_STEP  32   /* items added per realloc */
+
+static menu_item_t *s_items = NULL;
+static int          s_count = 0;
+static int          s_cap   = 0;
+static uint32_t     s_rev   = 0;
+
+/* id -> index open-addressing table (linear probing, -1 = empty) */
+static int16_t     *s_index      = NULL;
+static int          s_index_size = 0;   /* power of two, >= 2 * s_count */
+
+static const char *find_obj_end(const char *start)
+{
+    int depth = 0;
+    for (const char *c = start; *c; c++) {
+        if (*c == '"') {
+            c++;
+            while (*c && *c != '"') { if (*c == '\\') c++; c++; }
+            if (!*c) return NULL;
+        } else if (*c == '{') {
+            depth++;
+        } else if (*c == '}') {
+            depth--;
+            if (depth == 0) return c;
+        }
+    }
+    return NULL;
+}
+
+/* Copy the string value of "key" found between p and obj_end into out */
+static void json_str_field(const char *p, const char *obj_end, const char *key,
+                           char *out, int out_len)
+{
+    const char *f = strstr(p, key);
+    if (!f || f >= obj_end) return;
+    f = strchr(f, ':');
+    if (!f) return;
+    f++; while (*f == ' ' || *f == '"') f++;
+    const char *q = strchr(f, '"');
+    if (q && q < obj_end) {
+        int l = (int)(q - f); if (l >= out_len) l = out_len - 1;
+        memcpy(out, f, l); out[l] = 0;
+    }
+}
+
+static bool json_bool_field(const char *p, const char *obj_end, const char *key,
+                            bool dflt)
+{
+    const char *f = strstr(p, key);
+    if (!f || f >= obj_end) return dflt;
+    f = strchr(f, ':');
+    if (!f) return dflt;
+    f++; while (*f == ' ') f++;
+    return (*f == 't' || *f == '1');
+}
+
+static int json_int_field(const char *p, const char *obj_end, const char *key)
+{
+    const char *f = strstr(p, key);
+    if (!f || f >= obj_end) return 0;
+    f = strchr(f, ':');
+    if (!f) return 0;
+    f++; while (*f == ' ') f++;
+    return atoi(f);
+}
+
+static inline unsigned id_hash(int id) { return (unsigned)id * 2654435761u; }
+
+static void index_rebuild(void)
+{
+    int want = 16;
+    while (want < s_count * 2) want <<= 1;
+    if (want != s_index_size) {
+        int16_t *n = realloc(s_index, sizeof(int16_t) * want);
+        if (!n) { free(s_index); s_index = NULL; s_index_size = 0; return; }
+        s_index      = n;
+        s_index_size = want;
+    }
+    memset(s_index, 0xFF, sizeof(int16_t) * s_index_size);
+    for (int i = 0; i < s_count; i++) {
+        unsigned h = id_hash(s_items[i].id) & (s_index_size - 1);
+        while (s_index[h] >= 0) h = (h + 1) & (s_index_size - 1);
+        s_index[h] = (int16_t)i;
+    }
+}
+
+int menu_model_find(int id)
+{
+    if (!s_index) {
+        for (int i = 0; i < s_count; i++) if (s_items[i].id == id) return i;
+        return -1;
+    }
+    unsigned h = id_hash(id) & (s_index_size - 1);
+    while (s_index[h] >= 0) {
+        if (s_items[s_index[h]].id == id) return s_index[h];
+        h = (h + 1) & (s_index_size - 1);
+    }
+    return -1;
+}
+
+void menu_model_clear(void)
+{
+    s_count = 0;
+    index_rebuild();
+}
+
+static bool items_reserve(menu_item_t **arr, int *cap, int need)
+{
+    if (need <= *cap) return true;
+    int ncap = *cap + MENU_GROW_STEP;
+    while (ncap < need) ncap += MENU_GROW_STEP;
+    menu_item_t *n = realloc(*arr, sizeof(menu_item_t) * ncap);
+    if (!n) return false;
+    *arr = n;
+    *cap = ncap;
+    return true;
+}
+
+bool menu_model_append(const menu_item_t *item)
+{
+    if (!items_reserve(&s_items, &s_cap, s_count + 1)) return false;
+    s_items[s_count] = *item;
+    s_items[s_count].rev = ++s_rev;
+    s_count++;
+    index_rebuild();
+    return true;
+}
+
+/* Parse every item object in menu_json into *arr (grown as needed) */
+static int parse_items(const char *menu_json, menu_item_t **arr, int *cap)
+{
+    int count = 0;
+    const char *p = menu_json;
+    while ((p = strchr(p, '{')) != NULL) {
+        const char *obj_end = find_obj_end(p);
+        if (!obj_end) break;
+
+        menu_item_t it;
+        memset(&it, 0, sizeof(it));
+        strcpy(it.cat, "Main Course");
+        it.id          = json_int_field(p, obj_end, "\"id\"");
+        it.price_paise = json_int_field(p, obj_end, "\"price\"") * 100;
+        json_str_field(p, obj_end, "\"name\"",        it.name, sizeof(it.name));
+        json_str_field(p, obj_end, "\"description\"", it.desc, sizeof(it.desc));
+        json_str_field(p, obj_end, "\"category\"",    it.cat,  sizeof(it.cat));
+        it.is_veg    = json_bool_field(p, obj_end, "\"is_veg\"",    true);
+        it.available = json_bool_field(p, obj_end, "\"available\"", true);
+
+        if (it.id > 0 && it.name[0]) {
+            if (!items_reserve(arr, cap, count + 1)) break;
+            (*arr)[count++] = it;
+        }
+        p = obj_end + 1;
+    }
+    return count;
+}
+
+int menu_model_parse(const char *menu_json)
+{
+    s_count = 0;
+    if (menu_json) s_count = parse_items(menu_json, &s_items, &s_cap);
+    for (int i = 0; i < s_count; i++) s_items[i].rev = ++s_rev;
+    index_rebuild();
+    return s_count;
+}
+
+static bool item_fields_equal(const menu_item_t *a, const menu_item_t *b)
+{
+    return a->price_paise == b->price_paise &&
+           a->is_veg      == b->is_veg      &&
+           a->available   == b->available   &&
+           strcmp(a->name, b->name) == 0    &&
+           strcmp(a->desc, b->desc) == 0    &&
+           strcmp(a->cat,  b->cat)  == 0;
+}
+
+/* Diff fresh[0..n) against the model and take it over if anything changed */
+static unsigned apply_items(menu_item_t *fresh, int n)
+{
+    unsigned flags = (n != s_count) ? MENU_DIFF_LAYOUT : MENU_DIFF_NONE;
+
+    for (int i = 0; i < n; i++) {
+        int old = menu_model_find(fresh[i].id);
+        if (old < 0) { flags |= MENU_DIFF_LAYOUT; fresh[i].rev = ++s_rev; continue; }
+        if (old != i || strcmp(s_items[old].cat, fresh[i].cat) != 0)
+            flags |= MENU_DIFF_LAYOUT;
+        if (item_fields_equal(&s_items[old], &fresh[i])) {
+            fresh[i].rev = s_items[old].rev;
+        } else {
+            fresh[i].rev = ++s_rev;
+            flags |= MENU_DIFF_ITEMS;
+        }
+    }
+    if (flags == MENU_DIFF_NONE) return flags;
+
+    if (!items_reserve(&s_items, &s_cap, n)) return MENU_DIFF_NONE;
+    memcpy(s_items, fresh, sizeof(menu_item_t) * n);
+    s_count = n;
+    if (flags & MENU_DIFF_LAYOUT) index_rebuild();
+    return flags;
+}
+
+unsigned menu_model_apply(const char *menu_json)
+{
+    static menu_item_t *fresh = NULL;   /* scratch, kept between calls */
+    static int          fresh_cap = 0;
+    if (!menu_json) return MENU_DIFF_NONE;
+    return apply_items(fresh, parse_items(menu_json, &fresh, &fresh_cap));
+}
+
+menu_parsed_t *menu_parsed_new(const char *menu_json)
+{
+    if (!menu_json) return NULL;
+    menu_parsed_t *m = calloc(1, sizeof(*m));
+    if (!m) return NULL;
+    int cap = 0;
+    m->count = parse_items(menu_json, &m->items, &cap);
+    return m;
+}
+
+void menu_parsed_free(menu_parsed_t *m)
+{
+    if (!m) return;
+    free(m->items);
+    free(m);
+}
+
+int menu_model_adopt(menu_parsed_t *m)
+{
+    if (!m) return s_count;
+    free(s_items);
+    s_items = m->items;
+    s_count = s_cap = m->count;
+    free(m);
+    for (int i = 0; i < s_count; i++) s_items[i].rev = ++s_rev;
+    index_rebuild();
+    return s_count;
+}
+
+unsigned menu_model_apply_parsed(menu_parsed_t *m)
+{
+    return m ? apply_items(m->items, m->count) : MENU_DIFF_NONE;
+}
+
+bool menu_model_set_available(int id, bool available)
+{
+    int i = menu_model_find(id);
+    if (i < 0 || s_items[i].available == available) return false;
+    s_items[i].available = available;
+    s_items[i].rev       = ++s_rev;
+    return true;
+}
+
+menu_avail_t *menu_avail_new(const char *avail_json)
+{
+    const char *p = avail_json;
+    if (!p) return NULL;
+    int keys = 0;                       /* upper bound: two quotes per key */
+    for (const char *c = p; *c; c++) if (*c == '"') keys++;
+    menu_avail_t *a = malloc(sizeof(*a) + sizeof(menu_avail_entry_t) * (keys / 2 + 1));
+    if (!a) return NULL;
+    a->count = 0;
+    /* {"<id>": true, ...} — keys are quoted ids, values bare booleans */
+    while ((p = strchr(p, '"')) != NULL) {
+        int id = atoi(p + 1);
+        p = strchr(p + 1, '"');
+        if (!p) break;
+        p = strchr(p, ':');
+        if (!p) break;
+        p++; while (*p == ' ') p++;
+        if (id > 0) {
+            a->e[a->count].id        = id;
+            a->e[a->count].available = (*p == 't' || *p == '1');
+            a->count++;
+        }
+    }
+    return a;
+}
+
+int menu_model_apply_avail(const menu_avail_t *a)
+{
+    int changed = 0;
+    for (int i = 0; a && i < a->count; i++)
+        if (menu_model_set_available(a->e[i].id, a->e[i].available)) changed++;
+    return changed;
+}
+
+int menu_model_apply_availability(const char *avail_json)
+{
+    menu_avail_t *a = menu_avail_new(avail_json);
+    int changed = menu_model_apply_avail(a);
+    free(a);
+    return changed;
+}
+
+int menu_model_count(void) { return s_count; }
+
+const menu_item_t *menu_model_get(int idx)
+{
+    if (idx < 0 || idx >= s_count) return NULL;
+    return &s_items[idx];
+}
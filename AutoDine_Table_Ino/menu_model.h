@@ -0,0 +1,84 @@
+#pragma once
+/* =====================================================================
+ *  menu_model.h — AutoDine V4.0 parsed menu store
+ *
+ *  Holds the menu as flat data so the UI can bind a small pool of
+ *  card widgets to it (virtualized grid) instead of creating LVGL
+ *  objects for every dish.
+ * ===================================================================== */
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MENU_MAX_NAME   64
+#define MENU_MAX_DESC   128
+#define MENU_MAX_CAT    64
+
+typedef struct {
+    int      id;
+    char     name[MENU_MAX_NAME];
+    char     desc[MENU_MAX_DESC];
+    char     cat[MENU_MAX_CAT];
+    int      price_paise;   /* price in paise (₹ × 100) */
+    bool     is_veg;
+    bool     available;
+    uint32_t rev;           /* bumped on every change; views compare it */
+} menu_item_t;
+
+/* menu_model_apply() result flags */
+#define MENU_DIFF_NONE     0x00
+#define MENU_DIFF_ITEMS    0x01   /* fields of existing items changed   */
+#define MENU_DIFF_LAYOUT   0x02   /* items added/removed/re-ordered     */
+
+void menu_model_clear(void);
+
+/* Replace the model with the items in a GET /api/menu response.
+ * Returns the number of items parsed. */
+int  menu_model_parse(const char *menu_json);
+
+/* Diff a fresh GET /api/menu response against the model by item id.
+ * Changed items get a new rev; returns MENU_DIFF_* flags. */
+unsigned menu_model_apply(const char *menu_json);
+
+/* Apply a GET /api/menu/availability payload ({"<id>":true,...}).
+ * Returns the number of items whose availability flipped. */
+int  menu_model_apply_availability(const char *avail_json);
+
+/* ---- Parse off the UI task, apply on it ----
+ * The string parse is the slow part of a menu refresh. menu_parsed_new()
+ * and menu_avail_new() touch no model state, so the net task runs them
+ * and ui_post()s the result; the calls below apply it on the UI task. */
+typedef struct {
+    menu_item_t *items;
+    int          count;
+} menu_parsed_t;
+
+typedef struct {
+    int id;
+    bool available;
+} menu_avail_entry_t;
+
+typedef struct {
+    int                count;
+    menu_avail_entry_t e[];
+} menu_avail_t;
+
+menu_parsed_t *menu_parsed_new(const char *menu_json);   /* NULL on OOM */
+void           menu_parsed_free(menu_parsed_t *m);
+menu_avail_t  *menu_avail_new(const char *avail_json);   /* free() it */
+
+/* Replace the model with m's items; takes m over (frees it). Returns count. */
+int      menu_model_adopt(menu_parsed_t *m);
+/* menu_model_apply() for an already parsed menu; m stays the caller's */
+unsigned menu_model_apply_parsed(menu_parsed_t *m);
+/* Returns the number of items whose availability flipped */
+int      menu_model_apply_avail(const menu_avail_t *a);
+
+/* Set one item's availability. Returns true if it changed. */
+bool menu_model_set_available(int id, bool available);
+
+/* Append one item (used by ui_add_menu_card). Returns false if out of memory. */
+bool menu_model_append(const menu_item_t *item);
+
+int                menu_model_count(void);
+const menu_item_t *menu_model_get(int idx);
+int                menu_model_find(int id);   /* index or -1 */
@@ -0,0 +1,126 @@
+/* =====================================================================
+ *  perf_monitor.c — AutoDine V4.0 on-device frame profiler
+ * ===================================================================== */
+#include "perf_monitor.h"
+
+#if AUTODINE_PROFILE
+
+#include "autodine_net.h"
+#include <stdio.h>
+
+#ifdef ARDUINO
+#include "esp_heap_caps.h"
+extern unsigned long micros(void);
+#define PERF_HEAP_INT()    heap_caps_get_free_size(MALLOC_CAP_INTERNAL)
+#define PERF_HEAP_PSRAM()  heap_caps_get_free_size(MALLOC_CAP_SPIRAM)
+#else
+static unsigned long micros(void) { return 0; }
+#define PERF_HEAP_INT()    0
+#define PERF_HEAP_PSRAM()  0
+#endif
+
+/* Accumulators for the current period; cleared by perf_tick() */
+static uint32_t s_period_start_us = 0;
+static uint32_t s_lvgl_us   = 0;   /* lv_timer_handler (includes flush) */
+static uint32_t s_flush_us  = 0;   /* inside flush_cb                   */
+static uint32_t s_render_ms = 0;   /* monitor_cb: refresh time          */
+static uint32_t s_frames    = 0;
+static uint32_t s_px        = 0;   /* pixels refreshed                  */
+static uint32_t s_area_max  = 0;   /* largest single flushed area (px)  */
+static uint32_t s_loops     = 0;
+static uint32_t s_gap_max   = 0;   /* longest loop-to-loop gap (us)     */
+static uint32_t s_last_loop_us = 0;
+
+static lv_obj_t *s_overlay  = NULL;
+
+void perf_init(void)
+{
+    s_period_start_us = s_last_loop_us = (uint32_t)micros();
+
+    s_overlay = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_color(s_overlay, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(s_overlay, LV_OPA_70, 0);
+    lv_obj_set_style_text_color(s_overlay, lv_color_hex(0x10B981), 0);
+    lv_obj_set_style_text_font(s_overlay, &lv_font_montserrat_10, 0);
+    lv_obj_set_style_pad_all(s_overlay, 3, 0);
+    lv_obj_align(s_overlay, LV_ALIGN_BOTTOM_LEFT, 2, -2);
+    lv_label_set_text(s_overlay, "perf");
+    if (!PERF_OVERLAY_DEFAULT) lv_obj_add_flag(s_overlay, LV_OBJ_FLAG_HIDDEN);
+}
+
+void perf_loop_mark(void)
+{
+    uint32_t now = (uint32_t)micros();
+    uint32_t gap = now - s_last_loop_us;
+    if (gap > s_gap_max) s_gap_max = gap;
+    s_last_loop_us = now;
+    s_loops++;
+}
+
+void perf_lvgl_time(uint32_t us)
+{
+    s_lvgl_us += us;
+}
+
+void perf_flush(uint32_t us, uint32_t px)
+{
+    s_flush_us += us;
+    if (px > s_area_max) s_area_max = px;
+}
+
+void perf_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+    (void)drv;
+    s_frames++;
+    s_render_ms += time_ms;
+    s_px        += px;
+}
+
+void perf_overlay_toggle(void)
+{
+    if (!s_overlay) return;
+    if (lv_obj_has_flag(s_overlay, LV_OBJ_FLAG_HIDDEN))
+        lv_obj_clear_flag(s_overlay, LV_OBJ_FLAG_HIDDEN);
+    else
+        lv_obj_add_flag(s_overlay, LV_OBJ_FLAG_HIDDEN);
+}
+
+void perf_tick(void)
+{
+    uint32_t now = (uint32_t)micros();
+    uint32_t dt  = now - s_period_start_us;
+    if (dt < (uint32_t)PERF_REPORT_MS * 1000u) return;
+
+    uint32_t ms     = dt / 1000;
+    uint32_t fps10  = s_frames * 10000u / ms;                       /* x10 */
+    uint32_t cpu    = (uint32_t)((uint64_t)s_lvgl_us  * 100 / dt);  /* %   */
+    uint32_t flush  = (uint32_t)((uint64_t)s_flush_us * 100 / dt);  /* %   */
+    uint32_t rend   = s_frames ? s_render_ms / s_frames : 0;        /* ms  */
+    uint32_t pxf    = s_frames ? s_px / s_frames : 0;
+    uint32_t kb_int = (uint32_t)(PERF_HEAP_INT()   / 1024);
+    uint32_t kb_ps  = (uint32_t)(PERF_HEAP_PSRAM() / 1024);
+
+    /* Compact record: one line per period, key=value for easy grepping */
+    net_log("[PERF] fps=%lu.%lu cpu=%lu%% flush=%lu%% rend=%lums px/f=%lu "
+            "amax=%lu loops=%lu gap=%lums heap=%luK psram=%luK\n",
+            (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10),
+            (unsigned long)cpu, (unsigned long)flush, (unsigned long)rend,
+            (unsigned long)pxf, (unsigned long)s_area_max,
+            (unsigned long)s_loops, (unsigned long)(s_gap_max / 1000),
+            (unsigned long)kb_int, (unsigned long)kb_ps);
+
+    if (s_overlay && !lv_obj_has_flag(s_overlay, LV_OBJ_FLAG_HIDDEN)) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "%lu.%lu fps  cpu %lu%%  gap %lums\nheap %luK  psram %luK",
+                 (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10),
+                 (unsigned long)cpu, (unsigned long)(s_gap_max / 1000),
+                 (unsigned long)kb_int, (unsigned long)kb_ps);
+        lv_label_set_text(s_overlay, buf);
+    }
+
+    s_period_start_us = now;
+    s_lvgl_us = s_flush_us = s_render_ms = 0;
+    s_frames = s_px = s_area_max = s_loops = s_gap_max = 0;
+}
+
+#endif /* AUTODINE_PROFILE */
@@ -0,0 +1,53 @@
+#pragma once
+/* =====================================================================
+ *  perf_monitor.h — AutoDine V4.0 on-device frame profiler
+ *
+ *  Splits each second of UI-task time into LVGL work, panel flush and
+ *  idle/lock wait, and tracks dirty-area sizes and the longest gap
+ *  between UI task passes. Shown as a small overlay on
+ *  lv_layer_top() and streamed as one "[PERF]" line per period.
+ *
+ *  Enabled with AUTODINE_PROFILE in app_config.h. With 0 every PERF_*
+ *  macro expands to nothing and perf_monitor.c compiles to an empty unit.
+ * ===================================================================== */
+#include "app_config.h"
+#include "lvgl.h"
+#include <stdint.h>
+
+#if AUTODINE_PROFILE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void perf_init(void);                          /* inside lvgl_acquire   */
+void perf_loop_mark(void);                     /* top of each UI pass   */
+void perf_lvgl_time(uint32_t us);              /* lv_timer_handler cost */
+void perf_flush(uint32_t us, uint32_t px);     /* one flush_cb call     */
+void perf_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px);
+void perf_tick(void);                          /* inside lvgl_acquire   */
+void perf_overlay_toggle(void);                /* inside lvgl_acquire   */
+
+#ifdef __cplusplus
+}
+#endif
+
+#define PERF_INIT()              perf_init()
+#define PERF_MONITOR(drv, ms, px) perf_monitor_cb((drv), (ms), (px))
+#define PERF_LOOP_MARK()         perf_loop_mark()
+#define PERF_LVGL(us)            perf_lvgl_time(us)
+#define PERF_FLUSH(us, px)       perf_flush((us), (px))
+#define PERF_TICK()              perf_tick()
+#define PERF_OVERLAY_TOGGLE()    perf_overlay_toggle()
+
+#else
+
+#define PERF_INIT()              ((void)0)
+#define PERF_MONITOR(drv, ms, px) ((void)0)
+#define PERF_LOOP_MARK()         ((void)0)
+#define PERF_LVGL(us)            ((void)0)
+#define PERF_FLUSH(us, px)       ((void)0)
+#define PERF_TICK()              ((void)0)
+#define PERF_OVERLAY_TOGGLE()    ((void)0)
+
+#endif
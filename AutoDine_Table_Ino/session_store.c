@@ -0,0 +1,107 @@
+/* =====================================================================
+ *  session_store.c — AutoDine V4.0 crash-safe session snapshot
+ * ===================================================================== */
+#include "session_store.h"
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define CART_OFFSET  offsetof(session_snapshot_t, cart)
+
+int session_snapshot_size(const session_snapshot_t *s)
+{
+    int n = s->cart_count <= CART_HARD_CAP ? s->cart_count : CART_HARD_CAP;
+    return (int)(CART_OFFSET + (size_t)n * sizeof(session_cart_line_t));
+}
+
+/* A blob is only trusted if its length matches what its own header
+ * says: catches a layout change (CART_MAX_SEATS, new field) that kept
+ * SESSION_VERSION by mistake. */
+static bool snapshot_valid(const session_snapshot_t *s, size_t len)
+{
+    return len >= CART_OFFSET && s->version == SESSION_VERSION &&
+           s->cart_count <= CART_HARD_CAP &&
+           len == (size_t)session_snapshot_size(s);
+}
+
+#ifdef ARDUINO
+/* ---- ESP32: NVS (initialised by the Arduino core before setup) ---- */
+#include "nvs.h"
+#include "esp_system.h"
+
+#define NVS_NS    "autodine"
+#define NVS_KEY   "session"
+#define NVS_EPOCH "epoch"
+
+int session_store_save(const session_snapshot_t *s)
+{
+    nvs_handle_t h;
+    if (nvs_open(NVS_NS, NVS_READWRITE, &h) != ESP_OK) return -1;
+    esp_err_t err = nvs_set_blob(h, NVS_KEY, s, session_snapshot_size(s));
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+    return err == ESP_OK ? 0 : -1;
+}
+
+void session_store_clear(void)
+{
+    nvs_handle_t h;
+    if (nvs_open(NVS_NS, NVS_READWRITE, &h) != ESP_OK) return;
+    if (nvs_erase_key(h, NVS_KEY) == ESP_OK) nvs_commit(h);
+    nvs_close(h);
+}
+
+bool session_store_load(session_snapshot_t *out)
+{
+    nvs_handle_t h;
+    if (nvs_open(NVS_NS, NVS_READONLY, &h) != ESP_OK) return false;
+    size_t len = sizeof(*out);
+    esp_err_t err = nvs_get_blob(h, NVS_KEY, out, &len);
+    nvs_close(h);
+    return err == ESP_OK && snapshot_valid(out, len);
+}
+
+uint32_t session_store_boot_epoch(void)
+{
+    static uint32_t epoch;
+    if (epoch) return epoch;
+    nvs_handle_t h;
+    if (nvs_open(NVS_NS, NVS_READWRITE, &h) == ESP_OK) {
+        nvs_get_u32(h, NVS_EPOCH, &epoch);       /* stays 0 on first boot */
+        if (nvs_set_u32(h, NVS_EPOCH, epoch + 1) == ESP_OK) nvs_commit(h);
+        nvs_close(h);
+        epoch++;
+    } else {
+        epoch = esp_random() | 0x80000000u;      /* no NVS: random, not 0 */
+    }
+    return epoch;
+}
+
+#else
+/* ---- Host: RAM only, lost with the process ---- */
+static session_snapshot_t s_blob;
+static size_t             s_blob_len;
+
+int session_store_save(const session_snapshot_t *s)
+{
+    s_blob_len = (size_t)session_snapshot_size(s);
+    memcpy(&s_blob, s, s_blob_len);
+    return 0;
+}
+
+void session_store_clear(void) { s_blob_len = 0; }
+
+uint32_t session_store_boot_epoch(void)
+{
+    static uint32_t epoch;
+    if (!epoch) epoch = (uint32_t)time(NULL);
+    return epoch;
+}
+
+bool session_store_load(session_snapshot_t *out)
+{
+    if (s_blob_len == 0) return false;
+    memcpy(out, &s_blob, s_blob_len);
+    return snapshot_valid(out, s_blob_len);
+}
+#endif
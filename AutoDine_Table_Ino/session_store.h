@@ -0,0 +1,68 @@
+#pragma once
+/* =====================================================================
+ *  session_store.h — AutoDine V4.0 crash-safe session snapshot
+ *
+ *  The table's session (screen, order id, append mode, split-bill
+ *  progress and the not-yet-ordered cart) is written to NVS as one
+ *  small blob so a brown-out or watchdog reset lands the guest back on
+ *  the same screen instead of the splash.
+ *
+ *  NVS is log-structured: a blob update appends new entries and
+ *  retires the old ones, spreading wear over the partition by itself.
+ *  The caller only writes when the snapshot bytes actually changed,
+ *  and only the used part of the cart is stored.
+ *
+ *  Host builds (AutoDine_Table_Sim) keep the blob in RAM.
+ * ===================================================================== */
+#include "app_config.h"
+#include "bill_split.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SESSION_VERSION  2      /* 2: cart lines carry full int id / qty */
+
+/* Same ranges as cart_item_t: a resumed cart is the cart that was built */
+typedef struct {
+    int32_t  id;
+    int32_t  qty;
+    uint8_t  seat;
+    uint8_t  pad[3];
+} session_cart_line_t;
+
+typedef struct {
+    uint16_t     version;
+    uint8_t      state;           /* app_state_t                      */
+    uint8_t      append_mode;
+    int32_t      order_id;
+    int32_t      pay_seat;        /* BILL_SEAT_ALL or a seat          */
+    int32_t      bill_total;      /* rupees, last bill                */
+    bill_split_t split;           /* groups + which are already paid  */
+    uint8_t      active_seat;     /* cart seat the guest was adding to */
+    uint8_t      reserved;
+    uint16_t     cart_count;
+    session_cart_line_t cart[CART_HARD_CAP];   /* only cart_count stored */
+} session_snapshot_t;
+
+/* Bytes of s that are persisted (header + used cart lines) */
+int  session_snapshot_size(const session_snapshot_t *s);
+
+/* Blocking flash I/O: net task or setup() only, never inside an LVGL
+ * callback. Save returns 0 on success, -1 on error. */
+int  session_store_save(const session_snapshot_t *s);
+void session_store_clear(void);
+
+/* False if there is no snapshot or it is from another layout */
+bool session_store_load(session_snapshot_t *out);
+
+/* Boot counter, kept in the same namespace: incremented on the first
+ * call after each boot, then returned unchanged. Distinguishes the
+ * operation ids (autodine_net.cpp) of one boot from the next. */
+uint32_t session_store_boot_epoch(void);
+
+#ifdef __cplusplus
+}
+#endif
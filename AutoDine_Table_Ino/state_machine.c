@@ -6,50 +6,361 @@
  *           via sm_get_order_id() / sm_set_order_id() so ui_screens.c
  *           always uses the correct order even in append-mode.
  *   [STATE] sm_set() now handles STATE_FOOD_SERVED (defined in header).
+ *   [EVENTS] Event queue + transition table; see state_machine.h.
+ *   [TRACE]  Transition trace ring and dwell histograms.
  * ===================================================================== */
 #include "state_machine.h"
-#include "ui_screens.h"
-#include "hardware_compat.h"
 #include "autodine_net.h"
+#include "app_config.h"
+#include <stddef.h>
+#include <stdio.h>
 
-/* millis() is a C++ Arduino runtime function.
+/* micros() is a C++ Arduino runtime function.
  * Declare it extern here so this .c translation unit can call it
  * without including Arduino.h (which is C++-only).
  * The linker resolves it from the Arduino core object. */
 #ifdef ARDUINO
+extern unsigned long micros(void);
 extern unsigned long millis(void);
+#else
+static unsigned long micros(void) { return 0; }
+static unsigned long millis(void) { return 0; }
 #endif
 
 static app_state_t s_state    = STATE_SPLASH;
 static int         s_order_id = -1;   /* BUG 2: canonical order id */
 
-/* Bug 10: WiFi re-check ticker */
-static unsigned long s_wifi_check_ms = 0;
-#define WIFI_CHECK_INTERVAL_MS  5000
+/* ---- Transition table ----
+ * One row per (state, event) that does something; anything else is
+ * ignored. */
+typedef struct {
+    uint8_t from, ev, to;
+} sm_row_t;
+
+static const sm_row_t s_table[] = {
+    { STATE_SPLASH,         EV_START,          STATE_MENU           },
+    { STATE_MENU,           EV_ORDER_ACCEPTED, STATE_ORDER_PLACED   },
+    { STATE_ORDER_PLACED,   EV_FOOD_READY,     STATE_FOOD_READY     },
+    { STATE_ORDER_PLACED,   EV_FOOD_SERVED,    STATE_FOOD_SERVED    },
+    { STATE_FOOD_READY,     EV_FOOD_SERVED,    STATE_FOOD_SERVED    },
+    { STATE_ORDER_PLACED,   EV_ADD_MORE,       STATE_MENU           },
+    { STATE_FOOD_READY,     EV_ADD_MORE,       STATE_MENU           },
+    { STATE_FOOD_SERVED,    EV_ADD_MORE,       STATE_MENU           },
+    { STATE_FOOD_READY,     EV_BILL_REQUEST,   STATE_BILL           },
+    { STATE_FOOD_SERVED,    EV_BILL_REQUEST,   STATE_BILL           },
+    { STATE_BILL,           EV_PAY_PROCEED,    STATE_PAYMENT_SELECT },
+    { STATE_PAYMENT_SELECT, EV_PAY_UPI,        STATE_PAYMENT_UPI    },
+    { STATE_PAYMENT_SELECT, EV_PAY_CASH,       STATE_PAYMENT_CASH   },
+    { STATE_PAYMENT_UPI,    EV_SEAT_PAID,      STATE_PAYMENT_SELECT },
+    { STATE_PAYMENT_CASH,   EV_SEAT_PAID,      STATE_PAYMENT_SELECT },
+    { STATE_PAYMENT_UPI,    EV_PAID,           STATE_FEEDBACK       },
+    { STATE_PAYMENT_CASH,   EV_PAID,           STATE_FEEDBACK       },
+    { STATE_FEEDBACK,       EV_SESSION_END,    STATE_SPLASH         },
+    /* Resume check after a reset (session_store.h) */
+    { STATE_MENU,           EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_ORDER_PLACED,   EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_FOOD_READY,     EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_FOOD_SERVED,    EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_BILL,           EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_PAYMENT_SELECT, EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_PAYMENT_UPI,    EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_PAYMENT_CASH,   EV_ORDER_LOST,     STATE_SPLASH         },
+    { STATE_BILL,           EV_PAID_REMOTELY,  STATE_FEEDBACK       },
+    { STATE_PAYMENT_SELECT, EV_PAID_REMOTELY,  STATE_FEEDBACK       },
+    { STATE_PAYMENT_UPI,    EV_PAID_REMOTELY,  STATE_FEEDBACK       },
+    { STATE_PAYMENT_CASH,   EV_PAID_REMOTELY,  STATE_FEEDBACK       },
+};
+
+static const char *const s_state_names[STATE_COUNT] = {
+    "SPLASH", "MENU", "ORDER_PLACED", "FOOD_READY", "FOOD_SERVED",
+    "BILL", "PAY_SELECT", "PAY_UPI", "PAY_CASH", "FEEDBACK",
+};
+
+static const char *const s_event_names[EV_COUNT] = {
+    "NONE", "START", "ORDER_ACCEPTED", "ADD_MORE", "FOOD_READY",
+    "FOOD_SERVED", "BILL_REQUEST", "PAY_PROCEED", "PAY_UPI", "PAY_CASH",
+    "SEAT_PAID", "PAID", "SESSION_END", "ORDER_LOST", "PAID_REMOTELY",
+    "GOTO",
+};
+
+static sm_action_fn s_entry[STATE_COUNT];
+static sm_action_fn s_exit[STATE_COUNT];
+
+#if SM_TRACE_RING
+/* ---- Transition trace ----
+ * Slot = count % SM_TRACE_RING; count only grows, so a reader's cursor
+ * tells how much it missed. Dwell buckets are upper edges in seconds. */
+static sm_trace_t s_tr[SM_TRACE_RING];
+static uint32_t   s_tr_count;
+static uint32_t   s_enter_ms;               /* when s_state was entered   */
+static uint32_t   s_render_until;           /* render window of the newest */
+static uint16_t   s_dwell_hist[STATE_COUNT][SM_DWELL_BUCKETS];
+static uint32_t   s_dwell_sum_s[STATE_COUNT];
+static const uint16_t s_dwell_edge_s[SM_DWELL_BUCKETS - 1] = {
+    1, 5, 15, 30, 60, 120, 300, 600, 1200,
+};
+
+static void sm_trace_add(app_state_t from, app_state_t to, sm_event_t ev,
+                         uint32_t now_ms, uint32_t queued_us, uint32_t run_us)
+{
+    uint32_t dwell = now_ms - s_enter_ms;
+    s_enter_ms = now_ms;
+
+    int b = 0;
+    while (b < SM_DWELL_BUCKETS - 1 && dwell >= s_dwell_edge_s[b] * 1000u) b++;
+    if (s_dwell_hist[from][b] < UINT16_MAX) s_dwell_hist[from][b]++;
+    s_dwell_sum_s[from] += dwell / 1000;
+
+    sm_trace_t *t = &s_tr[s_tr_count % SM_TRACE_RING];
+    t->t_ms      = now_ms;
+    t->dwell_ms  = dwell;
+    t->queued_us = queued_us;
+    t->run_us    = run_us;
+    t->render_ms = 0;
+    t->frames    = 0;
+    t->from      = (uint8_t)from;
+    t->to        = (uint8_t)to;
+    t->ev        = (uint8_t)ev;
+    __atomic_store_n(&s_tr_count, s_tr_count + 1, __ATOMIC_RELEASE);
+    s_render_until = now_ms + SM_TRACE_RENDER_MS;
+}
+
+void sm_trace_render(uint32_t time_ms)
+{
+    if (s_tr_count == 0 || (int32_t)((uint32_t)millis() - s_render_until) > 0) return;
+    sm_trace_t *t = &s_tr[(s_tr_count - 1) % SM_TRACE_RING];
+    t->render_ms = (uint16_t)(t->render_ms + time_ms > UINT16_MAX ? UINT16_MAX
+                                                                 : t->render_ms + time_ms);
+    if (t->frames < UINT8_MAX) t->frames++;
+}
+
+int sm_trace_read(uint32_t *cursor, sm_trace_t *out, int max, uint32_t *lost)
+{
+    uint32_t end = __atomic_load_n(&s_tr_count, __ATOMIC_ACQUIRE);
+    if (end && (int32_t)((uint32_t)millis() - s_render_until) <= 0) end--;  /* still rendering */
+    uint32_t first = *cursor;
+    *lost = 0;
+    if (end - first > SM_TRACE_RING) {
+        *lost = end - first - SM_TRACE_RING;
+        first = end - SM_TRACE_RING;
+    }
+    int n = 0;
+    for (uint32_t i = first; i != end && n < max; i++) out[n++] = s_tr[i % SM_TRACE_RING];
+    *cursor = first + n;
+    return n;
+}
+
+int sm_trace_json(const sm_trace_t *t, int n, uint32_t lost, char *buf, int len)
+{
+    int w = snprintf(buf, len, "{\"table\":%d,\"lost\":%lu,\"events\":[",
+                     TABLE_NUMBER, (unsigned long)lost);
+    for (int i = 0; i < n && w < len; i++)
+        w += snprintf(buf + w, len - w,
+                      "%s{\"t\":%lu,\"from\":\"%s\",\"to\":\"%s\",\"ev\":\"%s\","
+                      "\"dwell_ms\":%lu,\"queued_us\":%lu,\"run_us\":%lu,"
+                      "\"render_ms\":%u,\"frames\":%u}",
+                      i ? "," : "", (unsigned long)t[i].t_ms,
+                      sm_state_name((app_state_t)t[i].from), sm_state_name((app_state_t)t[i].to),
+                      sm_event_name((sm_event_t)t[i].ev), (unsigned long)t[i].dwell_ms,
+                      (unsigned long)t[i].queued_us, (unsigned long)t[i].run_us,
+                      (unsigned)t[i].render_ms, (unsigned)t[i].frames);
+    if (w < len) w += snprintf(buf + w, len - w, "]}");
+    return w < len ? w : -1;
+}
+
+void sm_trace_dump(void)
+{
+    uint32_t count = s_tr_count;
+    uint32_t first = count > SM_TRACE_RING ? count - SM_TRACE_RING : 0;
+    net_log("[SM] trace: %lu transition(s), last %lu\n",
+            (unsigned long)count, (unsigned long)(count - first));
+    for (uint32_t i = first; i != count; i++) {
+        const sm_trace_t *t = &s_tr[i % SM_TRACE_RING];
+        net_log("[SM] %8lu ms  %-12s -> %-12s %-14s dwell %6lu ms  run %6lu us  "
+                "render %4u ms / %u fr\n",
+                (unsigned long)t->t_ms, s_state_names[t->from], s_state_names[t->to],
+                s_event_names[t->ev], (unsigned long)t->dwell_ms,
+                (unsigned long)t->run_us, (unsigned)t->render_ms, (unsigned)t->frames);
+    }
+    net_log("[SM] dwell     <1s  <5s <15s <30s  <1m  <2m  <5m <10m <20m more   avg\n");
+    for (int st = 0; st < STATE_COUNT; st++) {
+        uint32_t n = 0;
+        for (int b = 0; b < SM_DWELL_BUCKETS; b++) n += s_dwell_hist[st][b];
+        if (!n) continue;
+        char row[80];
+        int w = 0;
+        for (int b = 0; b < SM_DWELL_BUCKETS; b++)
+            w += snprintf(row + w, sizeof(row) - w, " %4u", (unsigned)s_dwell_hist[st][b]);
+        net_log("[SM] %-12s%s %4lus\n", s_state_names[st], row,
+                (unsigned long)(s_dwell_sum_s[st] / n));
+    }
+}
+#else
+void sm_trace_render(uint32_t time_ms) { (void)time_ms; }
+int  sm_trace_read(uint32_t *cursor, sm_trace_t *out, int max, uint32_t *lost)
+{
+    (void)cursor; (void)out; (void)max; *lost = 0; return 0;
+}
+int  sm_trace_json(const sm_trace_t *t, int n, uint32_t lost, char *buf, int len)
+{
+    (void)t; (void)n; (void)lost; (void)buf; (void)len; return -1;
+}
+void sm_trace_dump(void) {}
+#endif
+
+/* ---- Event queue ----
+ * Bounded multi-producer / single-consumer ring (per-slot sequence
+ * numbers): the UI task, the net task and lv_timers all post; only
+ * sm_update() takes. Lock-free, so posting never waits on LVGL. */
+typedef struct {
+    uint32_t seq;
+    uint8_t  ev;
+    uint8_t  arg;        /* EV_GOTO target */
+    uint32_t t_us;       /* when posted    */
+} sm_slot_t;
+
+static sm_slot_t s_q[SM_QUEUE_LEN];
+static uint32_t  s_q_head;           /* next slot to claim (producers) */
+static uint32_t  s_q_tail;           /* next slot to take (consumer)   */
+static uint32_t  s_q_drops;
 
 void sm_init(void)
 {
-    s_state          = STATE_SPLASH;
-    s_order_id       = -1;
-    s_wifi_check_ms  = 0;
+    s_state    = STATE_SPLASH;
+    s_order_id = -1;
+    for (uint32_t i = 0; i < SM_QUEUE_LEN; i++) s_q[i].seq = i;
+    s_q_head = s_q_tail = 0;
+}
+
+static bool sm_enqueue(sm_event_t ev, uint8_t arg)
+{
+    uint32_t pos = __atomic_load_n(&s_q_head, __ATOMIC_RELAXED);
+    sm_slot_t *c;
+    for (;;) {
+        c = &s_q[pos % SM_QUEUE_LEN];
+        int32_t dif = (int32_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&s_q_head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;                       /* slot claimed */
+        } else if (dif < 0) {
+            __atomic_add_fetch(&s_q_drops, 1, __ATOMIC_RELAXED);
+            return false;                    /* full */
+        } else {
+            pos = __atomic_load_n(&s_q_head, __ATOMIC_RELAXED);
+        }
+    }
+    c->ev   = (uint8_t)ev;
+    c->arg  = arg;
+    c->t_us = (uint32_t)micros();
+    __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool sm_dequeue(sm_slot_t *out)
+{
+    sm_slot_t *c = &s_q[s_q_tail % SM_QUEUE_LEN];
+    if (__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) != s_q_tail + 1) return false;
+    *out = *c;
+    __atomic_store_n(&c->seq, s_q_tail + SM_QUEUE_LEN, __ATOMIC_RELEASE);
+    s_q_tail++;
+    return true;
+}
+
+bool sm_post(sm_event_t ev)
+{
+    if (ev <= EV_NONE || ev >= EV_COUNT || ev == EV_GOTO) return false;
+    return sm_enqueue(ev, 0);
+}
+
+void sm_set(app_state_t new_state)
+{
+    if (new_state < STATE_COUNT) sm_enqueue(EV_GOTO, (uint8_t)new_state);
+}
+
+void sm_resume(app_state_t state)
+{
+    if (state >= STATE_COUNT) return;
+    s_state = state;
+#if SM_TRACE_RING
+    s_enter_ms = (uint32_t)millis();
+#endif
+    if (s_entry[state]) s_entry[state](state, state);
+#if SM_TRACE
+    net_log("[SM] resumed in %s\n", s_state_names[state]);
+#endif
+}
+
+void sm_bind(app_state_t state, sm_action_fn entry, sm_action_fn exit)
+{
+    if (state >= STATE_COUNT) return;
+    s_entry[state] = entry;
+    s_exit[state]  = exit;
 }
 
 app_state_t sm_get(void)    { return s_state; }
 int  sm_get_order_id(void)  { return s_order_id; }
 void sm_set_order_id(int id){ s_order_id = id; }
 
-void sm_set(app_state_t new_state)
+const char *sm_state_name(app_state_t s)
 {
-    if (new_state == s_state) return;
-    s_state = new_state;
+    return s < STATE_COUNT ? s_state_names[s] : "?";
+}
 
-    lvgl_acquire();
-    ui_show_screen(new_state);
-    lvgl_release();
+const char *sm_event_name(sm_event_t ev)
+{
+    return ev < EV_COUNT ? s_event_names[ev] : "?";
 }
 
-extern int g_pending_buzz;   /* defined in ui_screens.c */
+static int sm_lookup(app_state_t from, sm_event_t ev)
+{
+    for (size_t i = 0; i < sizeof(s_table) / sizeof(s_table[0]); i++)
+        if (s_table[i].ev == ev && s_table[i].from == from)
+            return s_table[i].to;
+    return -1;
+}
+
+void sm_update(void)
+{
+    sm_slot_t m;
+    while (sm_dequeue(&m)) {
+        sm_event_t ev = (sm_event_t)m.ev;
+        int to = ev == EV_GOTO ? m.arg : sm_lookup(s_state, ev);
+        if (to < 0) {
+#if SM_TRACE
+            net_log("[SM] %s: %s ignored\n", s_state_names[s_state], s_event_names[ev]);
+#endif
+            continue;
+        }
+        if (to == (int)s_state) continue;
 
-void sm_update(void) {
-    /* All deferred logic moved to ui_check_deferred() for safe network execution */
+        app_state_t from = s_state;
+        uint32_t now_ms = (uint32_t)millis();
+        uint32_t t0 = (uint32_t)micros();
+        if (s_exit[from]) s_exit[from](from, (app_state_t)to);
+        s_state = (app_state_t)to;
+        if (s_entry[to]) s_entry[to]((app_state_t)to, from);
+        uint32_t t1 = (uint32_t)micros();
+#if SM_TRACE_RING
+        sm_trace_add(from, (app_state_t)to, ev, now_ms, t0 - m.t_us, t1 - t0);
+#else
+        (void)now_ms;
+#endif
+#if SM_TRACE
+        /* queued = post -> dequeue, run = exit + entry actions */
+        net_log("[SM] %s -> %s on %s  queued %lu us, run %lu us\n",
+                s_state_names[from], s_state_names[to], s_event_names[ev],
+                (unsigned long)(t0 - m.t_us), (unsigned long)(t1 - t0));
+#else
+        (void)t0; (void)t1;
+#endif
+    }
+#if SM_TRACE
+    static uint32_t reported_drops;
+    uint32_t d = __atomic_load_n(&s_q_drops, __ATOMIC_RELAXED);
+    if (d != reported_drops) {
+        net_log("[SM] event queue full: %lu dropped\n", (unsigned long)(d - reported_drops));
+        reported_drops = d;
+    }
+#endif
 }
@@ -7,9 +7,24 @@
  *           STATE_COUNT incremented accordingly.
  *   [BUG 2] Added sm_get_order_id() / sm_set_order_id() so append-mode
  *           always passes the correct order_id through the full flow.
+ *   [EVENTS] Screens no longer set the state directly. Any task posts a
+ *           typed event (sm_post); sm_update() on the UI task drains the
+ *           queue in order and looks each one up in the transition table
+ *           in state_machine.c. An event with no row for the current
+ *           state is dropped and logged, so a late poll result can no
+ *           longer pull the table back to an old screen.
+ *   [RESUME] sm_resume() enters a state restored from the session
+ *           snapshot (session_store.h) at boot.
+ *   [TRACE] Transition trace ring + per-state dwell histograms, dumped
+ *           over serial or uploaded in batches (POST /api/trace).
  * ===================================================================== */
+#include <stdbool.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum {
     STATE_SPLASH = 0,
     STATE_MENU,
@@ -24,13 +39,89 @@ typedef enum {
     STATE_COUNT
 } app_state_t;
 
+typedef enum {
+    EV_NONE = 0,
+    EV_START,            /* splash tapped                          */
+    EV_ORDER_ACCEPTED,   /* server took a new order or an append   */
+    EV_ADD_MORE,         /* guest wants to add to the order        */
+    EV_FOOD_READY,       /* order poll: kitchen marked it ready    */
+    EV_FOOD_SERVED,      /* order poll or guest: food is on table  */
+    EV_BILL_REQUEST,
+    EV_PAY_PROCEED,      /* bill -> choose a payment method        */
+    EV_PAY_UPI,
+    EV_PAY_CASH,
+    EV_SEAT_PAID,        /* one seat of a split bill settled       */
+    EV_PAID,             /* nothing left to pay                    */
+    EV_SESSION_END,      /* feedback sent or timed out             */
+    EV_ORDER_LOST,       /* resume: server has no such order       */
+    EV_PAID_REMOTELY,    /* resume: paid while the table was down  */
+    EV_GOTO,             /* forced jump (sm_set): tools and debug  */
+    EV_COUNT
+} sm_event_t;
+
+/* Entry runs after the state changes, exit before; both on the UI task
+ * inside lvgl_acquire. `other` is the state being left / entered. */
+typedef void (*sm_action_fn)(app_state_t state, app_state_t other);
+
 void        sm_init(void);
 app_state_t sm_get(void);
+
+/* Queue an event; safe from any task (not ISRs). False if the queue is
+ * full — the event is counted as dropped. */
+bool        sm_post(sm_event_t ev);
+
+/* Force a state regardless of the table (sim "state" command, debug) */
 void        sm_set(app_state_t new_state);
 
+/* Boot only: start in `state` (restored session) and run its entry
+ * action, with no exit and no event. UI task, inside lvgl_acquire. */
+void        sm_resume(app_state_t state);
+
+/* Entry / exit actions for one state (NULL = none) */
+void        sm_bind(app_state_t state, sm_action_fn entry, sm_action_fn exit);
+
+const char *sm_state_name(app_state_t s);
+const char *sm_event_name(sm_event_t ev);
+
 /* BUG 2: order-id accessors so every module reads the canonical value */
 int         sm_get_order_id(void);
 void        sm_set_order_id(int oid);
 
-/* Called every LVGL tick cycle from the LVGL task */
+/* Drain the event queue and run transitions. UI task, once per pass,
+ * inside lvgl_acquire. */
 void        sm_update(void);
+
+/* ---- Transition trace (SM_TRACE_RING in app_config.h) ----
+ * Every transition lands in a fixed ring: when, from -> to, the event,
+ * how long the state was shown, and what the switch cost the UI. The
+ * ring and the dwell histograms are written on the UI task only. */
+#define SM_DWELL_BUCKETS  10   /* <1s <5s <15s <30s <1m <2m <5m <10m <20m, more */
+
+typedef struct {
+    uint32_t t_ms;        /* millis() at the transition                */
+    uint32_t dwell_ms;    /* time spent in `from`                      */
+    uint32_t queued_us;   /* sm_post -> sm_update                      */
+    uint32_t run_us;      /* exit + entry actions (screen build, anims started) */
+    uint16_t render_ms;   /* LVGL render+flush in the SM_TRACE_RENDER_MS after */
+    uint8_t  frames;      /* refreshes counted in render_ms            */
+    uint8_t  from, to, ev;
+    uint8_t  pad[2];
+} sm_trace_t;
+
+/* Display monitor hook: charges a refresh to the latest transition */
+void sm_trace_render(uint32_t time_ms);
+
+/* Copy entries newer than *cursor (oldest first, at most max) and move
+ * *cursor past them. The newest entry is held back until its render
+ * window closes. *lost = entries overwritten before they were read. */
+int  sm_trace_read(uint32_t *cursor, sm_trace_t *out, int max, uint32_t *lost);
+
+/* Upload body for POST /api/trace. Bytes written, -1 if buf is short. */
+int  sm_trace_json(const sm_trace_t *t, int n, uint32_t lost, char *buf, int len);
+
+/* Ring and per-state dwell histograms to the serial log */
+void sm_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,43 +4,101 @@
  *
  * Install via Arduino Library Manager or from:
  *   Documents/Arduino/libraries/gt911-arduino-main
+ *
+ * The controller is read by a dedicated touch task (TOUCH_TASK_CORE), never
+ * from LVGL. With TOUCH_GT911_INT wired the task sleeps until the GT911
+ * raises INT; otherwise it polls, fast while a finger is down and slowly
+ * when idle. Only changed samples are queued (touch_ring.c); the LVGL
+ * read_cb drains that ring, so a UI pass costs no I2C transaction.
  */
 #pragma once
 #include <TAMC_GT911.h>
+#include "app_config.h"
+#include "touch_ring.h"
 
 /* ── CrowPanel 7.0 pin mapping ─────────────────────────────────────── */
 #define TOUCH_GT911_SDA   19
 #define TOUCH_GT911_SCL   20
-#define TOUCH_GT911_INT   255   /* not connected — 255 (= uint8_t(-1)) no-ops safely */
+#define TOUCH_GT911_INT   255   /* not connected — 255 (= uint8_t(-1)) no-ops safely;
+                                 * set the GPIO here if INT is routed to the S3 */
 #define TOUCH_GT911_RST   38
 #define TOUCH_MAP_X1      800
 #define TOUCH_MAP_Y1      480
 
-/* ── LVGL-readable coordinates ─────────────────────────────────────── */
-int touch_last_x = 0;
-int touch_last_y = 0;
+/* ── Last sample handed to LVGL ─────────────────────────────────────── */
+int  touch_last_x = 0;
+int  touch_last_y = 0;
+bool touch_last_pressed = false;
 
-/* ── TAMC_GT911 instance ────────────────────────────────────────────── */
+/* ── TAMC_GT911 instance (touch task only) ──────────────────────────── */
 TAMC_GT911 TS = TAMC_GT911(TOUCH_GT911_SDA, TOUCH_GT911_SCL,
                              TOUCH_GT911_INT, TOUCH_GT911_RST,
                              TOUCH_MAP_X1, TOUCH_MAP_Y1);
 
+static TaskHandle_t _touch_task = NULL;
+
+#if TOUCH_GT911_INT != 255
+static void IRAM_ATTR touch_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(_touch_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+#endif
+
+/* ── Touch task: the only I2C reader ────────────────────────────────── */
+static void touch_task(void *arg)
+{
+    bool    down = false;
+    int16_t lx = 0, ly = 0;
+
+    for (;;) {
+#if TOUCH_GT911_INT != 255
+        /* INT pulses once per scan while touched and once on lift; the
+         * timeout only matters if that last pulse is missed */
+        ulTaskNotifyTake(pdTRUE, down ? pdMS_TO_TICKS(TOUCH_POLL_ACTIVE_MS * 4)
+                                      : portMAX_DELAY);
+#else
+        vTaskDelay(pdMS_TO_TICKS(down ? TOUCH_POLL_ACTIVE_MS : TOUCH_POLL_IDLE_MS));
+#endif
+        TS.read();
+        touch_ring_note_read();
+
+        if (TS.isTouched) {
+            int16_t x = TS.points[0].x, y = TS.points[0].y;
+            if (!down || x != lx || y != ly) {
+                if (touch_ring_push(x, y, true)) { lx = x; ly = y; down = true; }
+            }
+        } else if (down) {
+            /* A dropped release is retried on the next read */
+            if (touch_ring_push(lx, ly, false)) down = false;
+        }
+    }
+}
+
 /* ── Public API ─────────────────────────────────────────────────────── */
 void touch_init() {
     TS.begin();
     TS.setRotation(ROTATION_INVERTED);  /* raw coords = screen coords for landscape */
+    xTaskCreatePinnedToCore(touch_task, "touch", TOUCH_TASK_STACK, NULL,
+                            TOUCH_TASK_PRIO, &_touch_task, TOUCH_TASK_CORE);
+#if TOUCH_GT911_INT != 255
+    pinMode(TOUCH_GT911_INT, INPUT);
+    attachInterrupt(digitalPinToInterrupt(TOUCH_GT911_INT), touch_isr, FALLING);
+    Serial.println("[TOUCH] GT911 INT driven");
+#else
+    Serial.printf("[TOUCH] GT911 polled (%d/%d ms)\n",
+                  TOUCH_POLL_ACTIVE_MS, TOUCH_POLL_IDLE_MS);
+#endif
 }
 
-bool touch_has_signal() { return true; }
-
-bool touch_touched() {
-    TS.read();
-    if (TS.isTouched) {
-        touch_last_x = TS.points[0].x;
-        touch_last_y = TS.points[0].y;
-        return true;
-    }
-    return false;
+/* Next queued sample, or false if nothing changed since the last call.
+ * UI task only. */
+bool touch_next(touch_sample_t *s) {
+    if (!touch_ring_pop(s)) return false;
+    touch_last_x       = s->x;
+    touch_last_y       = s->y;
+    touch_last_pressed = s->pressed;
+    touch_ring_delivered(s);
+    return true;
 }
-
-bool touch_released() { return !TS.isTouched; }
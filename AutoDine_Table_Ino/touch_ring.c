@@ -0,0 +1,270 @@
+/* =====================================================================
+ *  touch_ring.c — AutoDine V4.0 touch sample queue + latency harness
+ * ===================================================================== */
+#include "touch_ring.h"
+#include "autodine_net.h"
+#include <string.h>
+
+#ifdef ARDUINO
+extern unsigned long micros(void);
+extern unsigned long millis(void);
+#else
+static unsigned long micros(void) { return 0; }
+static unsigned long millis(void) { return 0; }
+#endif
+
+#define LAT_BUCKETS  64      /* 1 ms histogram buckets; last = overflow */
+#define LAT_TAGS     12      /* distinct TOUCH_LAT_MARK tags tracked    */
+#define SYN_LEN      32      /* queued synthetic samples (2 per tap)    */
+
+static touch_sample_t s_ring[TOUCH_RING_LEN];
+static uint32_t       s_head = 0;   /* written by producer only */
+static uint32_t       s_tail = 0;   /* written by consumer only */
+
+/* Producer-side counters */
+static volatile uint32_t s_reads = 0;
+static volatile uint32_t s_drops = 0;
+
+typedef struct {
+    uint32_t n, sum_us, max_us;
+    uint16_t hist[LAT_BUCKETS];
+} lat_stats_t;
+
+typedef struct {
+    const char *tag;
+    uint32_t    n, n_syn, sum_us, max_us;
+} lat_tag_t;
+
+/* Synthetic samples: produced and consumed on the UI task */
+typedef struct {
+    int16_t  x, y;
+    uint8_t  pressed;
+    uint32_t due_ms;
+} syn_sample_t;
+
+static syn_sample_t s_syn[SYN_LEN];
+static uint32_t     s_syn_head = 0, s_syn_tail = 0;
+
+/* One press or release followed through to its frame */
+typedef struct {
+    bool        open;          /* delivered, callback not seen yet     */
+    bool        wait_flush;    /* callback seen, waiting for a refresh */
+    bool        pressed, synthetic;
+    uint32_t    t_sample, t_read, t_cb;
+    const char *tag;
+} lat_cur_t;
+
+/* Consumer-side state */
+static lat_stats_t s_read;          /* sample -> read_cb             */
+static lat_stats_t s_cb;            /* read_cb -> event callback     */
+static lat_stats_t s_flush;         /* event callback -> refresh end */
+static lat_stats_t s_total;         /* sample -> refresh end         */
+static lat_stats_t s_press_frame;   /* press sample -> next refresh  */
+static lat_tag_t   s_tags[LAT_TAGS];
+static lat_cur_t   s_cur;
+static uint32_t    s_samples = 0;
+static uint32_t    s_silent_releases = 0;  /* release, no callback */
+static bool        s_was_pressed = false;
+static uint32_t    s_vis_t0 = 0;
+static bool        s_vis_armed = false;
+static uint32_t    s_report_ms = 0;
+static uint32_t    s_reads_at_report = 0;
+
+bool touch_ring_push(int16_t x, int16_t y, bool pressed)
+{
+    uint32_t head = s_head;
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= TOUCH_RING_LEN) { s_drops++; return false; }
+    touch_sample_t *s = &s_ring[head & (TOUCH_RING_LEN - 1)];
+    s->x = x; s->y = y; s->pressed = pressed; s->synthetic = 0;
+    s->t_us = (uint32_t)micros();
+    __atomic_store_n(&s_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void touch_ring_note_read(void) { s_reads++; }
+
+static bool syn_due(void)
+{
+    return s_syn_head != s_syn_tail &&
+           (int32_t)((uint32_t)millis() - s_syn[s_syn_tail % SYN_LEN].due_ms) >= 0;
+}
+
+bool touch_ring_pending(void)
+{
+    return syn_due() || __atomic_load_n(&s_head, __ATOMIC_ACQUIRE) != s_tail;
+}
+
+bool touch_ring_pop(touch_sample_t *out)
+{
+    if (syn_due()) {
+        const syn_sample_t *q = &s_syn[s_syn_tail++ % SYN_LEN];
+        out->x = q->x; out->y = q->y; out->pressed = q->pressed;
+        out->synthetic = 1;
+        out->t_us = (uint32_t)micros();
+        return true;
+    }
+    uint32_t tail = s_tail;
+    if (__atomic_load_n(&s_head, __ATOMIC_ACQUIRE) == tail) return false;
+    *out = s_ring[tail & (TOUCH_RING_LEN - 1)];
+    __atomic_store_n(&s_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+int touch_inject_tap(int16_t x, int16_t y, int count)
+{
+    uint32_t t = (uint32_t)millis();
+    /* Queue after anything still pending */
+    if (s_syn_head != s_syn_tail) {
+        uint32_t last = s_syn[(s_syn_head - 1) % SYN_LEN].due_ms + TOUCH_SYN_TAP_MS;
+        if ((int32_t)(last - t) > 0) t = last;
+    }
+    int n = 0;
+    for (; n < count && s_syn_head - s_syn_tail + 2 <= SYN_LEN; n++) {
+        syn_sample_t *d = &s_syn[s_syn_head++ % SYN_LEN];
+        d->x = x; d->y = y; d->pressed = 1; d->due_ms = t;
+        syn_sample_t *u = &s_syn[s_syn_head++ % SYN_LEN];
+        u->x = x; u->y = y; u->pressed = 0; u->due_ms = t + TOUCH_SYN_HOLD_MS;
+        t += TOUCH_SYN_TAP_MS;
+    }
+    return n;
+}
+
+static void lat_add(lat_stats_t *l, uint32_t us)
+{
+    uint32_t b = us / 1000;
+    if (b >= LAT_BUCKETS) b = LAT_BUCKETS - 1;
+    l->hist[b]++;
+    l->n++;
+    l->sum_us += us;
+    if (us > l->max_us) l->max_us = us;
+}
+
+/* Upper edge (ms) of the bucket holding the pct-th percentile */
+static uint32_t lat_pct(const lat_stats_t *l, uint32_t pct)
+{
+    uint32_t want = (l->n * pct + 99) / 100, acc = 0;
+    for (uint32_t b = 0; b < LAT_BUCKETS; b++) {
+        acc += l->hist[b];
+        if (acc >= want) return b + 1;
+    }
+    return LAT_BUCKETS;
+}
+
+static void lat_tag_add(const char *tag, bool syn, uint32_t us)
+{
+    lat_tag_t *t = NULL;
+    for (int i = 0; i < LAT_TAGS; i++) {
+        if (s_tags[i].tag && strcmp(s_tags[i].tag, tag) == 0) { t = &s_tags[i]; break; }
+        if (!t && !s_tags[i].tag) t = &s_tags[i];
+    }
+    if (!t) return;                        /* table full: global stats only */
+    t->tag = tag;
+    t->n++;
+    if (syn) t->n_syn++;
+    t->sum_us += us;
+    if (us > t->max_us) t->max_us = us;
+}
+
+void touch_ring_delivered(const touch_sample_t *s)
+{
+    uint32_t now = (uint32_t)micros();
+    s_samples++;
+    lat_add(&s_read, now - s->t_us);
+
+    if (s->pressed && !s_was_pressed) {
+        s_vis_t0    = s->t_us;       /* finger down: wait for its frame */
+        s_vis_armed = true;
+    }
+    if (s->pressed != s_was_pressed) {
+        /* A new edge; the previous release never reached a callback */
+        if (s_cur.open && !s_cur.pressed) s_silent_releases++;
+        s_cur.open       = true;
+        s_cur.wait_flush = false;
+        s_cur.pressed    = s->pressed;
+        s_cur.synthetic  = s->synthetic;
+        s_cur.t_sample   = s->t_us;
+        s_cur.t_read     = now;
+    }
+    s_was_pressed = s->pressed;
+}
+
+void touch_lat_mark(const char *tag)
+{
+    if (!s_cur.open) return;                  /* not touch driven */
+    s_cur.open       = false;
+    s_cur.wait_flush = true;
+    s_cur.t_cb       = (uint32_t)micros();
+    s_cur.tag        = tag;
+    lat_add(&s_cb, s_cur.t_cb - s_cur.t_read);
+}
+
+void touch_ring_flushed(void)
+{
+    uint32_t now = (uint32_t)micros();
+    if (s_vis_armed) {
+        s_vis_armed = false;
+        lat_add(&s_press_frame, now - s_vis_t0);
+    }
+    if (s_cur.wait_flush) {
+        uint32_t total = now - s_cur.t_sample;
+        s_cur.wait_flush = false;
+        lat_add(&s_flush, now - s_cur.t_cb);
+        lat_add(&s_total, total);
+        lat_tag_add(s_cur.tag, s_cur.synthetic, total);
+#if TOUCH_LAT_TRACE
+        net_log("[LAT] %s%s read=%luus cb=%luus flush=%luus total=%luus\n",
+                s_cur.tag, s_cur.synthetic ? " (syn)" : "",
+                (unsigned long)(s_cur.t_read - s_cur.t_sample),
+                (unsigned long)(s_cur.t_cb - s_cur.t_read),
+                (unsigned long)(now - s_cur.t_cb),
+                (unsigned long)total);
+#endif
+    }
+}
+
+static void lat_line(const char *name, const lat_stats_t *l)
+{
+    if (!l->n) return;
+    net_log("[LAT]  %-11s n=%-5lu avg=%6luus p50<=%lums p95<=%lums max=%luus\n",
+            name, (unsigned long)l->n, (unsigned long)(l->sum_us / l->n),
+            (unsigned long)lat_pct(l, 50), (unsigned long)lat_pct(l, 95),
+            (unsigned long)l->max_us);
+}
+
+void touch_lat_report(void)
+{
+    lat_line("sample>read", &s_read);
+    lat_line("read>cb",     &s_cb);
+    lat_line("cb>flush",    &s_flush);
+    lat_line("total",       &s_total);
+    lat_line("press>frame", &s_press_frame);
+    for (int i = 0; i < LAT_TAGS && s_tags[i].tag; i++) {
+        const lat_tag_t *t = &s_tags[i];
+        net_log("[LAT]  tag %-8s n=%-5lu (syn %lu) avg=%6luus max=%luus\n",
+                t->tag, (unsigned long)t->n, (unsigned long)t->n_syn,
+                (unsigned long)(t->sum_us / t->n), (unsigned long)t->max_us);
+    }
+    if (s_silent_releases)
+        net_log("[LAT]  releases with no callback: %lu\n",
+                (unsigned long)s_silent_releases);
+}
+
+void touch_ring_tick(void)
+{
+#if TOUCH_STATS_MS > 0
+    uint32_t now = (uint32_t)millis();
+    uint32_t dt  = now - s_report_ms;
+    if (dt < TOUCH_STATS_MS) return;
+    uint32_t reads = s_reads;
+
+    if (s_samples) {
+        net_log("[TOUCH] i2c=%lu/s samples=%lu drops=%lu\n",
+                (unsigned long)((reads - s_reads_at_report) * 1000u / dt),
+                (unsigned long)s_samples, (unsigned long)s_drops);
+        touch_lat_report();
+    }
+    s_report_ms       = now;
+    s_reads_at_report = reads;
+#endif
+}
@@ -0,0 +1,63 @@
+#pragma once
+/* =====================================================================
+ *  touch_ring.h — AutoDine V4.0 touch sample queue + latency harness
+ *
+ *  Single-producer / single-consumer lock-free ring between the touch
+ *  task (GT911 INT or fallback poller, the only I2C reader) and LVGL's
+ *  read_cb on the UI task, which drains it without touching the bus.
+ *
+ *  Every press / release is followed through four timestamps:
+ *
+ *    sample   read from the GT911 (or injected)
+ *    read     handed to LVGL by my_touchpad_read
+ *    cb       first TOUCH_LAT_MARK() in an event callback after it
+ *    flush    end of the first refresh after that callback
+ *
+ *  and the stage distributions are logged every TOUCH_STATS_MS.
+ *  Synthetic taps (touch_inject_tap) enter through the same read path.
+ * ===================================================================== */
+#include "app_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOUCH_RING_LEN  32   /* power of two */
+
+typedef struct {
+    int16_t  x, y;
+    uint8_t  pressed;
+    uint8_t  synthetic;      /* from touch_inject_tap, not the panel */
+    uint32_t t_us;           /* when the sample was read / injected */
+} touch_sample_t;
+
+/* Producer (touch task) */
+bool touch_ring_push(int16_t x, int16_t y, bool pressed);
+void touch_ring_note_read(void);          /* one I2C read done */
+
+/* Consumer (UI task) */
+bool touch_ring_pop(touch_sample_t *out);            /* synthetic first */
+bool touch_ring_pending(void);
+void touch_ring_delivered(const touch_sample_t *s);  /* handed to LVGL */
+void touch_ring_flushed(void);                       /* refresh done   */
+void touch_ring_tick(void);               /* logs every TOUCH_STATS_MS */
+void touch_lat_report(void);              /* log the report now        */
+
+/* Queue `count` taps at (x, y), TOUCH_SYN_TAP_MS apart. UI task.
+ * Returns the number actually queued. */
+int  touch_inject_tap(int16_t x, int16_t y, int count);
+
+/* Tag the interaction in flight; call from LVGL event callbacks */
+void touch_lat_mark(const char *tag);
+
+#if TOUCH_LAT_HARNESS
+#define TOUCH_LAT_MARK(tag)  touch_lat_mark(tag)
+#else
+#define TOUCH_LAT_MARK(tag)  ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
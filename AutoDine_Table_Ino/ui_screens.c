@@ -3,30 +3,33 @@
  *  Main UI logic and screen definitions.
  * ===================================================================== */
 #include "ui_screens.h"
+#include "ui_theme.h"
 #include "state_machine.h"
 #include "cart.h"
+#include "menu_model.h"
 #include "autodine_net.h"
 #include "app_config.h"
 #include "hardware_compat.h"
+#include "anim_governor.h"
+#include "touch_ring.h"
+#include "bill_split.h"
+#include "bill_ledger.h"
+#include "session_store.h"
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-/* ---- THEME / COLORS (WOW Aesthetics) ----------------------- */
-#define COL_BG       lv_color_hex(0x020617) /* Deep Navy           */
-#define COL_BG2      lv_color_hex(0x0F172A) /* Slate Gradient      */
-#define COL_CARD     lv_color_hex(0x0F172A) /* Slate Navy          */
-#define COL_CARD2    lv_color_hex(0x1E293B) /* Lighter Slate       */
-#define COL_AMBER    lv_color_hex(0xF59E0B) /* Premium Gold        */
-#define COL_AMBER2   lv_color_hex(0xD97706) /* Dimmed Gold         */
-#define COL_EMERALD  lv_color_hex(0x10B981) /* Success Emerald     */
-#define COL_SUCCESS  lv_color_hex(0x10B981) /* (Alias)             */
-#define COL_WHITE    lv_color_hex(0xF8FAFC) /* Off White           */
-#define COL_GREY     lv_color_hex(0x64748B) /* Slate Grey          */
-#define COL_ERROR    lv_color_hex(0xEF4444) /* Error Red           */
-#define COL_INFO     lv_color_hex(0x3B82F6) /* Info Blue           */
-#define COL_DARK     lv_color_hex(0x020617) /* Pure Dark           */
+#ifdef ARDUINO
+extern unsigned long micros(void);
+#else
+#include <time.h>
+/* Host builds (AutoDine_Table_Sim): CPU time is what we want to measure */
+static unsigned long micros(void)
+{
+    return (unsigned long)((unsigned long long)clock() * 1000000ull / CLOCKS_PER_SEC);
+}
+#endif
 
 /* Map missing/non-standard LVGL symbols to ASCII/text fallbacks */
 #define LV_SYMBOL_STAR   "*"
@@ -37,14 +40,9 @@
 /* ---- Global handles ---------------------------------------- */
 /* BUG 2: g_order_id managed via sm_get_order_id()/sm_set_order_id() */
 static bool  g_wifi_ok      = false;
-int          g_pending_buzz = 0;
 
 /* ---- Append-mode / Razorpay / Feedback state --------------- */
 static bool  g_append_mode  = false; 
-static bool  g_goto_menu    = false; 
-static bool  g_goto_splash  = false;
-static bool  g_pending_upi_fetch = false;
-static bool  g_pending_upi_poll  = false;
 static char  g_razorpay_url[512] = ""; 
 static char  g_last_status[32]  = {0};  
 static lv_obj_t *lbl_waiter_status = NULL; 
@@ -52,19 +50,66 @@ static int   g_stars        = 0;     /* manual 1-5 feedback stars       */
 static int   g_star_rating  = 0;     /* 1-5 feedback stars              */
 static int   fb_seconds     = 20;    /* feedback countdown seconds      */
 static int   upi_timeout_count = 0;  /* 3s polls, 100 = 5 minutes       */
-static bool  g_pending_food_served = false; /* deferred serving update */
 static int   g_total_bill_rupees   = 0;     /* global store for payment screens */
+/* Split bill: groups from the last bill, and the one being paid
+ * (BILL_SEAT_ALL = whole table). g_pay_seat is read by the net task. */
+static bill_split_t  s_split;
+static volatile int  g_pay_seat = BILL_SEAT_ALL;
+/* Everything this table has submitted, so the bill opens without waiting
+ * for the server (bill_ledger.c). s_bill_local: the bill screen shows
+ * the ledger and the server's bill has not come back yet. */
+static bill_ledger_t s_ledger;
+static bool          s_bill_local = false;
+static uint32_t      s_bill_local_ms;
+#if PREFETCH_ENABLE
+/* Prefetch: the bill while the guest eats, the payment link once the
+ * bill is up. Results wait here for the screen that needs them.
+ * s_pf_gen moves on whenever the amount owed can change (append, new
+ * session) and a result from an older generation is dropped. */
+static uint32_t      s_pf_gen;
+static char         *s_pf_bill;            /* preview bill JSON, owned */
+static int           s_pf_bill_oid;
+static char          s_pf_link[512];       /* qr_url, "" = none */
+static int           s_pf_link_oid, s_pf_link_seat, s_pf_link_paise;
+static volatile bool s_pf_bill_busy = false;
+static volatile bool s_pf_link_busy = false;
+static void prefetch_link(void);
+static void prefetch_invalidate(void);
+#endif
+#if SESSION_RESUME
+/* Session snapshot (session_store.c): the last one handed to the net
+ * task, so an unchanged session is never rewritten. s_resume holds the
+ * cart of a restored session until the menu arrives to price it. */
+static session_snapshot_t s_sess_last;
+static int                s_sess_last_len;
+static session_snapshot_t s_resume;
+static volatile int       s_resume_check_oid;   /* net task re-checks this order */
+static uint32_t           s_resume_check_ms;
+#endif
 
 static lv_timer_t *poll_timer      = NULL; 
 static lv_timer_t *upi_poll_timer  = NULL; 
 static lv_timer_t *cash_poll_timer = NULL; 
 static lv_timer_t *feedback_timer  = NULL; 
 
-/* Timer callback to auto-delete an object (e.g., a toast) after a delay */
+/* Timer callback to auto-delete an object (e.g., a toast) after a delay.
+ * The timer itself is removed by auto_del_obj_deleted_cb. */
 static void auto_del_obj_timer_cb(lv_timer_t *t)
 {
     if (t->user_data) lv_obj_del((lv_obj_t *)t->user_data);
-    lv_timer_del(t);
+}
+
+/* If the object goes first (its screen was evicted), drop the timer too */
+static void auto_del_obj_deleted_cb(lv_event_t *e)
+{
+    lv_timer_t *t = lv_event_get_user_data(e);
+    if (t) lv_timer_del(t);
+}
+
+static void arm_auto_del(lv_obj_t *obj, uint32_t delay)
+{
+    lv_timer_t *t = lv_timer_create(auto_del_obj_timer_cb, delay, (void*)obj);
+    if (t) lv_obj_add_event_cb(obj, auto_del_obj_deleted_cb, LV_EVENT_DELETE, t);
 }
 
 /* LVGL Animation Wrappers (Needed because style functions take 3 args, but anims only pass 2) */
@@ -77,6 +122,9 @@ static void anim_translate_y_cb(void *var, int32_t v) {
 static void anim_opa_cb(void *var, int32_t v) {
     lv_obj_set_style_opa((lv_obj_t *)var, v, 0);
 }
+static void anim_border_opa_cb(void *var, int32_t v) {
+    lv_obj_set_style_border_opa((lv_obj_t *)var, (lv_opa_t)v, 0);
+}
 
 /* NEW: Generic Toast with auto-delete */
 static void create_toast(const char *title, const char *msg, uint32_t delay)
@@ -84,28 +132,21 @@ static void create_toast(const char *title, const char *msg, uint32_t delay)
     lv_obj_t *toast = lv_obj_create(lv_scr_act());
     lv_obj_set_size(toast, 640, 68);
     lv_obj_align(toast, LV_ALIGN_TOP_MID, 0, 20);
-    lv_obj_set_style_bg_color(toast, lv_color_hex(0xEF4444), 0); /* Red */
-    lv_obj_set_style_bg_opa(toast, LV_OPA_COVER, 0);
-    lv_obj_set_style_radius(toast, 12, 0);
-    lv_obj_set_style_border_color(toast, lv_color_hex(0xFFFFFF), 0);
-    lv_obj_set_style_border_width(toast, 1, 0);
-    lv_obj_set_style_shadow_width(toast, 20, 0);
-    lv_obj_set_style_shadow_opa(toast, 80, 0);
+    lv_obj_add_style(toast, ui_theme_style(UI_STYLE_TOAST), 0); /* Red */
     lv_obj_clear_flag(toast, LV_OBJ_FLAG_SCROLLABLE);
 
     lv_obj_t *tl = lv_label_create(toast);
     lv_label_set_text_fmt(tl, "#FFFFFF %s#", title);
     lv_label_set_recolor(tl, true);
-    lv_obj_set_style_text_font(tl, &lv_font_montserrat_14, 0);
+    lv_obj_add_style(tl, ui_theme_font(&lv_font_montserrat_14), 0);
     lv_obj_align(tl, LV_ALIGN_TOP_MID, 0, -2);
 
     lv_obj_t *ml = lv_label_create(toast);
     lv_label_set_text(ml, msg);
-    lv_obj_set_style_text_font(ml, &lv_font_montserrat_12, 0);
+    lv_obj_add_style(ml, ui_theme_font(&lv_font_montserrat_12), 0);
     lv_obj_align(ml, LV_ALIGN_BOTTOM_MID, 0, 2);
 
-    lv_timer_t *tt = lv_timer_create(auto_del_obj_timer_cb, delay, (void*)toast);
-    if (tt) lv_timer_set_repeat_count(tt, 1);
+    arm_auto_del(toast, delay);
 }
 
 static void safe_timer_del(lv_timer_t **t)
@@ -118,6 +159,7 @@ static void safe_timer_del(lv_timer_t **t)
 
 static lv_obj_t *lbl_append_banner = NULL; /* orange append-mode banner */
 static lv_obj_t *lbl_cart_title    = NULL; /* "YOUR ORDER" / "NEW ITEMS" */
+static lv_obj_t *lbl_cart_seat     = NULL; /* "For: Seat 2" — active cart seat */
 static lv_obj_t *btn_place_order   = NULL; /* reference so we can re-label it */
 
 /* Screen containers */
@@ -125,6 +167,7 @@ static lv_obj_t *scr_splash       = NULL;
 static lv_obj_t *scr_menu         = NULL;
 static lv_obj_t *scr_placed       = NULL;
 static lv_obj_t *scr_ready        = NULL;
+static lv_obj_t *ready_card       = NULL;   /* bounced while food is ready */
 static lv_obj_t *scr_food_served  = NULL;
 static lv_obj_t *scr_bill         = NULL;
 static lv_obj_t *scr_paysel       = NULL;
@@ -140,14 +183,15 @@ static lv_obj_t *lbl_cart_count   = NULL;
 static lv_obj_t *menu_grid        = NULL;
 static lv_obj_t *lbl_bill_body    = NULL;
 static lv_obj_t *lbl_paysel_amount = NULL;
+static lv_obj_t *paysel_seat_row  = NULL;
 static lv_obj_t *lbl_upi_amount   = NULL;
 static lv_obj_t *lbl_cash_amount  = NULL;
 static lv_obj_t *lbl_fb_countdown = NULL;
 static lv_obj_t *lbl_payment_result = NULL;
 static lv_obj_t *lbl_order_id_placed = NULL;
-static bool g_pending_cash_select = false;
-static bool g_pending_wifi_check = false;
 static uint32_t last_wifi_ms      = 0;
+static uint32_t last_avail_ms     = 0;
+static uint32_t last_menu_ms      = 0;
 static lv_obj_t *feedback_ta      = NULL;
 static lv_obj_t *star_btns[5]     = {NULL};
 static lv_obj_t *lbl_star_rating  = NULL;
@@ -192,13 +236,16 @@ static const char *find_obj_end(const char *start)
     return NULL;
 }
 
+/* Buzzer patterns are HTTP calls: queue them for the net task */
+static void buzz_job(void *arg) { net_buzz((int)(intptr_t)arg); }
+static void ui_buzz(int pattern) { net_post(buzz_job, (void *)(intptr_t)pattern); }
+
+/* The make_* helpers attach shared ui_theme styles by reference; callers
+ * may still set local properties on top for one-off tweaks. */
 static lv_obj_t *make_screen(void)
 {
     lv_obj_t *s = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(s, COL_BG, 0);
-    lv_obj_set_style_bg_grad_color(s, COL_BG2, 0);
-    lv_obj_set_style_bg_grad_dir(s, LV_GRAD_DIR_VER, 0);
-    lv_obj_set_style_bg_opa(s, LV_OPA_COVER, 0);
+    lv_obj_add_style(s, ui_theme_style(UI_STYLE_SCREEN), 0);
     lv_obj_clear_flag(s, LV_OBJ_FLAG_SCROLLABLE);
     return s;
 }
@@ -207,15 +254,7 @@ static lv_obj_t *make_card(lv_obj_t *parent, int w, int h)
 {
     lv_obj_t *c = lv_obj_create(parent);
     lv_obj_set_size(c, w, h);
-    lv_obj_set_style_bg_color(c, COL_CARD, 0);
-    lv_obj_set_style_bg_opa(c, 235, 0);
-    lv_obj_set_style_border_width(c, 1, 0);
-    lv_obj_set_style_border_color(c, lv_color_hex(0x334155), 0);
-    lv_obj_set_style_radius(c, 24, 0);
-    lv_obj_set_style_pad_all(c, 16, 0);
-    lv_obj_set_style_shadow_width(c, 30, 0);
-    lv_obj_set_style_shadow_color(c, lv_color_hex(0x000000), 0);
-    lv_obj_set_style_shadow_opa(c, 100, 0);
+    lv_obj_add_style(c, ui_theme_style(UI_STYLE_CARD), 0);
     return c;
 }
 
@@ -225,10 +264,7 @@ static void add_card_accent(lv_obj_t *card, int card_w)
     lv_obj_t *acc = lv_obj_create(card);
     lv_obj_set_size(acc, card_w - 28, 3);
     lv_obj_set_pos(acc, 0, -14);
-    lv_obj_set_style_bg_color(acc, COL_AMBER, 0);
-    lv_obj_set_style_bg_opa(acc, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_opa(acc, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_radius(acc, 2, 0);
+    lv_obj_add_style(acc, ui_theme_style(UI_STYLE_ACCENT), 0);
 }
 
 static lv_obj_t *make_label(lv_obj_t *parent, const char *txt,
@@ -236,8 +272,13 @@ static lv_obj_t *make_label(lv_obj_t *parent, const char *txt,
 {
     lv_obj_t *l = lv_label_create(parent);
     lv_label_set_text(l, txt);
-    lv_obj_set_style_text_color(l, col, 0);
-    if (font) lv_obj_set_style_text_font(l, font, 0);
+    lv_style_t *st = ui_theme_text(col, font);
+    if (st) {
+        lv_obj_add_style(l, st, 0);
+    } else {
+        lv_obj_set_style_text_color(l, col, 0);
+        if (font) lv_obj_set_style_text_font(l, font, 0);
+    }
     return l;
 }
 
@@ -246,66 +287,251 @@ static lv_obj_t *make_amber_btn(lv_obj_t *parent, const char *txt,
 {
     lv_obj_t *btn = lv_btn_create(parent);
     lv_obj_set_size(btn, w, h);
-    lv_obj_set_style_bg_color(btn, COL_AMBER, 0);
-    lv_obj_set_style_bg_grad_color(btn, COL_AMBER2, 0);
-    lv_obj_set_style_bg_grad_dir(btn, LV_GRAD_DIR_HOR, 0);
-    lv_obj_set_style_bg_color(btn, COL_AMBER2, LV_STATE_PRESSED);
-    lv_obj_set_style_radius(btn, 12, 0);
-    lv_obj_set_style_border_opa(btn, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_shadow_width(btn, 10, 0);
-    lv_obj_set_style_shadow_color(btn, COL_AMBER, 0);
-    lv_obj_set_style_shadow_opa(btn, 60, 0);
-    lv_obj_t *lbl = lv_label_create(btn);
-    lv_label_set_text(lbl, txt);
-    lv_obj_set_style_text_color(lbl, lv_color_hex(0x0A0A0A), 0);
-    lv_obj_set_style_text_font(lbl, &lv_font_montserrat_16, 0);
+    lv_obj_add_style(btn, ui_theme_style(UI_STYLE_BTN_AMBER), 0);
+    lv_obj_add_style(btn, ui_theme_style(UI_STYLE_BTN_AMBER_PR), LV_STATE_PRESSED);
+    lv_obj_t *lbl = make_label(btn, txt, COL_BTN_TEXT, &lv_font_montserrat_16);
     lv_obj_center(lbl);
     return btn;
 }
 
+/* ---- Cart panel ----------------------------------------------------
+ * The panel mirrors the cart row-for-row (both are in insertion order),
+ * so a +/- tap only rewrites the one row whose qty changed; rows are
+ * created or deleted only when an item enters or leaves the cart. */
+typedef struct {
+    int         id;
+    int         seat;
+    int         qty;      /* qty currently shown */
+    lv_obj_t   *row;
+    lv_obj_t   *lbl;
+    lv_style_t *alt;      /* UI_STYLE_CART_ROW_ALT when on an odd line */
+} cart_row_t;
+
+static cart_row_t s_cart_rows[CART_HARD_CAP];
+static int        s_cart_row_count = 0;
+static int        s_shown_total    = -1;   /* last rendered grand total (paise) */
+static int        s_shown_badge    = -1;   /* last rendered item count          */
+
+static void cart_row_set_text(cart_row_t *r, const cart_item_t *it)
+{
+    char line[104];
+    if (it->seat)
+        snprintf(line, sizeof(line), "S%d  %s x%d  Rs. %d", it->seat,
+                 it->name, it->qty, it->price_paise * it->qty / 100);
+    else
+        snprintf(line, sizeof(line), "%s x%d  Rs. %d",
+                 it->name, it->qty, it->price_paise * it->qty / 100);
+    lv_label_set_text(r->lbl, line);
+    r->qty = it->qty;
+}
+
+static void cart_row_set_stripe(cart_row_t *r, int line_no)
+{
+    ui_theme_swap(r->row, &r->alt,
+                  (line_no % 2) ? ui_theme_style(UI_STYLE_CART_ROW_ALT) : NULL);
+}
+
+static void cart_row_create(const cart_item_t *it, int line_no)
+{
+    cart_row_t *r = &s_cart_rows[s_cart_row_count++];
+    r->id   = it->id;
+    r->seat = it->seat;
+    r->alt  = NULL;
+    r->row = lv_obj_create(cart_list);
+    lv_obj_set_size(r->row, 186, LV_SIZE_CONTENT);
+    lv_obj_add_style(r->row, ui_theme_style(UI_STYLE_CART_ROW), 0);
+    r->lbl = make_label(r->row, "", COL_WHITE, &lv_font_montserrat_12);
+    lv_label_set_long_mode(r->lbl, LV_LABEL_LONG_WRAP);
+    lv_obj_set_width(r->lbl, 178);
+    cart_row_set_text(r, it);
+    cart_row_set_stripe(r, line_no);
+}
+
+static void cart_row_delete(int idx)
+{
+    lv_obj_del(s_cart_rows[idx].row);
+    memmove(&s_cart_rows[idx], &s_cart_rows[idx + 1],
+            sizeof(cart_row_t) * (s_cart_row_count - idx - 1));
+    s_cart_row_count--;
+}
+
+/* ---- Live cart (LIVE_CART_SYNC) ----
+ * The cart is diffed against what the server was last sent and the
+ * difference goes out as one numbered batch per LIVE_CART_BATCH_MS, so
+ * the kitchen sees demand forming and placing the order is a commit.
+ * Diffing instead of hooking +/- catches every path that edits the cart
+ * (clear, resume, menu items going unavailable). Batches leave in order
+ * on the net task; any failure ends live sync for this cart and the
+ * order falls back to posting the full cart. UI task only. */
+#if LIVE_CART_SYNC
+typedef struct {
+    int id, seat, qty;           /* cart_item_t ranges: dq stays exact */
+} live_line_t;
+
+static live_line_t s_lc_synced[CART_HARD_CAP];
+static int  s_lc_synced_n;
+static int  s_lc_cart_no;        /* bumps per cart: one server doc each */
+static int  s_lc_seq;            /* last batch sent                     */
+static bool s_lc_dirty;
+static bool s_lc_broken;
+static char s_lc_id[40];
+
+typedef struct {
+    int  cart_no;
+    char json[];
+} live_delta_req_t;
+
+static void live_cart_new(void)
+{
+    s_lc_cart_no++;
+    snprintf(s_lc_id, sizeof(s_lc_id), "t%d-%lu-c%d", TABLE_NUMBER,
+             (unsigned long)session_store_boot_epoch(), s_lc_cart_no);
+    s_lc_synced_n = 0;
+    s_lc_seq      = 0;
+    s_lc_dirty    = cart_item_count() > 0;
+    s_lc_broken   = false;
+}
+
+static void live_delta_fail(void *arg)   /* UI task */
+{
+    if ((int)(intptr_t)arg != s_lc_cart_no) return;   /* an older cart */
+    if (!s_lc_broken) net_log("[CART] live sync off for %s\n", s_lc_id);
+    s_lc_broken = true;
+}
+
+static void live_delta_job(void *arg)    /* net task */
+{
+    live_delta_req_t *r = (live_delta_req_t *)arg;
+    if (net_cart_delta(r->json) != 0)
+        ui_post(live_delta_fail, (void *)(intptr_t)r->cart_no);
+    free(r);
+}
+
+static int live_synced_find(int id, int seat)
+{
+    for (int i = 0; i < s_lc_synced_n; i++)
+        if (s_lc_synced[i].id == id && s_lc_synced[i].seat == seat) return i;
+    return -1;
+}
+
+/* Send what changed since the last batch (nothing if nothing did) */
+static void live_cart_flush(void)
+{
+    if (!s_lc_dirty || s_lc_broken) return;
+    s_lc_dirty = false;
+
+    int count = cart_item_count();
+    size_t cap = 128 + (size_t)(count + s_lc_synced_n) * (2 * CART_MAX_NAME + 64);
+    live_delta_req_t *r = (live_delta_req_t *)malloc(sizeof(*r) + cap);
+    if (!r) { s_lc_broken = true; return; }
+    char *buf = r->json;
+    int off = snprintf(buf, cap, "{\"cart_id\":\"%s\",\"table\":%d,\"seq\":%d,\"deltas\":[",
+                       s_lc_id, TABLE_NUMBER, s_lc_seq + 1);
+    int n = 0;
+    static bool seen[CART_HARD_CAP];
+    memset(seen, 0, sizeof(seen));
+    for (const cart_item_t *it = cart_first(); it; it = cart_next(it)) {
+        int k  = live_synced_find(it->id, it->seat);
+        int dq = it->qty - (k >= 0 ? s_lc_synced[k].qty : 0);
+        if (k >= 0) seen[k] = true;
+        if (dq == 0) continue;
+        char name[2 * CART_MAX_NAME];
+        net_json_escape(it->name, name, sizeof(name));
+        off += snprintf(buf + off, cap - off,
+                        "%s{\"id\":%d,\"seat\":%d,\"dq\":%d,\"name\":\"%s\",\"price\":%d}",
+                        n++ ? "," : "", it->id, it->seat, dq, name, it->price_paise / 100);
+    }
+    for (int k = 0; k < s_lc_synced_n; k++) {
+        if (seen[k]) continue;             /* line left the cart */
+        off += snprintf(buf + off, cap - off, "%s{\"id\":%d,\"seat\":%d,\"dq\":%d}",
+                        n++ ? "," : "", s_lc_synced[k].id, s_lc_synced[k].seat,
+                        -s_lc_synced[k].qty);
+    }
+    snprintf(buf + off, cap - off, "]}");
+    if (n == 0) { free(r); return; }
+
+    /* The server holds this from now on, whatever the reply */
+    s_lc_seq++;
+    s_lc_synced_n = 0;
+    for (const cart_item_t *it = cart_first(); it; it = cart_next(it)) {
+        live_line_t *ln = &s_lc_synced[s_lc_synced_n++];
+        ln->id   = it->id;
+        ln->seat = it->seat;
+        ln->qty  = it->qty;
+    }
+    r->cart_no = s_lc_cart_no;
+    if (!net_post(live_delta_job, r)) { free(r); s_lc_broken = true; }
+}
+
+static void live_cart_timer_cb(lv_timer_t *t) { (void)t; live_cart_flush(); }
+
+/* Rupees, rounded per line exactly as the deltas carried the price */
+static int live_cart_subtotal(void)
+{
+    int sum = 0;
+    for (const cart_item_t *it = cart_first(); it; it = cart_next(it))
+        sum += it->qty * (it->price_paise / 100);
+    return sum;
+}
+#endif
+
 static void refresh_cart_panel(void)
 {
+#if LIVE_CART_SYNC
+    s_lc_dirty = true;             /* next batch diffs it */
+#endif
     if (!cart_list || !lbl_cart_total) return;
-    lv_obj_clean(cart_list);
-    const cart_item_t *items = cart_get_items();
-    int count = cart_item_count();
-    for (int i = 0; i < count; i++) {
-        lv_obj_t *row = lv_obj_create(cart_list);
-        lv_obj_set_size(row, 186, LV_SIZE_CONTENT);
-        lv_obj_set_style_bg_color(row, (i % 2 == 0) ? COL_CARD : COL_CARD2, 0);
-        lv_obj_set_style_bg_opa(row, LV_OPA_COVER, 0);
-        lv_obj_set_style_border_opa(row, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_radius(row, 6, 0);
-        lv_obj_set_style_pad_all(row, 4, 0);
-
-        char line[96];
-        snprintf(line, sizeof(line), "%s x%d  Rs. %d",
-                 items[i].name, items[i].qty,
-                 items[i].price_paise * items[i].qty / 100);
-        lv_obj_t *lbl = lv_label_create(row);
-        lv_label_set_text(lbl, line);
-        lv_obj_set_style_text_color(lbl, COL_WHITE, 0);
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_12, 0);
-        lv_label_set_long_mode(lbl, LV_LABEL_LONG_WRAP);
-        lv_obj_set_width(lbl, 178);
-    }
-    char total[48];
-    snprintf(total, sizeof(total), "Total: Rs. %d",
-             cart_grand_total_paise() / 100);
-    lv_label_set_text(lbl_cart_total, total);
+#if UI_CART_TIMING
+    unsigned long t0 = micros();
+#endif
+    const cart_item_t *it = cart_first();     /* NULL past the end */
+    for (int i = 0; it || i < s_cart_row_count; ) {
+        if (i < s_cart_row_count &&
+            (!it || s_cart_rows[i].id != it->id || s_cart_rows[i].seat != it->seat)) {
+            if (cart_get_qty_seat(s_cart_rows[i].id, s_cart_rows[i].seat) == 0) {
+                cart_row_delete(i);        /* item left the cart */
+                continue;
+            }
+            /* Orders diverged (should not happen) — resync from here */
+            while (s_cart_row_count > i) cart_row_delete(s_cart_row_count - 1);
+        }
+        if (!it) break;
+        if (i >= s_cart_row_count) {
+            cart_row_create(it, i);
+        } else {
+            if (s_cart_rows[i].qty != it->qty)
+                cart_row_set_text(&s_cart_rows[i], it);
+            cart_row_set_stripe(&s_cart_rows[i], i);
+        }
+        i++;
+        it = cart_next(it);
+    }
+
+    int total = cart_grand_total_paise();
+    if (total != s_shown_total) {
+        s_shown_total = total;
+        char buf[48];
+        snprintf(buf, sizeof(buf), "Total: Rs. %d", total / 100);
+        lv_label_set_text(lbl_cart_total, buf);
+    }
 
     /* Update topbar cart count badge */
-    if (lbl_cart_count) {
-        char badge[24];
-        snprintf(badge, sizeof(badge), "Cart: %d", cart_total_items());
-        lv_label_set_text(lbl_cart_count, badge);
+    int badge = cart_total_items();
+    if (lbl_cart_count && badge != s_shown_badge) {
+        s_shown_badge = badge;
+        char buf[24];
+        snprintf(buf, sizeof(buf), "Cart: %d", badge);
+        lv_label_set_text(lbl_cart_count, buf);
     }
+#if UI_CART_TIMING
+    net_log("[CART] refresh %lu us (%d rows)\n", micros() - t0, s_cart_row_count);
+#endif
 }
 
 /* =====================================================================
  *  SCREEN 1 — SPLASH
  * ===================================================================== */
-static void splash_tap_cb(lv_event_t *e) { sm_set(STATE_MENU); }
+static void splash_tap_cb(lv_event_t *e) { TOUCH_LAT_MARK("splash"); sm_post(EV_START); }
 
 static void build_splash(void)
 {
@@ -380,41 +606,214 @@ static void build_splash(void)
 /* =====================================================================
  *  SCREEN 2 — MENU
  * ===================================================================== */
+
+/* ---- Virtualized menu grid ------------------------------------------
+ * Only rows inside the viewport (plus one card row of margin above and
+ * below) own widgets. A fixed pool of cards and category headers is
+ * rebound to menu_model items as menu_grid scrolls, so object count and
+ * LVGL heap stay flat however long the menu is. */
+#define MENU_CARD_W          274
+#define MENU_CARD_H          145
+#define MENU_HDR_W           550
+#define MENU_HDR_H           40
+#define MENU_GAP             6
+#define MENU_COLS            2
+#define MENU_POOL_CARDS      16
+#define MENU_POOL_HDRS       8
+#define MENU_VIRT_MARGIN_PX  (MENU_CARD_H + MENU_GAP)
+/* With card skins the first row starts one skin margin down so the
+ * shadow of the top row does not extend the scroll range upwards */
+#define MENU_TOP_Y           (UI_CARD_SKINS ? UI_SKIN_MARGIN : 0)
+
+typedef struct {
+    lv_obj_t *root;       /* positioned/hidden object: skin image or card */
+    lv_coord_t skin_m;    /* root -> card offset (UI_SKIN_MARGIN or 0)    */
+    lv_obj_t *card;
+    lv_obj_t *cat_bar;
+    lv_obj_t *dot;
+    lv_obj_t *lbl_name;
+    lv_obj_t *lbl_desc;
+    lv_obj_t *lbl_price;
+    lv_obj_t *overlay;
+    lv_style_t *cat_style;  /* shared styles currently attached */
+    lv_style_t *dot_style;
+    int       item_idx;   /* menu_model index, -1 = free */
+    int       row;        /* bound layout row,  -1 = free */
+    int       col;
+    int       shown_id;   /* item the widgets currently display, 0 = none */
+    uint32_t  shown_rev;  /* menu_item_t.rev at that time */
+} menu_card_slot_t;
+
+typedef struct {
+    lv_obj_t *hdr;
+    lv_obj_t *lbl;
+    lv_style_t *txt_style;
+    int       row;        /* bound layout row, -1 = free */
+} menu_hdr_slot_t;
+
 typedef struct {
-    int  id;
-    int  price_paise;
-    bool is_veg;
-    char name[CART_MAX_NAME];
-} menu_item_ctx_t;
+    int32_t y;
+    int16_t h;
+    int16_t n_items;           /* 0 = category header row            */
+    int     first_item;        /* model index of first card / header  */
+    int8_t  slot[MENU_COLS];   /* bound pool slot per column, -1 none */
+} menu_row_t;
+
+static menu_card_slot_t s_card_pool[MENU_POOL_CARDS];
+static menu_hdr_slot_t  s_hdr_pool[MENU_POOL_HDRS];
+static menu_row_t      *s_rows      = NULL;
+static int              s_row_count = 0;
+static int              s_row_cap   = 0;
+static lv_obj_t        *menu_spacer = NULL;  /* sets grid scroll extent */
 
 static void qty_plus_cb(lv_event_t *e)
 {
-    menu_item_ctx_t *ctx = lv_event_get_user_data(e);
-    if (!ctx) return;
-    cart_add(ctx->id, ctx->name, ctx->price_paise, ctx->is_veg);
+    menu_card_slot_t *slot = lv_event_get_user_data(e);
+    const menu_item_t *it = slot ? menu_model_get(slot->item_idx) : NULL;
+    if (!it) return;
+    TOUCH_LAT_MARK("qty+");
+    if (!cart_add(it->id, it->name, it->price_paise, it->is_veg)) {
+        create_toast("CART FULL", "Place this order, then add more.", 2500);
+        return;
+    }
     refresh_cart_panel();
 }
 
 static void qty_minus_cb(lv_event_t *e)
 {
-    menu_item_ctx_t *ctx = lv_event_get_user_data(e);
-    if (!ctx) return;
-    cart_remove_one(ctx->id);
+    menu_card_slot_t *slot = lv_event_get_user_data(e);
+    const menu_item_t *it = slot ? menu_model_get(slot->item_idx) : NULL;
+    if (!it) return;
+    TOUCH_LAT_MARK("qty-");
+    cart_remove_one(it->id);
     refresh_cart_panel();
 }
 
+/* ---- Place order: body built here, HTTP on the net task ---- */
+typedef struct {
+    bool  append;
+    int   oid;     /* in: order to append to / out: new order id */
+    int   err;
+    char *body;    /* append: items array; new: full order JSON; freed by _done */
+#if LIVE_CART_SYNC
+    bool  live;    /* server holds the cart: commit it, body is the fallback */
+    int   seq, items, subtotal;
+    char  cart_id[40];   /* also set when live sync broke: the post drops it */
+#endif
+    char  op[NET_OP_ID_LEN];   /* "" = minted by the job */
+} place_order_req_t;
+
+static volatile bool s_placing = false;
+
+/* One op id per logical order: a re-tap after every retry failed sends
+ * the same id, so the server replays instead of printing a second
+ * ticket. A changed cart is a new order and gets a new id. UI task. */
+static char     s_order_op[NET_OP_ID_LEN];
+static uint32_t s_order_op_cart;
+
+static uint32_t cart_fingerprint(void)
+{
+    uint32_t h = 2166136261u ^ (uint32_t)g_append_mode;
+    for (const cart_item_t *it = cart_first(); it; it = cart_next(it)) {
+        h = (h ^ (uint32_t)it->id)  * 16777619u;
+        h = (h ^ it->seat)          * 16777619u;
+        h = (h ^ (uint32_t)it->qty) * 16777619u;
+    }
+    return h;
+}
+
+static void place_order_done(void *arg)   /* UI task */
+{
+    place_order_req_t *req = (place_order_req_t *)arg;
+    s_placing = false;  /* CRITICAL: always reset, even on failure */
+
+    bool accepted = req->err == 0 && (req->append || req->oid > 0);
+    /* Failed: keep the id for the guest's next tap on the same cart */
+    snprintf(s_order_op, sizeof(s_order_op), "%s", accepted ? "" : req->op);
+    if (accepted) {
+        /* Accepted: it is on the bill now */
+        if (!req->append) bill_ledger_reset(&s_ledger);
+        bill_ledger_add_json(&s_ledger, req->body);
+#if PREFETCH_ENABLE
+        prefetch_invalidate();    /* anything fetched is short of these items */
+#endif
+#if LIVE_CART_SYNC
+        live_cart_new();          /* committed; the cart is cleared below */
+#endif
+    }
+    if (req->append) {
+        if (req->err == 0) {
+            g_append_mode = false;
+            cart_clear();
+            sm_post(EV_ORDER_ACCEPTED);
+            /* poll_timer is restarted on entry to STATE_ORDER_PLACED */
+        } else {
+            create_toast("NOT ADDED", "Failed to add items. Try again.", 2500);
+        }
+    } else {
+        if (req->err == 0 && req->oid > 0) {
+            sm_set_order_id(req->oid);   /* BUG 2: canonical storage */
+            cart_clear(); /* clear cart so Add More starts fresh */
+            ui_buzz(1);
+            sm_post(EV_ORDER_ACCEPTED);
+        } else {
+            /* Show error feedback so user knows something went wrong */
+            create_toast("ORDER FAILED", "Check WiFi and try again.", 3000);
+        }
+    }
+    free(req->body);
+    free(req);
+}
+
+static void place_order_job(void *arg)    /* net task */
+{
+    place_order_req_t *req = (place_order_req_t *)arg;
+    if (!req->op[0]) net_op_id_new(req->op, sizeof(req->op));
+#if LIVE_CART_SYNC
+    if (req->live) {
+        int oid = -1;
+        req->err = net_commit_cart(req->cart_id, req->seq, req->append ? req->oid : 0,
+                                   req->items, req->subtotal, req->op, &oid);
+        if (!req->append) req->oid = oid;
+        if (req->err != -2) {
+            if (!ui_post(place_order_done, req)) { s_placing = false; free(req->body); free(req); }
+            return;
+        }
+        net_log("[CART] commit refused, posting the full cart\n");
+    }
+    const char *cid = req->cart_id[0] ? req->cart_id : NULL;
+#else
+    const char *cid = NULL;
+#endif
+    if (req->append) {
+        req->err = net_append_order(req->oid, req->body, cid, req->op);
+    } else {
+        req->oid = -1;
+        req->err = net_place_order(req->body, cid, req->op, &req->oid);
+    }
+    /* body goes back with the result: on success it feeds the bill ledger */
+    if (!ui_post(place_order_done, req)) { s_placing = false; free(req->body); free(req); }
+}
+
 static void place_order_cb(lv_event_t *e)
 {
-    static bool placing = false;
-    if (placing || cart_item_count() == 0) return;
-    placing = true;
+    TOUCH_LAT_MARK("order");
+    if (s_placing || cart_item_count() == 0) return;
 
     char *json = cart_to_json();
-    if (!json) { placing = false; return; }
+    if (!json) return;
+
+    place_order_req_t *req = (place_order_req_t *)calloc(1, sizeof(*req));
+    if (!req) { free(json); return; }
+    req->append = g_append_mode;
+    uint32_t fp = cart_fingerprint();
+    if (fp != s_order_op_cart) s_order_op[0] = '\0';
+    s_order_op_cart = fp;
+    snprintf(req->op, sizeof(req->op), "%s", s_order_op);
 
     if (g_append_mode) {
         /* === APPEND MODE: add new items to existing order === */
-        int oid = sm_get_order_id();
+        req->oid = sm_get_order_id();
         /* Extract just the items array from cart_to_json() output.
          * cart_to_json() returns {"table":N,"items":[...]}.
          * We need the [...] array string for net_append_order(). */
@@ -448,74 +847,381 @@ static void place_order_cb(lv_event_t *e)
             arr[arr_len] = '\0';
         }
         free(json);
-        placing = false;
-        if (!arr) return;
-        int err = net_append_order(oid, arr);
-        free(arr);
-        if (err == 0) {
-            g_append_mode = false;
-            cart_clear();
-            sm_set(STATE_ORDER_PLACED);
-            /* poll_timer is restarted by ui_show_screen(STATE_ORDER_PLACED) */
-        } else {
-            /* Show red toast on failure */
-            lv_obj_t *toast = lv_obj_create(lv_scr_act());
-            lv_obj_set_size(toast, 640, 56);
-            lv_obj_align(toast, LV_ALIGN_BOTTOM_MID, 0, -16);
-            lv_obj_set_style_bg_color(toast, lv_color_hex(0xEF4444), 0);
-            lv_obj_set_style_bg_opa(toast, LV_OPA_COVER, 0);
-            lv_obj_set_style_radius(toast, 10, 0);
-            lv_obj_set_style_border_opa(toast, LV_OPA_TRANSP, 0);
-            lv_obj_t *tl = lv_label_create(toast);
-            lv_label_set_text(tl, "Failed to add items. Try again.");
-            lv_obj_set_style_text_color(tl, lv_color_hex(0xFFFFFF), 0);
-            lv_obj_set_style_text_font(tl, &lv_font_montserrat_14, 0);
-            lv_obj_center(tl);
-            /* Auto-delete toast after 2.5s */
-            lv_timer_t *tt = lv_timer_create(auto_del_obj_timer_cb, 2500, (void*)toast);
-            if (tt) lv_timer_set_repeat_count(tt, 1);
-        }
+        if (!arr) { free(req); return; }
+        req->body = arr;
     } else {
         /* === NORMAL MODE: create new order === */
-        int oid = -1;
-        int err = net_place_order(json, &oid);
-        free(json);
-        placing = false;  /* CRITICAL: always reset, even on failure */
-        if (err == 0 && oid > 0) {
-            sm_set_order_id(oid);   /* BUG 2: canonical storage */
-            cart_clear(); /* clear cart so Add More starts fresh */
-            net_buzz(1);
-            sm_set(STATE_ORDER_PLACED);
-        } else {
-            /* Show error feedback so user knows something went wrong */
-            lv_obj_t *toast = lv_obj_create(lv_scr_act());
-            lv_obj_set_size(toast, 640, 56);
-            lv_obj_align(toast, LV_ALIGN_BOTTOM_MID, 0, -16);
-            lv_obj_set_style_bg_color(toast, lv_color_hex(0xEF4444), 0);
-            lv_obj_set_style_bg_opa(toast, LV_OPA_COVER, 0);
-            lv_obj_set_style_radius(toast, 10, 0);
-            lv_obj_set_style_border_opa(toast, LV_OPA_TRANSP, 0);
-            lv_obj_t *tl = lv_label_create(toast);
-            lv_label_set_text(tl, "Order failed. Check WiFi and try again.");
-            lv_obj_set_style_text_color(tl, lv_color_hex(0xFFFFFF), 0);
-            lv_obj_set_style_text_font(tl, &lv_font_montserrat_14, 0);
-            lv_obj_center(tl);
-            lv_timer_t *tt = lv_timer_create(auto_del_obj_timer_cb, 3000, (void*)toast);
-            if (tt) lv_timer_set_repeat_count(tt, 1);
-        }
+        req->body = json;
+    }
+
+#if LIVE_CART_SYNC
+    /* Last edits go out first (same net queue, so they land before the
+     * commit); a refused batch makes the server's copy untrustworthy */
+    live_cart_flush();
+    if (s_lc_seq > 0)   /* the server has a copy, trusted or not */
+        snprintf(req->cart_id, sizeof(req->cart_id), "%s", s_lc_id);
+    if (!s_lc_broken && s_lc_seq > 0) {
+        req->live     = true;
+        req->seq      = s_lc_seq;
+        req->items    = cart_total_items();
+        req->subtotal = live_cart_subtotal();
+    }
+#endif
+
+    /* Network round-trip runs on the net task; the UI keeps rendering */
+    s_placing = true;
+    if (!net_post(place_order_job, req)) {
+        s_placing = false;
+        free(req->body);
+        free(req);
+        create_toast("BUSY", "Please try again.", 2000);
     }
 }
 
 static void clear_cart_cb(lv_event_t *e)
 {
+    TOUCH_LAT_MARK("clear");
     cart_clear();
     refresh_cart_panel();
 }
 
+/* Seat chip: cycles Shared -> Seat 1..CART_MAX_SEATS; new taps land there */
+static void cart_seat_label_update(void)
+{
+    if (!lbl_cart_seat) return;
+    char name[16], buf[40];
+    snprintf(buf, sizeof(buf), LV_SYMBOL_LOOP "  For: %s",
+             bill_seat_name(cart_get_seat(), name, sizeof(name)));
+    lv_label_set_text(lbl_cart_seat, buf);
+}
+
+static void cart_seat_cb(lv_event_t *e)
+{
+    TOUCH_LAT_MARK("seat");
+    cart_set_seat((cart_get_seat() + 1) % (CART_MAX_SEATS + 1));
+    cart_seat_label_update();
+}
+
 /* Bug 8 Fix: waiter call uses pattern 1 (not 2) */
 static void call_waiter_menu_cb(lv_event_t *e)
 {
-    g_pending_buzz = 1;
+    TOUCH_LAT_MARK("waiter");
+    ui_buzz(1);
+}
+
+/* Create one pooled menu card (hidden until bound to a model item).
+ * With UI_CARD_SKINS the card background and shadow come from a cached
+ * pre-rendered image; the card object itself is transparent. */
+static void menu_card_slot_init(menu_card_slot_t *slot)
+{
+    lv_obj_t *card;
+    const lv_img_dsc_t *skin = UI_CARD_SKINS ?
+        ui_theme_card_skin(MENU_CARD_W, MENU_CARD_H) : NULL;
+    if (skin) {
+        slot->root = lv_img_create(menu_grid);
+        lv_img_set_src(slot->root, skin);
+        slot->skin_m = UI_SKIN_MARGIN;
+        card = lv_obj_create(slot->root);
+        lv_obj_set_size(card, MENU_CARD_W, MENU_CARD_H);
+        lv_obj_set_pos(card, UI_SKIN_MARGIN, UI_SKIN_MARGIN);
+        lv_obj_add_style(card, ui_theme_style(UI_STYLE_CLEAR), 0);
+    } else {
+        card = make_card(menu_grid, MENU_CARD_W, MENU_CARD_H);
+        slot->root   = card;
+        slot->skin_m = 0;
+    }
+    lv_obj_add_style(card, ui_theme_style(UI_STYLE_CARD_COMPACT), 0);
+    lv_obj_clear_flag(card, LV_OBJ_FLAG_SCROLLABLE);
+    slot->card = card;
+
+    /* Category left-border (3px); colour style is attached by bind */
+    slot->cat_bar = lv_obj_create(card);
+    lv_obj_set_size(slot->cat_bar, 3, 129);
+    lv_obj_set_pos(slot->cat_bar, -12, -8);
+    lv_obj_add_style(slot->cat_bar, ui_theme_style(UI_STYLE_BAR), 0);
+    slot->cat_style = NULL;
+
+    /* Veg/non-veg dot — 12×12 with white border */
+    slot->dot = lv_obj_create(card);
+    lv_obj_set_size(slot->dot, 12, 12);
+    lv_obj_add_style(slot->dot, ui_theme_style(UI_STYLE_DOT), 0);
+    slot->dot_style = NULL;
+    lv_obj_align(slot->dot, LV_ALIGN_TOP_RIGHT, -2, 2);
+
+    /* Name */
+    slot->lbl_name = make_label(card, "", COL_WHITE, &lv_font_montserrat_14);
+    lv_label_set_long_mode(slot->lbl_name, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(slot->lbl_name, 200);
+    lv_obj_align(slot->lbl_name, LV_ALIGN_TOP_LEFT, 0, 0);
+
+    /* Description */
+    slot->lbl_desc = make_label(card, "", COL_GREY, &lv_font_montserrat_10);
+    lv_label_set_long_mode(slot->lbl_desc, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(slot->lbl_desc, 255);
+    lv_obj_align(slot->lbl_desc, LV_ALIGN_TOP_LEFT, 0, 22);
+
+    /* Price — larger, amber */
+    slot->lbl_price = make_label(card, "", COL_AMBER, &lv_font_montserrat_20);
+    lv_obj_align(slot->lbl_price, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+
+    /* Qty controls: [−] [+] — user_data is the slot, resolved to the
+     * bound item at tap time */
+    lv_obj_t *btn_p = lv_btn_create(card);
+    lv_obj_set_size(btn_p, 28, 28);
+    lv_obj_add_style(btn_p, ui_theme_style(UI_STYLE_BTN_QTY), 0);
+    lv_obj_align(btn_p, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+    lv_obj_t *lp = make_label(btn_p, "+", COL_BTN_TEXT, NULL);
+    lv_obj_center(lp);
+    lv_obj_add_event_cb(btn_p, qty_plus_cb, LV_EVENT_CLICKED, slot);
+
+    lv_obj_t *btn_m = lv_btn_create(card);
+    lv_obj_set_size(btn_m, 28, 28);
+    lv_obj_add_style(btn_m, ui_theme_style(UI_STYLE_BTN_QTY), 0);
+    lv_obj_align(btn_m, LV_ALIGN_BOTTOM_RIGHT, -34, 0);
+    lv_obj_t *lm = make_label(btn_m, "-", COL_BTN_TEXT, NULL);
+    lv_obj_center(lm);
+    lv_obj_add_event_cb(btn_m, qty_minus_cb, LV_EVENT_CLICKED, slot);
+
+    /* Unavailable overlay — shown by bind when the item is sold out;
+     * it is clickable so it also swallows taps on the qty buttons */
+    slot->overlay = lv_obj_create(card);
+    lv_obj_set_size(slot->overlay, 280, 145);
+    lv_obj_set_pos(slot->overlay, -12, -8);
+    lv_obj_add_style(slot->overlay, ui_theme_style(UI_STYLE_OVERLAY), 0);
+    lv_obj_t *lbl_na = make_label(slot->overlay, "Currently Unavailable",
+                                  COL_GREY, &lv_font_montserrat_12);
+    lv_obj_center(lbl_na);
+
+    slot->item_idx = -1;
+    slot->row      = -1;
+    slot->shown_id = 0;
+    lv_obj_add_flag(slot->root, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void menu_hdr_slot_init(menu_hdr_slot_t *slot)
+{
+    lv_obj_t *hdr = lv_obj_create(menu_grid);
+    lv_obj_set_size(hdr, MENU_HDR_W, MENU_HDR_H);
+    lv_obj_add_style(hdr, ui_theme_style(UI_STYLE_CLEAR), 0);
+    lv_obj_clear_flag(hdr, LV_OBJ_FLAG_SCROLLABLE);
+
+    /* Colour + font come from one shared text style swapped in by bind */
+    slot->lbl = lv_label_create(hdr);
+    lv_label_set_text(slot->lbl, "");
+    slot->txt_style = NULL;
+    lv_obj_align(slot->lbl, LV_ALIGN_LEFT_MID, 4, 0);
+
+    lv_obj_t *line = lv_obj_create(hdr);
+    lv_obj_set_size(line, MENU_HDR_W, 1);
+    lv_obj_align(line, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    lv_obj_add_style(line, ui_theme_style(UI_STYLE_DIVIDER), 0);
+
+    slot->hdr = hdr;
+    slot->row = -1;
+    lv_obj_add_flag(hdr, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void menu_pool_init(void)
+{
+    for (int i = 0; i < MENU_POOL_CARDS; i++) menu_card_slot_init(&s_card_pool[i]);
+    for (int i = 0; i < MENU_POOL_HDRS;  i++) menu_hdr_slot_init(&s_hdr_pool[i]);
+
+    menu_spacer = lv_obj_create(menu_grid);
+    lv_obj_remove_style_all(menu_spacer);
+    lv_obj_set_size(menu_spacer, 1, 1);
+    lv_obj_clear_flag(menu_spacer, LV_OBJ_FLAG_CLICKABLE);
+}
+
+/* Point a slot at a model item. Widgets are only rewritten when the slot
+ * is showing a different item or an older revision of the same one, so
+ * re-binding after a diff or a scroll round-trip costs nothing. */
+static void menu_card_bind(menu_card_slot_t *slot, int item_idx)
+{
+    const menu_item_t *it = menu_model_get(item_idx);
+    if (!it) return;
+    slot->item_idx = item_idx;
+    if (slot->shown_id == it->id && slot->shown_rev == it->rev) return;
+    slot->shown_id  = it->id;
+    slot->shown_rev = it->rev;
+    ui_theme_swap(slot->cat_bar, &slot->cat_style, ui_theme_cat_bar(it->cat));
+    ui_theme_swap(slot->dot, &slot->dot_style,
+                  ui_theme_style(it->is_veg ? UI_STYLE_DOT_VEG : UI_STYLE_DOT_NONVEG));
+    lv_label_set_text(slot->lbl_name, it->name);
+    lv_label_set_text(slot->lbl_desc, it->desc);
+    lv_label_set_text_fmt(slot->lbl_price, "Rs. %d", it->price_paise / 100);
+    if (it->available) lv_obj_add_flag(slot->overlay, LV_OBJ_FLAG_HIDDEN);
+    else               lv_obj_clear_flag(slot->overlay, LV_OBJ_FLAG_HIDDEN);
+}
+
+/* Unbind every slot. Widgets stay on screen (and keep their content)
+ * until menu_virt_update() either re-binds or hides them, so a relayout
+ * does not flash the grid. */
+static void menu_release_all(void)
+{
+    for (int i = 0; i < MENU_POOL_CARDS; i++) {
+        s_card_pool[i].row = -1;
+        s_card_pool[i].item_idx = -1;
+    }
+    for (int i = 0; i < MENU_POOL_HDRS; i++) s_hdr_pool[i].row = -1;
+}
+
+static void hide_if_shown(lv_obj_t *obj)
+{
+    if (!lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+}
+
+/* Free card slot for an item: prefer the one already showing it */
+static int menu_pick_card_slot(int item_id)
+{
+    int any = -1;
+    for (int i = 0; i < MENU_POOL_CARDS; i++) {
+        if (s_card_pool[i].row >= 0) continue;
+        if (s_card_pool[i].shown_id == item_id) return i;
+        if (any < 0) any = i;
+    }
+    return any;
+}
+
+static menu_row_t *menu_row_push(void)
+{
+    if (s_row_count >= s_row_cap) {
+        int ncap = s_row_cap ? s_row_cap * 2 : 32;
+        menu_row_t *n = realloc(s_rows, sizeof(menu_row_t) * ncap);
+        if (!n) return NULL;
+        s_rows    = n;
+        s_row_cap = ncap;
+    }
+    menu_row_t *r = &s_rows[s_row_count++];
+    memset(r, 0, sizeof(*r));
+    for (int c = 0; c < MENU_COLS; c++) r->slot[c] = -1;
+    return r;
+}
+
+/* Rebuild the row layout from the model: a header row whenever the
+ * category changes, then cards MENU_COLS per row (same geometry as the
+ * old ROW_WRAP flex grid). No widgets are created here. */
+static void menu_virt_layout(void)
+{
+    menu_release_all();
+    s_row_count = 0;
+
+    int32_t y = MENU_TOP_Y;
+    const char *last_cat = NULL;
+    menu_row_t *cur = NULL;
+    int n = menu_model_count();
+    for (int i = 0; i < n; i++) {
+        const menu_item_t *it = menu_model_get(i);
+        if (!last_cat || strcmp(it->cat, last_cat) != 0) {
+            menu_row_t *h = menu_row_push();
+            if (!h) break;
+            h->y = y; h->h = MENU_HDR_H; h->first_item = i;
+            y += MENU_HDR_H + MENU_GAP;
+            last_cat = it->cat;
+            cur = NULL;
+        }
+        if (!cur || cur->n_items >= MENU_COLS) {
+            cur = menu_row_push();
+            if (!cur) break;
+            cur->y = y; cur->h = MENU_CARD_H; cur->first_item = i;
+            y += MENU_CARD_H + MENU_GAP;
+        }
+        cur->n_items++;
+    }
+    if (menu_spacer)
+        lv_obj_set_pos(menu_spacer, 0, y > MENU_TOP_Y ? y - MENU_GAP + MENU_TOP_Y : 0);
+}
+
+/* Bind pool slots to the rows inside the viewport (+margin) and free
+ * the ones that scrolled out. Called on every scroll event. */
+static void menu_virt_update(void)
+{
+    if (!menu_grid || !s_rows) return;
+    int32_t sy  = lv_obj_get_scroll_y(menu_grid);
+    int32_t top = sy - MENU_VIRT_MARGIN_PX;
+    int32_t bot = sy + lv_obj_get_height(menu_grid) + MENU_VIRT_MARGIN_PX;
+
+    /* 1. Release slots whose row left the window */
+    for (int i = 0; i < MENU_POOL_CARDS; i++) {
+        menu_card_slot_t *cs = &s_card_pool[i];
+        if (cs->row < 0) continue;
+        const menu_row_t *r = &s_rows[cs->row];
+        if (r->y + r->h < top || r->y > bot) {
+            s_rows[cs->row].slot[cs->col] = -1;
+            cs->row = -1; cs->item_idx = -1;
+        }
+    }
+    for (int i = 0; i < MENU_POOL_HDRS; i++) {
+        menu_hdr_slot_t *hs = &s_hdr_pool[i];
+        if (hs->row < 0) continue;
+        const menu_row_t *r = &s_rows[hs->row];
+        if (r->y + r->h < top || r->y > bot) {
+            s_rows[hs->row].slot[0] = -1;
+            hs->row = -1;
+        }
+    }
+
+    /* 2. First row intersecting the window (rows are sorted by y) */
+    int lo = 0, hi = s_row_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (s_rows[mid].y + s_rows[mid].h < top) lo = mid + 1; else hi = mid;
+    }
+
+    /* 3. Bind free slots to unbound rows in the window */
+    int next_hdr = 0;
+    for (int r = lo; r < s_row_count && s_rows[r].y <= bot; r++) {
+        menu_row_t *row = &s_rows[r];
+        if (row->n_items == 0) {
+            if (row->slot[0] >= 0) continue;
+            while (next_hdr < MENU_POOL_HDRS && s_hdr_pool[next_hdr].row >= 0) next_hdr++;
+            if (next_hdr >= MENU_POOL_HDRS) continue;
+            menu_hdr_slot_t *hs = &s_hdr_pool[next_hdr];
+            const menu_item_t *it = menu_model_get(row->first_item);
+            if (strcmp(lv_label_get_text(hs->lbl), it->cat) != 0)
+                lv_label_set_text(hs->lbl, it->cat);
+            ui_theme_swap(hs->lbl, &hs->txt_style,
+                          ui_theme_text(ui_theme_cat_color(it->cat), &lv_font_montserrat_22));
+            lv_obj_set_pos(hs->hdr, 0, row->y);
+            lv_obj_clear_flag(hs->hdr, LV_OBJ_FLAG_HIDDEN);
+            hs->row = r;
+            row->slot[0] = (int8_t)next_hdr;
+            continue;
+        }
+        for (int c = 0; c < row->n_items; c++) {
+            if (row->slot[c] >= 0) continue;
+            const menu_item_t *it = menu_model_get(row->first_item + c);
+            int si = menu_pick_card_slot(it->id);
+            if (si < 0) break;
+            menu_card_slot_t *cs = &s_card_pool[si];
+            menu_card_bind(cs, row->first_item + c);
+            lv_obj_set_pos(cs->root, c * (MENU_CARD_W + MENU_GAP) - cs->skin_m,
+                           row->y - cs->skin_m);
+            lv_obj_clear_flag(cs->root, LV_OBJ_FLAG_HIDDEN);
+            cs->row = r; cs->col = c;
+            row->slot[c] = (int8_t)si;
+        }
+    }
+
+    /* 4. Hide whatever is still unbound */
+    for (int i = 0; i < MENU_POOL_CARDS; i++)
+        if (s_card_pool[i].row < 0) hide_if_shown(s_card_pool[i].root);
+    for (int i = 0; i < MENU_POOL_HDRS; i++)
+        if (s_hdr_pool[i].row < 0) hide_if_shown(s_hdr_pool[i].hdr);
+}
+
+/* Re-bind bound cards after an in-place model change; only slots whose
+ * item revision moved touch their widgets. */
+static void menu_virt_refresh(void)
+{
+    if (!menu_grid) return;
+    for (int i = 0; i < MENU_POOL_CARDS; i++)
+        if (s_card_pool[i].row >= 0) menu_card_bind(&s_card_pool[i], s_card_pool[i].item_idx);
+}
+
+static void menu_grid_scroll_cb(lv_event_t *e)
+{
+    (void)e;
+    menu_virt_update();
 }
 
 static void build_menu(void)
@@ -576,8 +1282,17 @@ static void build_menu(void)
 
     lbl_cart_title = make_label(cart_panel, "YOUR ORDER", COL_AMBER, &lv_font_montserrat_14);
 
+    /* Seat chip (split bill): which seat the next + lands on */
+    lv_obj_t *btn_seat = lv_btn_create(cart_panel);
+    lv_obj_set_size(btn_seat, 186, 30);
+    lv_obj_add_style(btn_seat, ui_theme_style(UI_STYLE_CHIP), 0);
+    lbl_cart_seat = make_label(btn_seat, "", COL_AMBER, &lv_font_montserrat_12);
+    lv_obj_center(lbl_cart_seat);
+    lv_obj_add_event_cb(btn_seat, cart_seat_cb, LV_EVENT_CLICKED, NULL);
+    cart_seat_label_update();
+
     cart_list = lv_obj_create(cart_panel);
-    lv_obj_set_size(cart_list, 188, 200);
+    lv_obj_set_size(cart_list, 188, 164);
     lv_obj_set_style_bg_opa(cart_list, LV_OPA_TRANSP, 0);
     lv_obj_set_style_border_opa(cart_list, LV_OPA_TRANSP, 0);
     lv_obj_set_flex_flow(cart_list, LV_FLEX_FLOW_COLUMN);
@@ -622,213 +1337,109 @@ static void build_menu(void)
     lv_obj_center(lbl_w);
     lv_obj_add_event_cb(btn_waiter, call_waiter_menu_cb, LV_EVENT_CLICKED, NULL);
 
-    /* Menu grid area */
+    /* Menu grid area — virtualized: pooled cards are positioned by
+     * menu_virt_update(), no flex layout */
     menu_grid = lv_obj_create(scr_menu);
     lv_obj_set_size(menu_grid, 578, 424);
     lv_obj_set_pos(menu_grid, 0, 56);
     lv_obj_set_style_bg_opa(menu_grid, LV_OPA_TRANSP, 0);
     lv_obj_set_style_border_opa(menu_grid, LV_OPA_TRANSP, 0);
     lv_obj_set_style_pad_all(menu_grid, 8, 0);
-    lv_obj_set_flex_flow(menu_grid, LV_FLEX_FLOW_ROW_WRAP);
-    lv_obj_set_flex_align(menu_grid, LV_FLEX_ALIGN_START,
-                          LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
-    lv_obj_set_style_pad_gap(menu_grid, 6, 0);
     /* Smooth scrolling — auto-hide scrollbar, enable momentum */
     lv_obj_set_scrollbar_mode(menu_grid, LV_SCROLLBAR_MODE_AUTO);
     lv_obj_add_flag(menu_grid, LV_OBJ_FLAG_SCROLL_MOMENTUM);
     lv_obj_set_scroll_snap_y(menu_grid, LV_SCROLL_SNAP_NONE);
     lv_obj_set_style_anim_time(menu_grid, 300, 0); /* smooth deceleration */
-}
-
-/* Category left-border color */
-static lv_color_t cat_color_for(const char *cat)
-{
-    if (!cat) return COL_AMBER;
-    char lower[64];
-    strncpy(lower, cat, 63); lower[63] = 0;
-    for (char *p = lower; *p; p++) *p = tolower((unsigned char)*p);
-
-    if (strstr(lower, "starter") || strstr(lower, "appetizer")) return COL_SUCCESS;
-    if (strstr(lower, "main") || strstr(lower, "course")) return COL_AMBER;
-    if (strstr(lower, "drink") || strstr(lower, "beverage")) return lv_color_hex(0x3B82F6); /* blue */
-    if (strstr(lower, "dessert") || strstr(lower, "sweet")) return lv_color_hex(0xEC4899); /* pink */
-    return lv_color_hex(0x94A3B8); /* grey for others */
-}
-
-static void make_category_header(const char *cat_name)
-{
-    lv_obj_t *hdr = lv_obj_create(menu_grid);
-    lv_obj_set_size(hdr, 550, 40);
-    lv_obj_set_style_bg_opa(hdr, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_opa(hdr, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_pad_all(hdr, 0, 0);
-    lv_obj_clear_flag(hdr, LV_OBJ_FLAG_SCROLLABLE);
-
-    lv_obj_t *lbl = make_label(hdr, cat_name, cat_color_for(cat_name), &lv_font_montserrat_22);
-    lv_obj_align(lbl, LV_ALIGN_LEFT_MID, 4, 0);
-
-    lv_obj_t *line = lv_obj_create(hdr);
-    lv_obj_set_size(line, 550, 1);
-    lv_obj_align(line, LV_ALIGN_BOTTOM_LEFT, 0, 0);
-    lv_obj_set_style_bg_color(line, lv_color_hex(0x334155), 0);
-    lv_obj_set_style_border_opa(line, LV_OPA_TRANSP, 0);
-}
-
-static void free_ctx_cb(lv_event_t *e) {
-    void *ctx = lv_event_get_user_data(e);
-    if (ctx) free(ctx);
-}
-
-/* Add a card to the menu grid */
-static void add_menu_card(int id, const char *name, const char *desc, const char *cat,
-                           int price_paise, bool is_veg, bool available)
-{
-    lv_obj_t *card = make_card(menu_grid, 274, 145);
-    lv_obj_set_style_pad_all(card, 8, 0);
-    lv_obj_set_style_pad_left(card, 12, 0);
-
-    /* Category left-border (3px) */
-    lv_obj_t *cat_bar = lv_obj_create(card);
-    lv_obj_set_size(cat_bar, 3, 129);
-    lv_obj_set_pos(cat_bar, -12, -8);
-    lv_obj_set_style_bg_color(cat_bar, cat_color_for(cat), 0);
-    lv_obj_set_style_bg_opa(cat_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_opa(cat_bar, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_radius(cat_bar, 0, 0);
-
-    /* Veg/non-veg dot — 12×12 with white border */
-    lv_obj_t *dot = lv_obj_create(card);
-    lv_obj_set_size(dot, 12, 12);
-    lv_obj_set_style_radius(dot, LV_RADIUS_CIRCLE, 0);
-    lv_obj_set_style_bg_color(dot, is_veg ? COL_SUCCESS : COL_ERROR, 0);
-    lv_obj_set_style_border_color(dot, COL_WHITE, 0);
-    lv_obj_set_style_border_width(dot, 1, 0);
-    lv_obj_set_style_border_opa(dot, LV_OPA_COVER, 0);
-    lv_obj_align(dot, LV_ALIGN_TOP_RIGHT, -2, 2);
-
-    /* Name */
-    lv_obj_t *lbl_name = make_label(card, name, COL_WHITE,
-                                    &lv_font_montserrat_14);
-    lv_label_set_long_mode(lbl_name, LV_LABEL_LONG_DOT);
-    lv_obj_set_width(lbl_name, 200);
-    lv_obj_align(lbl_name, LV_ALIGN_TOP_LEFT, 0, 0);
-
-    /* Description */
-    lv_obj_t *lbl_desc = make_label(card, desc, COL_GREY,
-                                    &lv_font_montserrat_10);
-    lv_label_set_long_mode(lbl_desc, LV_LABEL_LONG_DOT);
-    lv_obj_set_width(lbl_desc, 255);
-    lv_obj_align(lbl_desc, LV_ALIGN_TOP_LEFT, 0, 22);
-
-    /* Price — larger, amber */
-    char price_str[24];
-    snprintf(price_str, sizeof(price_str), "Rs. %d", price_paise / 100);
-    lv_obj_t *lbl_price = make_label(card, price_str, COL_AMBER,
-                                     &lv_font_montserrat_20);
-    lv_obj_align(lbl_price, LV_ALIGN_BOTTOM_LEFT, 0, 0);
-
-    /* Qty controls: [−] [qty] [+] */
-    menu_item_ctx_t *ctx = malloc(sizeof(menu_item_ctx_t));
-    if (ctx) {
-        ctx->id = id;
-        ctx->price_paise = price_paise;
-        ctx->is_veg = is_veg;
-        strncpy(ctx->name, name, CART_MAX_NAME - 1);
-        ctx->name[CART_MAX_NAME - 1] = '\0';
-    }
-
-    lv_obj_t *btn_p = lv_btn_create(card);
-    lv_obj_set_size(btn_p, 28, 28);
-    lv_obj_set_style_bg_color(btn_p, COL_AMBER, 0);
-    lv_obj_set_style_radius(btn_p, 6, 0);
-    lv_obj_set_style_border_opa(btn_p, LV_OPA_TRANSP, 0);
-    lv_obj_align(btn_p, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
-    lv_obj_t *lp = lv_label_create(btn_p);
-    lv_label_set_text(lp, "+");
-    lv_obj_set_style_text_color(lp, lv_color_hex(0x0A0A0A), 0);
-    lv_obj_center(lp);
-    lv_obj_add_event_cb(btn_p, qty_plus_cb, LV_EVENT_CLICKED, ctx);
-    lv_obj_add_event_cb(btn_p, free_ctx_cb, LV_EVENT_DELETE, ctx); /* free when button is deleted */
-
-    lv_obj_t *btn_m = lv_btn_create(card);
-    lv_obj_set_size(btn_m, 28, 28);
-    lv_obj_set_style_bg_color(btn_m, COL_AMBER, 0);
-    lv_obj_set_style_radius(btn_m, 6, 0);
-    lv_obj_set_style_border_opa(btn_m, LV_OPA_TRANSP, 0);
-    lv_obj_align(btn_m, LV_ALIGN_BOTTOM_RIGHT, -34, 0);
-    lv_obj_t *lm = lv_label_create(btn_m);
-    lv_label_set_text(lm, "-");
-    lv_obj_set_style_text_color(lm, lv_color_hex(0x0A0A0A), 0);
-    lv_obj_center(lm);
-    lv_obj_add_event_cb(btn_m, qty_minus_cb, LV_EVENT_CLICKED, ctx);
-    /* No need for delete_cb on btn_m because they share the same ctx freed by btn_p */
-
-    /* Unavailable overlay */
-    if (!available) {
-        lv_obj_t *overlay = lv_obj_create(card);
-        lv_obj_set_size(overlay, 280, 145);
-        lv_obj_set_pos(overlay, -12, -8);
-        lv_obj_set_style_bg_color(overlay, lv_color_hex(0x0A0A0A), 0);
-        lv_obj_set_style_bg_opa(overlay, 190, 0);
-        lv_obj_set_style_border_opa(overlay, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_radius(overlay, 16, 0);
-        lv_obj_t *lbl_na = make_label(overlay, "Currently Unavailable",
-                                      COL_GREY, &lv_font_montserrat_12);
-        lv_obj_center(lbl_na);
+    lv_obj_set_scroll_dir(menu_grid, LV_DIR_VER);   /* skin shadows overhang */
+    lv_obj_add_event_cb(menu_grid, menu_grid_scroll_cb, LV_EVENT_SCROLL, NULL);
+    menu_pool_init();
+
+    /* Built lazily: the menu may already have been fetched into the model */
+    if (menu_model_count() > 0) {
+        lv_obj_update_layout(menu_grid);
+        menu_virt_layout();
+        menu_virt_update();
     }
 }
 
 /* =====================================================================
  *  SCREEN 3 — ORDER PLACED
  * ===================================================================== */
-/* BUG 1 FIX: add_more_cb — DEFERRED to prevent stack overflow from LVGL callbacks */
+/* BUG 1 FIX: add_more_cb — DEFERRED to prevent stack overflow from LVGL
+ * callbacks: the event is applied by sm_update after lv_timer_handler */
 static void add_more_cb(lv_event_t *e)
 {
+    TOUCH_LAT_MARK("more");
     g_append_mode = true;
-    g_goto_menu   = true;  /* Deferred: handled in ui_task_handler */
+    sm_post(EV_ADD_MORE);
 }
 
 /* BUG 7: track which removed items we've already toasted */
 static int g_notified_removed[32];
 static int g_notified_removed_count = 0;
 
-/* Bug 1 Fix: state guard prevents stale timer firing in wrong state */
-static void order_poll_cb(lv_timer_t *t)
+/* Order status poll: the timer only posts a job; the GET runs on the net
+ * task and the parsed result comes back through ui_post(). */
+#define ORDER_POLL_NONE    0
+#define ORDER_POLL_READY   1
+#define ORDER_POLL_SERVED  2
+static volatile bool s_order_poll_busy = false;
+
+/* Bug 1 Fix: a stale result is dropped by the transition table (no
+ * FOOD_READY row outside ORDER_PLACED); leaving the state stops the timer */
+static void order_poll_done(void *arg)   /* UI task */
 {
-    if (poll_timer == NULL) return;
-    int oid = sm_get_order_id();
-    if (oid <= 0) return;
-    
-    static char json[1024]; /* Move to static to save stack space */
-    if (net_get_order_json(oid, json, sizeof(json)) == 0) {
-        /* 1. Extract status */
-        char status[32] = "";
-        const char *ps = strstr(json, "\"status\"");
+    int res = (int)(intptr_t)arg;
+    s_order_poll_busy = false;
+
+    /* 2. Check for Transitions */
+    if (res == ORDER_POLL_READY)       sm_post(EV_FOOD_READY);
+    else if (res == ORDER_POLL_SERVED) sm_post(EV_FOOD_SERVED);
+}
+
+/* "status" of an /api/order/status response */
+static void order_json_status(const char *json, char *status, int len)
+{
+    status[0] = '\0';
+    const char *ps = strstr(json, "\"status\"");
+    if (ps) {
+        ps = strchr(ps, ':');
         if (ps) {
-            ps = strchr(ps, ':');
-            if (ps) {
-                ps++; while(*ps == ' ' || *ps == '"') ps++;
-                const char *e = strchr(ps, '"');
-                if (e) {
-                    int l = e - ps;
-                    if (l > 31) l = 31;
-                    memcpy(status, ps, l);
-                    status[l] = '\0';
-                }
+            ps++; while(*ps == ' ' || *ps == '"') ps++;
+            const char *e = strchr(ps, '"');
+            if (e) {
+                int l = e - ps;
+                if (l > len - 1) l = len - 1;
+                memcpy(status, ps, l);
+                status[l] = '\0';
             }
         }
-        
-        /* 2. Check for Transitions */
-        if (strcmp(status, "ready") == 0) {
-            safe_timer_del(&poll_timer);
-            sm_set(STATE_FOOD_READY);
-        } else if (strcmp(status, "served") == 0) {
-            safe_timer_del(&poll_timer);
-            sm_set(STATE_FOOD_SERVED);
-        }
     }
 }
 
+static void order_poll_job(void *arg)    /* net task */
+{
+    int oid = (int)(intptr_t)arg;
+    int res = ORDER_POLL_NONE;
+    static char json[1024]; /* Move to static to save stack space */
+    if (net_get_order_json(oid, json, sizeof(json)) == 0) {
+        char status[32];
+        order_json_status(json, status, sizeof(status));
+        if (strcmp(status, "ready") == 0)       res = ORDER_POLL_READY;
+        else if (strcmp(status, "served") == 0) res = ORDER_POLL_SERVED;
+    }
+    if (!ui_post(order_poll_done, (void *)(intptr_t)res)) s_order_poll_busy = false;
+}
+
+static void order_poll_cb(lv_timer_t *t)
+{
+    if (poll_timer == NULL || s_order_poll_busy) return;
+    int oid = sm_get_order_id();
+    if (oid <= 0) return;
+    s_order_poll_busy = true;
+    if (!net_post(order_poll_job, (void *)(intptr_t)oid)) s_order_poll_busy = false;
+}
+
 static void bell_anim_cb(void * var, int32_t v) {
     lv_obj_set_style_translate_y((lv_obj_t *)var, v, 0);
 }
@@ -847,7 +1458,7 @@ static void build_order_placed(void)
     lv_obj_set_style_border_opa(circle, LV_OPA_TRANSP, 0);
     lv_obj_align(circle, LV_ALIGN_TOP_MID, 0, 16);
     lv_obj_t *lbl_ok = make_label(circle, LV_SYMBOL_OK,
-                                  lv_color_hex(0x0A0A0A), &lv_font_montserrat_28);
+                                  COL_BTN_TEXT, &lv_font_montserrat_28);
     lv_obj_center(lbl_ok);
 
     lv_obj_t *lbl_title = make_label(card, "Order Placed!",
@@ -892,36 +1503,36 @@ static void build_order_placed(void)
     lv_obj_add_event_cb(btn_waiter, call_waiter_menu_cb, LV_EVENT_CLICKED, NULL);
 
     /* --- Bounce Animation Array On Bell Button --- */
-    lv_anim_t a;
-    lv_anim_init(&a);
-    lv_anim_set_var(&a, btn_waiter);
-    lv_anim_set_values(&a, 0, -8);
-    lv_anim_set_time(&a, 400);
-    lv_anim_set_playback_time(&a, 400);
-    lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
-    lv_anim_set_path_cb(&a, lv_anim_path_ease_in_out);
-    lv_anim_set_exec_cb(&a, bell_anim_cb);
-    lv_anim_start(&a);
+    anim_gov_loop(btn_waiter, bell_anim_cb, 0, -8, 400);
 }
 
 /* =====================================================================
  *  SCREEN 4 — FOOD READY
  * ===================================================================== */
 /* BUG 1: go to dedicated food-served screen, not directly to bill */
+static void served_tap_job(void *arg)   /* net task */
+{
+    net_food_served((int)(intptr_t)arg);
+    net_buzz(2);
+}
 static void food_served_cb(lv_event_t *e) {
-    g_pending_food_served = true; /* Fix: immediate flag for 1-click served */
-    sm_set(STATE_FOOD_SERVED);
+    TOUCH_LAT_MARK("served");
+    /* Fix: 1-click served — the server update is queued with the tap */
+    net_post(served_tap_job, (void *)(intptr_t)sm_get_order_id());
+    sm_post(EV_FOOD_SERVED);
 }
+static void call_waiter_job(void *arg) { net_call_waiter((int)(intptr_t)arg); }
 static void call_waiter_cb(lv_event_t *e) {
-    net_call_waiter(sm_get_order_id());
+    TOUCH_LAT_MARK("waiter");
+    net_post(call_waiter_job, (void *)(intptr_t)sm_get_order_id());
     create_toast("STAFF NOTIFIED", "Someone is coming to your table.", 3000);
 }
-static void gen_bill_cb(lv_event_t *e) { sm_set(STATE_BILL); }
+static void gen_bill_cb(lv_event_t *e) { TOUCH_LAT_MARK("bill"); sm_post(EV_BILL_REQUEST); }
 
 static void build_food_ready(void)
 {
     scr_ready = make_screen();
-    lv_obj_t *card = make_card(scr_ready, 640, 360);
+    lv_obj_t *card = ready_card = make_card(scr_ready, 640, 360);
     lv_obj_center(card);
     add_card_accent(card, 640);
 
@@ -963,14 +1574,14 @@ static void fs_btn_show_cb(lv_timer_t *t)
     lv_timer_del(t);
     if (!ctx) return;
     lv_obj_clear_flag(ctx->btn, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_fade_in(ctx->btn, 300, 0);
+    lv_obj_fade_in(ctx->btn, anim_gov_time(300), 0);
     lv_anim_t a;
     lv_anim_init(&a);
     lv_anim_set_var(&a, ctx->btn);
     lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_y);
     int orig_y = lv_obj_get_y(ctx->btn);
     lv_anim_set_values(&a, orig_y + 40, orig_y);
-    lv_anim_set_time(&a, 300);
+    lv_anim_set_time(&a, anim_gov_time(300));
     lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
     lv_anim_start(&a);
     free(ctx);
@@ -978,41 +1589,25 @@ static void fs_btn_show_cb(lv_timer_t *t)
 
 /* BUG 2: fs_order_more_cb routes through add_more_cb so append-mode is set */
 static void fs_order_more_cb(lv_event_t *e)  { add_more_cb(e); }
-static void fs_call_waiter_cb(lv_event_t *e) { g_pending_buzz = 1; }
-
-/* BUG 2 FIX: fs_gen_bill_cb — only called from "Generate Bill" button.
- * Calls net_food_served(); retries once on failure, then shows waiter toast. */
-static lv_obj_t *g_fs_retry_btn_ref = NULL;
-static void fs_retry_served_cb(lv_timer_t *t)
-{
-    lv_timer_del(t);
-    int err = net_food_served(sm_get_order_id());
-    if (err == 0) {
-        net_buzz(4);
-        sm_set(STATE_BILL);
-    } else {
-        /* Final failure — show persistent toast */
-        if (g_fs_retry_btn_ref) {
-            lv_obj_t *sl = lv_obj_get_child(g_fs_retry_btn_ref, 0);
-            if (sl) lv_label_set_text(sl, "Please call waiter");
-        }
-    }
-}
+static void fs_call_waiter_cb(lv_event_t *e) { ui_buzz(1); }
 
+/* BUG 2 FIX: fs_gen_bill_cb — only called from "Generate Bill" button */
 static void fs_gen_bill_cb(lv_event_t *e)
 {
     /* Transition to Bill screen directly after food served */
-    sm_set(STATE_BILL);
+    sm_post(EV_BILL_REQUEST);
 }
 
+static void food_served_job(void *arg) { net_food_served((int)(intptr_t)arg); }
+
 static void food_received_cb(lv_event_t *e)
 {
     lv_obj_t *btn = (lv_obj_t*)lv_event_get_target(e);
     lv_obj_t *lbl = lv_obj_get_child(btn, 0);
     if (lbl) lv_label_set_text(lbl, "Marked Served");
     
-    /* Call server to update dashboard to 'Served' */
-    net_food_served(sm_get_order_id());
+    /* Call server to update dashboard to 'Served' (net task) */
+    net_post(food_served_job, (void *)(intptr_t)sm_get_order_id());
     
     /* Reveal the Bill and Order More buttons if they were hidden */
     lv_obj_t *card = lv_obj_get_parent(btn);
@@ -1051,7 +1646,7 @@ static void build_food_served(void)
     lv_obj_set_style_bg_color(circle, COL_SUCCESS, 0);
     lv_obj_set_style_border_opa(circle, LV_OPA_TRANSP, 0);
     lv_obj_align(circle, LV_ALIGN_TOP_MID, 0, 20);
-    lv_obj_t *lbl_ck = make_label(circle, LV_SYMBOL_OK, lv_color_hex(0x0A0A0A), &lv_font_montserrat_32);
+    lv_obj_t *lbl_ck = make_label(circle, LV_SYMBOL_OK, COL_BTN_TEXT, &lv_font_montserrat_32);
     lv_obj_center(lbl_ck);
 
     lv_obj_t *lbl_title = make_label(card, "Enjoy Your Meal!", COL_SUCCESS, &lv_font_montserrat_32);
@@ -1075,99 +1670,125 @@ static void build_food_served(void)
 /* =====================================================================
  *  SCREEN 5 — BILL  (Bug 2 Fix: one-shot timer avoids double-call race)
  * ===================================================================== */
-static void proceed_payment_cb(lv_event_t *e) { sm_set(STATE_PAYMENT_SELECT); }
+static void proceed_payment_cb(lv_event_t *e) { sm_post(EV_PAY_PROCEED); }
 
-static void load_bill_cb(lv_timer_t *t)
+/* Per-seat totals under the item rows, computed locally from the same
+ * lines (bill_split.c); only shown when more than one group ordered */
+static void bill_split_rows(void)
 {
-    lv_timer_del(t);
-    if (sm_get_order_id() < 0 || !lbl_bill_body) return;
-    char *bill_json = net_request_bill(sm_get_order_id());
-    if (!bill_json) {
-        lv_label_set_text(lbl_bill_body, "TOTAL:  Rs. ---  (error)");
-        return;
+    if (s_split.count < 2) return;
+    lv_obj_t *hdr = make_label(bill_items_col, "SPLIT BY SEAT  (incl. GST)",
+                               COL_AMBER, &lv_font_montserrat_12);
+    lv_obj_set_style_pad_top(hdr, 6, 0);
+    for (int i = 0; i < s_split.count; i++) {
+        const bill_seat_t *st = &s_split.seats[i];
+        lv_obj_t *row = lv_obj_create(bill_items_col);
+        lv_obj_set_size(row, 580, 22);
+        lv_obj_add_style(row, ui_theme_style(UI_STYLE_CLEAR), 0);
+
+        char name[16], buf[48];
+        lv_obj_t *ln = make_label(row, bill_seat_name(st->seat, name, sizeof(name)),
+                                  COL_WHITE, &lv_font_montserrat_14);
+        lv_obj_align(ln, LV_ALIGN_LEFT_MID, 0, 0);
+        snprintf(buf, sizeof(buf), "%d + %d GST", st->subtotal, st->gst);
+        lv_obj_t *lg = make_label(row, buf, COL_GREY, &lv_font_montserrat_12);
+        lv_obj_align(lg, LV_ALIGN_LEFT_MID, 300, 0);
+        snprintf(buf, sizeof(buf), "Rs. %d", st->total);
+        lv_obj_t *lt = make_label(row, buf, COL_AMBER, &lv_font_montserrat_14);
+        lv_obj_align(lt, LV_ALIGN_RIGHT_MID, 0, 0);
     }
+}
 
-    int sub = 0, gst = 0, total = 0;
-    const char *ps;
-    /* Flexible parsing for totals */
-    ps = strstr(bill_json, "\"subtotal\"");
-    if (ps) { ps = strchr(ps, ':'); if (ps) { ps++; while(*ps == ' ') ps++; sub = atoi(ps); } }
-    ps = strstr(bill_json, "\"gst\"");
-    if (ps) { ps = strchr(ps, ':'); if (ps) { ps++; while(*ps == ' ') ps++; gst = atoi(ps); } }
-    ps = strstr(bill_json, "\"total\"");
-    if (ps) { 
-        ps = strchr(ps, ':'); 
-        if (ps) { 
-            ps++; while(*ps == ' ') ps++; 
-            total = atoi(ps); 
-            g_total_bill_rupees = total; /* Store for payment selection page */
-        } 
+static void paysel_amount_update(void);
+
+static void bill_status(const char *txt, lv_color_t col)
+{
+    if (!lbl_bill_time) return;
+    lv_label_set_text(lbl_bill_time, txt);
+    lv_obj_set_style_text_color(lbl_bill_time, col, 0);
+}
+
+/* One item row. was = the ledger's line when the server's differs,
+ * removed = on our ledger but not on the server's bill. */
+static void bill_row(const bill_line_t *ln, const bill_line_t *was, bool removed)
+{
+    lv_obj_t *row_cont = lv_obj_create(bill_items_col);
+    lv_obj_set_size(row_cont, 580, 24);
+    lv_obj_add_style(row_cont, ui_theme_style(UI_STYLE_CLEAR), 0);
+
+    char iname[72];
+    if (ln->seat > 0) snprintf(iname, sizeof(iname), "S%d  %s", ln->seat, ln->name);
+    else              snprintf(iname, sizeof(iname), "%s", ln->name);
+    bool changed = was || removed;
+    lv_color_t hi = removed ? COL_ERROR : COL_AMBER;
+
+    /* Perfectly Aligned Columns */
+    lv_obj_t *ln_lbl = make_label(row_cont, iname, changed ? hi : COL_WHITE,
+                                  &lv_font_montserrat_14);
+    lv_obj_align(ln_lbl, LV_ALIGN_LEFT_MID, 0, 0);
+    lv_label_set_long_mode(ln_lbl, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(ln_lbl, 280);
+
+    char buf[24];
+    if (was && was->qty != ln->qty) snprintf(buf, sizeof(buf), "%d (was %d)", ln->qty, was->qty);
+    else                            snprintf(buf, sizeof(buf), "%d", ln->qty);
+    lv_obj_t *lq = make_label(row_cont, buf, changed ? hi : COL_GREY, &lv_font_montserrat_14);
+    lv_obj_align(lq, LV_ALIGN_LEFT_MID, 300, 0);
+
+    snprintf(buf, sizeof(buf), "%d", ln->price);
+    lv_obj_t *lp = make_label(row_cont, buf,
+                              was && was->price != ln->price ? hi : COL_GREY,
+                              &lv_font_montserrat_14);
+    lv_obj_align(lp, LV_ALIGN_LEFT_MID, 380, 0);
+
+    if (removed) snprintf(buf, sizeof(buf), "removed");
+    else         snprintf(buf, sizeof(buf), "%d", ln->qty * ln->price);
+    lv_obj_t *lt = make_label(row_cont, buf, changed ? hi : COL_WHITE, &lv_font_montserrat_14);
+    lv_obj_align(lt, LV_ALIGN_RIGHT_MID, 0, 0);
+}
+
+/* Draw bill b. With was (the local ledger it replaces), lines that differ
+ * are highlighted and lines the server dropped are listed as removed.
+ * fresh = a new bill; otherwise seats already paid stay paid. */
+static void bill_render(const bill_ledger_t *b, const bill_ledger_t *was,
+                        int sub, int gst, int total, bool fresh)
+{
+    g_total_bill_rupees = total;   /* Store for payment selection page */
+
+    bill_split_t old = s_split;
+    bill_split_reset(&s_split);
+    for (int i = 0; i < b->count; i++)
+        bill_split_add(&s_split, b->lines[i].seat, b->lines[i].qty, b->lines[i].price);
+    bill_split_finish(&s_split);
+    if (fresh) {
+        g_pay_seat = BILL_SEAT_ALL;
+    } else {
+        for (int i = 0; i < old.count; i++) {
+            bill_seat_t *st = bill_split_seat(&s_split, old.seats[i].seat);
+            if (st) st->paid = old.seats[i].paid;
+        }
+        if (g_pay_seat != BILL_SEAT_ALL && !bill_split_seat(&s_split, g_pay_seat))
+            g_pay_seat = BILL_SEAT_ALL;
     }
 
     /* ── Populate item rows in bill_items_col ── */
     if (bill_items_col) {
         lv_obj_clean(bill_items_col);
-        /* Parse items array from bill JSON - SKIP ROOT OBJECT */
-        const char *p = strstr(bill_json, "\"items\"");
-        if (p) {
-            p = strchr(p, '[');
-            if (p) {
-                while ((p = strchr(p, '{')) != NULL) {
-                    const char *obj_end = find_obj_end(p);
-                    if (!obj_end) break;
-                    char iname[64] = ""; int qty = 0, price = 0;
-                    const char *f;
-                    /* Flexible item_name extraction — check both "item_name" and "name" */
-                    f = strstr(p, "\"item_name\"");
-                    if (!f || f > obj_end) f = strstr(p, "\"name\"");
-                    if (f && f < obj_end) {
-                        f = strchr(f, ':');
-                        if (f) {
-                            f++; while (*f == ' ' || *f == '"') f++;
-                            const char *q = strchr(f, '"');
-                            if (q && q < obj_end) {
-                                int l = (int)(q - f);
-                                if (l >= 64) l = 63;
-                                memcpy(iname, f, l); iname[l] = 0;
-                            }
-                        }
-                    }
-                    /* Flexible qty extraction */
-                    f = strstr(p, "\"qty\"");
-                    if (f && f < obj_end) { f = strchr(f, ':'); if (f) { f++; while(*f == ' ') f++; qty = atoi(f); } }
-                    /* Flexible price extraction */
-                    f = strstr(p, "\"price\"");
-                    if (f && f < obj_end) { f = strchr(f, ':'); if (f) { f++; while(*f == ' ') f++; price = atoi(f); } }
-                    
-                    if (iname[0] && qty > 0) {
-                        lv_obj_t *row_cont = lv_obj_create(bill_items_col);
-                        lv_obj_set_size(row_cont, 580, 24);
-                        lv_obj_set_style_pad_all(row_cont, 0, 0);
-                        lv_obj_set_style_bg_opa(row_cont, LV_OPA_TRANSP, 0);
-                        lv_obj_set_style_border_opa(row_cont, LV_OPA_TRANSP, 0);
-                        
-                        /* Perfectly Aligned Columns */
-                        lv_obj_t *ln = make_label(row_cont, iname, COL_WHITE, &lv_font_montserrat_14);
-                        lv_obj_align(ln, LV_ALIGN_LEFT_MID, 0, 0);
-                        lv_label_set_long_mode(ln, LV_LABEL_LONG_DOT);
-                        lv_obj_set_width(ln, 280);
-                        
-                        char buf[16]; snprintf(buf,sizeof(buf),"%d",qty);
-                        lv_obj_t *lq = make_label(row_cont, buf, COL_GREY, &lv_font_montserrat_14);
-                        lv_obj_align(lq, LV_ALIGN_LEFT_MID, 300, 0);
-                        
-                        snprintf(buf,sizeof(buf),"%d",price);
-                        lv_obj_t *lp = make_label(row_cont, buf, COL_GREY, &lv_font_montserrat_14);
-                        lv_obj_align(lp, LV_ALIGN_LEFT_MID, 380, 0);
-                        
-                        snprintf(buf,sizeof(buf),"%d",qty*price);
-                        lv_obj_t *lt = make_label(row_cont, buf, COL_WHITE, &lv_font_montserrat_14);
-                        lv_obj_align(lt, LV_ALIGN_RIGHT_MID, 0, 0);
-                    }
-                    p = obj_end;
-                }
-            }
+        for (int i = 0; i < b->count; i++) {
+            const bill_line_t *ln = &b->lines[i];
+            const bill_line_t *o  = was ? bill_ledger_find(was, ln->id, ln->seat) : NULL;
+            bool differs = was && (!o || o->qty != ln->qty || o->price != ln->price);
+            /* A line the server added has no "was"; flag it by itself */
+            bill_line_t none = *ln;
+            none.qty = 0;
+            bill_row(ln, differs ? (o ? o : &none) : NULL, false);
+        }
+        if (was) {
+            for (int i = 0; i < was->count; i++)
+                if (!bill_ledger_find(b, was->lines[i].id, was->lines[i].seat))
+                    bill_row(&was->lines[i], NULL, true);
         }
+        bill_split_rows();
     }
 
     /* ── Update totals ── */
@@ -1180,26 +1801,143 @@ static void load_bill_cb(lv_timer_t *t)
         snprintf(buf, sizeof(buf), "GST (5%%):                   Rs. %d", gst);
         lv_label_set_text(lbl_bill_gst, buf);
     }
-    snprintf(buf, sizeof(buf), "TOTAL:                      Rs. %d", total);
-    lv_label_set_text(lbl_bill_body, buf);
+    if (lbl_bill_body) {
+        snprintf(buf, sizeof(buf), "TOTAL:                      Rs. %d", total);
+        lv_label_set_text(lbl_bill_body, buf);
+    }
 
     /* ── Push amount to payment screens ── */
+    paysel_amount_update();
     snprintf(buf, sizeof(buf), "Amount Due: Rs. %d", total);
-    if (lbl_paysel_amount) lv_label_set_text(lbl_paysel_amount, buf);
     if (lbl_upi_amount)    lv_label_set_text(lbl_upi_amount, buf);
-    
+
     if (lbl_cash_amount) {
         snprintf(buf, sizeof(buf), "Rs. %d", total);
         lv_label_set_text(lbl_cash_amount, buf);
     }
+}
+
+/* Instant bill from the ledger, shown on entry to STATE_BILL. Returns
+ * false when the ledger cannot stand in for the bill. */
+static bool bill_show_local(void)
+{
+    if (s_ledger.count == 0 || s_ledger.overflow || !lbl_bill_body) return false;
+    int sub = bill_ledger_subtotal(&s_ledger);
+    int gst = bill_ledger_gst(sub);
+    bill_render(&s_ledger, NULL, sub, gst, sub + gst, true);
+    bill_status("Confirming with kitchen...", COL_GREY);
+    s_bill_local    = true;
+    s_bill_local_ms = lv_tick_get();
+    return true;
+}
 
-    /* Timestamp */
-    if (lbl_bill_time) {
-        /* Use LVGL tick for a rough time display */
-        lv_label_set_text(lbl_bill_time, "Thank you!");
+static int bill_json_int(const char *json, const char *key, int dflt)
+{
+    const char *ps = strstr(json, key);
+    if (!ps) return dflt;
+    ps = strchr(ps, ':');
+    if (!ps) return dflt;
+    ps++; while (*ps == ' ') ps++;
+    return atoi(ps);
+}
+
+#if PREFETCH_ENABLE
+/* Bill the server sent while the guest was eating (owned, freed here;
+ * NULL = none).
+ * Shown at once; the real request still goes out — that is what moves
+ * the order to billing — and reconciles against it like the ledger. */
+static bool bill_show_prefetched(char *json)
+{
+    if (!json) return false;
+    bill_ledger_t *srv = (bill_ledger_t *)malloc(sizeof(*srv));
+    if (srv) bill_ledger_reset(srv);
+    if (!srv || !lbl_bill_body || bill_ledger_add_json(srv, json) < 0 || srv->overflow) {
+        free(srv);
+        free(json);
+        return false;
+    }
+    int sub   = bill_json_int(json, "\"subtotal\"", bill_ledger_subtotal(srv));
+    int gst   = bill_json_int(json, "\"gst\"",      bill_ledger_gst(sub));
+    int total = bill_json_int(json, "\"total\"",    sub + gst);
+    bill_render(srv, NULL, sub, gst, total, true);
+    bill_status("Confirming with kitchen...", COL_GREY);
+    s_ledger        = *srv;       /* what is on screen is what we diff */
+    s_bill_local    = true;
+    s_bill_local_ms = lv_tick_get();
+    free(srv);
+    free(json);
+    return true;
+}
+#endif
+
+/* Server bill JSON arrives from the net task; this job owns and frees it.
+ * It is authoritative: it replaces the local bill, and any line that
+ * does not match what we submitted is highlighted. */
+static void bill_apply(void *arg)   /* UI task */
+{
+    char *bill_json = (char *)arg;
+    bool was_local = s_bill_local;
+    s_bill_local = false;
+    if (!lbl_bill_body) { free(bill_json); return; }
+
+    bill_ledger_t *srv = bill_json ? (bill_ledger_t *)malloc(sizeof(*srv)) : NULL;
+    if (srv) bill_ledger_reset(srv);
+    if (!srv || bill_ledger_add_json(srv, bill_json) < 0) {
+        if (was_local) bill_status("Not confirmed - check with staff", COL_AMBER);
+        else lv_label_set_text(lbl_bill_body, "TOTAL:  Rs. ---  (error)");
+        free(srv);
+        free(bill_json);
+        return;
     }
 
+    /* Totals as the server computed them (flexible parsing) */
+    int sub   = bill_json_int(bill_json, "\"subtotal\"", bill_ledger_subtotal(srv));
+    int gst   = bill_json_int(bill_json, "\"gst\"",      bill_ledger_gst(sub));
+    int total = bill_json_int(bill_json, "\"total\"",    sub + gst);
+
+    int changes = was_local ? bill_ledger_diff(&s_ledger, srv) : 0;
+    bool retotal = was_local && total != g_total_bill_rupees;
+    if (was_local)
+        net_log("[BILL] server bill %lums after local, %d line change(s), total %d -> %d\n",
+                (unsigned long)lv_tick_elaps(s_bill_local_ms), changes,
+                g_total_bill_rupees, total);
+    if (!was_local || changes || retotal)
+        bill_render(srv, changes ? &s_ledger : NULL, sub, gst, total, !was_local);
+
+    if (srv->overflow) {
+        bill_status("More items than fit - see staff copy", COL_AMBER);
+    } else if (changes) {
+        char b[48];
+        snprintf(b, sizeof(b), "Updated by kitchen: %d change%s",
+                 changes, changes == 1 ? "" : "s");
+        bill_status(b, COL_AMBER);
+        /* Pay what the kitchen billed; the ledger follows it from here */
+        s_ledger = *srv;
+    } else if (retotal) {
+        bill_status("Total updated by kitchen", COL_AMBER);
+    } else if (was_local) {
+        bill_status("Confirmed " LV_SYMBOL_OK, COL_SUCCESS);
+    } else {
+        bill_status("Thank you!", COL_GREY);
+    }
+    free(srv);
     free(bill_json);
+#if PREFETCH_ENABLE
+    prefetch_link();              /* amount is final now */
+#endif
+}
+
+static void bill_fetch_job(void *arg)   /* net task */
+{
+    char *bill_json = net_request_bill((int)(intptr_t)arg, false);
+    if (!ui_post(bill_apply, bill_json)) free(bill_json);
+}
+
+static void load_bill_cb(lv_timer_t *t)
+{
+    lv_timer_del(t);
+    if (sm_get_order_id() < 0 || !lbl_bill_body) return;
+    net_post(bill_fetch_job, (void *)(intptr_t)sm_get_order_id());
 }
 
 
@@ -1208,7 +1946,7 @@ static lv_obj_t *bill_dash(lv_obj_t *parent, int y_ofs)
 {
     lv_obj_t *d = make_label(parent,
         "- - - - - - - - - - - - - - - - - - - - - - - - - - - -",
-        lv_color_hex(0x334155), &lv_font_montserrat_10);
+        COL_DIVIDER, &lv_font_montserrat_10);
     lv_obj_align(d, LV_ALIGN_TOP_LEFT, 0, y_ofs);
     return d;
 }
@@ -1310,18 +2048,124 @@ static void build_bill(void)
 
 static uint32_t paysel_entry_ms = 0;
 
+/* Amount for the group being paid (whole table unless a seat is picked) */
+static int pay_amount_rupees(void)
+{
+    bill_seat_t *st = g_pay_seat == BILL_SEAT_ALL ? NULL
+                                                  : bill_split_seat(&s_split, g_pay_seat);
+    return st ? st->total : g_total_bill_rupees;
+}
+
+static void paysel_amount_update(void)
+{
+    if (!lbl_paysel_amount) return;
+    char b[64], name[16];
+    if (g_pay_seat == BILL_SEAT_ALL)
+        snprintf(b, sizeof(b), "Amount Due: Rs. %d", pay_amount_rupees());
+    else
+        snprintf(b, sizeof(b), "%s: Rs. %d",
+                 bill_seat_name(g_pay_seat, name, sizeof(name)), pay_amount_rupees());
+    lv_label_set_text(lbl_paysel_amount, b);
+}
+
+static void paysel_seat_chips_rebuild(void);
+
+static void paysel_seat_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED) return;
+    TOUCH_LAT_MARK("payseat");
+    g_pay_seat = (int)(intptr_t)lv_event_get_user_data(e);
+    paysel_seat_chips_rebuild();
+    paysel_amount_update();
+#if PREFETCH_ENABLE
+    prefetch_link();
+#endif
+}
+
+static void paysel_seat_chip(int seat, const char *txt, bool paid)
+{
+    bool sel = seat == g_pay_seat;
+    lv_obj_t *chip = lv_btn_create(paysel_seat_row);
+    lv_obj_set_height(chip, 36);
+    lv_obj_add_style(chip, ui_theme_style(UI_STYLE_CHIP), 0);
+    if (sel)  lv_obj_add_style(chip, ui_theme_style(UI_STYLE_CHIP_SEL), 0);
+    if (paid) lv_obj_add_style(chip, ui_theme_style(UI_STYLE_CHIP_PAID), 0);
+    char b[32];
+    snprintf(b, sizeof(b), paid ? "%s " LV_SYMBOL_OK : "%s", txt);
+    lv_obj_t *l = make_label(chip, b, sel ? COL_BG : (paid ? COL_SUCCESS : COL_WHITE),
+                             &lv_font_montserrat_14);
+    lv_obj_center(l);
+    if (paid) lv_obj_add_state(chip, LV_STATE_DISABLED);
+    else lv_obj_add_event_cb(chip, paysel_seat_cb, LV_EVENT_CLICKED, (void *)(intptr_t)seat);
+}
+
+/* One chip per group on the bill; "Whole table" only until a seat pays.
+ * Hidden for a bill with a single group. */
+static void paysel_seat_chips_rebuild(void)
+{
+    if (!paysel_seat_row) return;
+    lv_obj_clean(paysel_seat_row);
+    if (s_split.count < 2) {
+        g_pay_seat = BILL_SEAT_ALL;
+        lv_obj_add_flag(paysel_seat_row, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+    bool any_paid = bill_split_unpaid(&s_split) < s_split.count;
+    bill_seat_t *cur = g_pay_seat == BILL_SEAT_ALL ? NULL
+                                                   : bill_split_seat(&s_split, g_pay_seat);
+    if (any_paid && (!cur || cur->paid)) {
+        g_pay_seat = BILL_SEAT_ALL;
+        for (int i = 0; i < s_split.count; i++)
+            if (!s_split.seats[i].paid) { g_pay_seat = s_split.seats[i].seat; break; }
+    }
+    lv_obj_clear_flag(paysel_seat_row, LV_OBJ_FLAG_HIDDEN);
+    if (!any_paid) paysel_seat_chip(BILL_SEAT_ALL, "Whole table", false);
+    for (int i = 0; i < s_split.count; i++) {
+        char name[16];
+        paysel_seat_chip(s_split.seats[i].seat,
+                         bill_seat_name(s_split.seats[i].seat, name, sizeof(name)),
+                         s_split.seats[i].paid);
+    }
+}
+
+/* A payment went through: with seats still open go back and pick the
+ * next one, otherwise on to feedback. UI task. */
+static void pay_group_settled(void)
+{
+    bill_seat_t *st = g_pay_seat == BILL_SEAT_ALL ? NULL
+                                                  : bill_split_seat(&s_split, g_pay_seat);
+    if (st) st->paid = true;
+    if (st && bill_split_unpaid(&s_split) > 0) {
+        char name[16], b[32];
+        snprintf(b, sizeof(b), "%s paid", bill_seat_name(st->seat, name, sizeof(name)));
+        create_toast(b, "Pick the next seat to pay.", 2500);
+        sm_post(EV_SEAT_PAID);
+        return;
+    }
+    sm_post(EV_PAID);
+}
+
+static void cash_select_job(void *arg)   /* net task */
+{
+    net_select_payment((int)(intptr_t)arg, g_pay_seat, "cash");
+    net_buzz(2);
+}
+
 static void upi_cb(lv_event_t *e) {
     if (lv_event_get_code(e) != LV_EVENT_CLICKED) return;
     if (lv_tick_elaps(paysel_entry_ms) < 400) return;
+    TOUCH_LAT_MARK("upi");
 
     g_razorpay_url[0] = '\0';
-    sm_set(STATE_PAYMENT_UPI);
+    sm_post(EV_PAY_UPI);
 }
 static void cash_cb(lv_event_t *e) {
     if (lv_event_get_code(e) != LV_EVENT_CLICKED) return;
     if (lv_tick_elaps(paysel_entry_ms) < 400) return;
+    TOUCH_LAT_MARK("cash");
 
-    g_pending_cash_select = true; sm_set(STATE_PAYMENT_CASH);
+    net_post(cash_select_job, (void *)(intptr_t)sm_get_order_id());
+    sm_post(EV_PAY_CASH);
 }
 
 static void build_payment_select(void)
@@ -1355,14 +2199,7 @@ static void build_payment_select(void)
         lv_obj_set_style_translate_y(icon, -40, 0);
         
         /* Floating Animation */
-        lv_anim_t a; lv_anim_init(&a);
-        lv_anim_set_var(&a, icon);
-        lv_anim_set_values(&a, -40, -55);
-        lv_anim_set_time(&a, 1500);
-        lv_anim_set_playback_time(&a, 1500);
-        lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
-        lv_anim_set_exec_cb(&a, anim_translate_y_cb);
-        lv_anim_start(&a);
+        anim_gov_loop(icon, anim_translate_y_cb, -40, -55, 1500);
 
         make_label(cu, "UPI / QR SCAN", COL_WHITE, &lv_font_montserrat_20);
         lv_obj_align(lv_obj_get_child(cu, 1), LV_ALIGN_CENTER, 0, 25);
@@ -1388,14 +2225,7 @@ static void build_payment_select(void)
         lv_obj_set_style_translate_y(icon, -40, 0);
 
         /* Floating Animation */
-        lv_anim_t a; lv_anim_init(&a);
-        lv_anim_set_var(&a, icon);
-        lv_anim_set_values(&a, -40, -55);
-        lv_anim_set_time(&a, 1800);
-        lv_anim_set_playback_time(&a, 1800);
-        lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
-        lv_anim_set_exec_cb(&a, anim_translate_y_cb);
-        lv_anim_start(&a);
+        anim_gov_loop(icon, anim_translate_y_cb, -40, -55, 1800);
 
         make_label(cc, "CASH / CARD", COL_WHITE, &lv_font_montserrat_20);
         lv_obj_align(lv_obj_get_child(cc, 1), LV_ALIGN_CENTER, 0, 25);
@@ -1403,68 +2233,61 @@ static void build_payment_select(void)
         make_label(cc, "Pay at Counter", COL_GREY, &lv_font_montserrat_12);
         lv_obj_align(lv_obj_get_child(cc, 2), LV_ALIGN_CENTER, 0, 55);
     }
+
+    /* --- Split bill: who is paying (filled on entry) --- */
+    paysel_seat_row = lv_obj_create(scr_paysel);
+    lv_obj_set_size(paysel_seat_row, 760, 48);
+    lv_obj_align(paysel_seat_row, LV_ALIGN_BOTTOM_MID, 0, -8);
+    lv_obj_add_style(paysel_seat_row, ui_theme_style(UI_STYLE_CHIP_ROW), 0);
+    lv_obj_set_flex_flow(paysel_seat_row, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(paysel_seat_row, LV_FLEX_ALIGN_CENTER,
+                          LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_clear_flag(paysel_seat_row, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(paysel_seat_row, LV_OBJ_FLAG_HIDDEN);
 }
 
 /* =====================================================================
  *  SCREEN 7A — UPI
  * ===================================================================== */
 
-/* Deferred UPI fetch — called via one-shot timer to avoid blocking in LVGL */
-static void upi_deferred_fetch_cb(lv_timer_t *t)
+/* Parse "qr_url" from the create-order reply (flexible spacing) into
+ * out; left unchanged if there is none */
+static void upi_parse_qr_url(const char *json, char *out, int out_len)
 {
-    lv_timer_del(t);
-
-    /* 1. Tell server we chose UPI */
-    net_select_payment(sm_get_order_id(), "upi");
-
-    /* 2. Fetch Razorpay Payment Link */
-    if (g_razorpay_url[0] == '\0') {
-        char *json = net_create_razorpay_order(sm_get_order_id());
-        if (json) {
-            /* Parse qr_url with flexible spacing */
-            const char *k = strstr(json, "\"qr_url\"");
-            if (k) {
-                k = strchr(k, ':');
-                if (k) {
-                    k++; while(*k == ' ') k++;
-                    if (*k == '"') k++;
-                    const char *end = strchr(k, '"');
-                    int len = end ? (int)(end - k) : 0;
-                    if (len > 0 && len < (int)sizeof(g_razorpay_url)) {
-                        memcpy(g_razorpay_url, k, len);
-                        g_razorpay_url[len] = '\0';
-                    }
-                }
-            }
-            free(json);
-        }
+    const char *k = strstr(json, "\"qr_url\"");
+    if (!k) return;
+    k = strchr(k, ':');
+    if (!k) return;
+    k++; while (*k == ' ') k++;
+    if (*k == '"') k++;
+    const char *end = strchr(k, '"');
+    int len = end ? (int)(end - k) : 0;
+    if (len > 0 && len < out_len) {
+        memcpy(out, k, len);
+        out[len] = '\0';
     }
+}
 
-    /* 3. Update QR display */
+/* QR (or the manual-payment fallback) once the link is back. UI task. */
+static void upi_qr_show(void *arg)
+{
+    (void)arg;
+    if (sm_get() != STATE_PAYMENT_UPI) return;   /* guest already left */
     if (g_razorpay_url[0] != '\0' && upi_qr_obj) {
         lv_qrcode_update(upi_qr_obj, g_razorpay_url, strlen(g_razorpay_url));
         if (upi_spinner) lv_obj_add_flag(upi_spinner, LV_OBJ_FLAG_HIDDEN);
-        {
-            lv_anim_t a; lv_anim_init(&a);
-            lv_anim_set_var(&a, upi_qr_obj);
-            lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_style_transform_zoom);
-            lv_anim_set_values(&a, 0, 256);
-            lv_anim_set_time(&a, 400);
-            lv_anim_set_path_cb(&a, lv_anim_path_overshoot);
-            lv_anim_start(&a);
-        }
-        if (upi_qr_box) {
-            lv_anim_t bp; lv_anim_init(&bp);
-            lv_anim_set_var(&bp, upi_qr_box);
-            lv_anim_set_exec_cb(&bp, (lv_anim_exec_xcb_t)lv_obj_set_style_border_opa);
-            lv_anim_set_values(&bp, 100, 255);
-            lv_anim_set_time(&bp, 1200);
-            lv_anim_set_playback_time(&bp, 1200);
-            lv_anim_set_repeat_count(&bp, LV_ANIM_REPEAT_INFINITE);
-            lv_anim_start(&bp);
-        }
-        net_buzz(2);
+        lv_anim_t a; lv_anim_init(&a);
+        lv_anim_set_var(&a, upi_qr_obj);
+        lv_anim_set_values(&a, 0, 256);
+        lv_anim_set_time(&a, anim_gov_time(400));
+        lv_anim_set_exec_cb(&a, anim_zoom_cb);
+        lv_anim_set_path_cb(&a, lv_anim_path_overshoot);
+        lv_anim_start(&a);
+        /* Border pulse rests at full opacity when the governor stops it */
+        if (upi_qr_box) anim_gov_loop(upi_qr_box, anim_border_opa_cb, 255, 100, 1200);
+        ui_buzz(2);
     } else {
+        /* QR failed — show fallback */
         if (upi_spinner) lv_obj_add_flag(upi_spinner, LV_OBJ_FLAG_HIDDEN);
         if (upi_qr_label) {
             lv_obj_clear_flag(upi_qr_label, LV_OBJ_FLAG_HIDDEN);
@@ -1474,21 +2297,262 @@ static void upi_deferred_fetch_cb(lv_timer_t *t)
             lv_label_set_text(lbl_payment_result, "Manual payment - staff notified");
             lv_obj_set_style_text_color(lbl_payment_result, COL_AMBER, 0);
         }
-        net_buzz(1);
+        ui_buzz(1);
+    }
+}
+
+/* UPI link creation: the link comes back in the request, and only the
+ * UI task copies it into g_razorpay_url */
+typedef struct {
+    int  oid, seat;
+    char url[sizeof(g_razorpay_url)];
+} upi_link_req_t;
+
+static void upi_link_done(void *arg)        /* UI task */
+{
+    upi_link_req_t *r = (upi_link_req_t *)arg;
+    /* A reply for a payment the guest has since left is dropped */
+    bool current = sm_get() == STATE_PAYMENT_UPI &&
+                   r->oid == sm_get_order_id() && r->seat == g_pay_seat;
+    if (current) snprintf(g_razorpay_url, sizeof(g_razorpay_url), "%s", r->url);
+    free(r);
+    if (current) upi_qr_show(NULL);
+}
+
+static void upi_fetch_job(void *arg)        /* net task (blocking HTTP) */
+{
+    upi_link_req_t *r = (upi_link_req_t *)arg;
+    net_log("[NET] Fetching UPI link for order #%d\n", r->oid);
+
+    net_select_payment(r->oid, r->seat, "upi");
+    char *json = net_create_razorpay_order(r->oid, r->seat, false);
+    if (json) {
+        upi_parse_qr_url(json, r->url, sizeof(r->url));
+        free(json);
+    }
+    if (!ui_post(upi_link_done, r)) free(r);
+}
+
+static void upi_fetch_post(int oid)         /* UI task, on UPI entry */
+{
+    upi_link_req_t *r = (upi_link_req_t *)calloc(1, sizeof(*r));
+    if (!r) return;
+    r->oid  = oid;
+    r->seat = g_pay_seat;
+    if (!net_post(upi_fetch_job, r)) free(r);
+}
+
+/* ---- Prefetch (see s_pf_gen) ---- */
+#if PREFETCH_ENABLE
+typedef struct {
+    int      oid, seat, paise;
+    uint32_t gen;
+    char    *json;      /* reply, malloc'd by net_* */
+} prefetch_req_t;
+
+static void prefetch_invalidate(void)
+{
+    s_pf_gen++;
+    free(s_pf_bill);
+    s_pf_bill    = NULL;
+    s_pf_link[0] = '\0';
+}
+
+static prefetch_req_t *prefetch_req(int oid)
+{
+    prefetch_req_t *r = (prefetch_req_t *)calloc(1, sizeof(*r));
+    if (r) { r->oid = oid; r->gen = s_pf_gen; }
+    return r;
+}
+
+static bool prefetch_current(const prefetch_req_t *r)
+{
+    return r->json && r->gen == s_pf_gen && r->oid == sm_get_order_id();
+}
+
+static void pf_bill_done(void *arg)   /* UI task */
+{
+    prefetch_req_t *r = (prefetch_req_t *)arg;
+    s_pf_bill_busy = false;
+    if (prefetch_current(r)) {
+        free(s_pf_bill);
+        s_pf_bill     = r->json;
+        s_pf_bill_oid = r->oid;
+        net_log("[PREFETCH] bill for order #%d ready\n", r->oid);
+    } else {
+        free(r->json);
     }
+    free(r);
+}
+
+static void pf_bill_job(void *arg)    /* net task */
+{
+    prefetch_req_t *r = (prefetch_req_t *)arg;
+    r->json = net_request_bill(r->oid, true);
+    if (!ui_post(pf_bill_done, r)) { free(r->json); free(r); s_pf_bill_busy = false; }
 }
 
+/* Entry to FOOD_SERVED: the bill is all but certain to be asked for */
+static void prefetch_bill(void)
+{
+    int oid = sm_get_order_id();
+    if (oid <= 0 || s_pf_bill_busy || (s_pf_bill && s_pf_bill_oid == oid)) return;
+    prefetch_req_t *r = prefetch_req(oid);
+    if (!r) return;
+    s_pf_bill_busy = true;
+    if (!net_post(pf_bill_job, r)) { free(r); s_pf_bill_busy = false; }
+}
+
+/* The prefetched bill for the current order (caller owns it), or NULL */
+static char *prefetch_take_bill(void)
+{
+    char *j = s_pf_bill_oid == sm_get_order_id() ? s_pf_bill : NULL;
+    if (j) s_pf_bill = NULL;
+    return j;
+}
+
+static bool prefetch_link_hit(int oid, int seat, int paise)
+{
+    return s_pf_link[0] && s_pf_link_oid == oid && s_pf_link_seat == seat &&
+           s_pf_link_paise == paise;
+}
+
+static void pf_link_done(void *arg)   /* UI task */
+{
+    prefetch_req_t *r = (prefetch_req_t *)arg;
+    s_pf_link_busy = false;
+    bool ok = prefetch_current(r);
+    if (ok) {
+        s_pf_link[0] = '\0';
+        upi_parse_qr_url(r->json, s_pf_link, sizeof(s_pf_link));
+        s_pf_link_oid   = r->oid;
+        s_pf_link_seat  = r->seat;
+        s_pf_link_paise = r->paise;
+        net_log("[PREFETCH] UPI link for order #%d seat %d ready\n", r->oid, r->seat);
+    }
+    free(r->json);
+    free(r);
+    if (ok) prefetch_link();      /* guest may have picked another seat meanwhile */
+}
+
+static void pf_link_job(void *arg)    /* net task */
+{
+    prefetch_req_t *r = (prefetch_req_t *)arg;
+    r->json = net_create_razorpay_order(r->oid, r->seat, true);
+    if (!ui_post(pf_link_done, r)) { free(r->json); free(r); s_pf_link_busy = false; }
+}
+
+/* Bill and payment-select screens: have a link ready for the group the
+ * guest would pay now. Keyed by the amount, so a bill the kitchen
+ * changed asks for a new one. */
+static void prefetch_link(void)
+{
+    app_state_t st = sm_get();
+    int oid   = sm_get_order_id();
+    int paise = pay_amount_rupees() * 100;
+    if ((st != STATE_BILL && st != STATE_PAYMENT_SELECT) || oid <= 0 || paise <= 0 ||
+        s_pf_link_busy || prefetch_link_hit(oid, g_pay_seat, paise))
+        return;
+    prefetch_req_t *r = prefetch_req(oid);
+    if (!r) return;
+    r->seat  = g_pay_seat;
+    r->paise = paise;
+    s_pf_link_busy = true;
+    if (!net_post(pf_link_job, r)) { free(r); s_pf_link_busy = false; }
+}
+
+static void upi_select_job(void *arg)   /* net task */
+{
+    net_select_payment((int)(intptr_t)arg, g_pay_seat, "upi");
+}
+
+/* Entry to PAYMENT_UPI: QR from the prefetched link, if it is for this
+ * exact payment. Used once; a retry creates a fresh link. */
+static bool upi_show_prefetched(void)
+{
+    int oid = sm_get_order_id();
+    if (!prefetch_link_hit(oid, g_pay_seat, pay_amount_rupees() * 100)) return false;
+    snprintf(g_razorpay_url, sizeof(g_razorpay_url), "%s", s_pf_link);
+    s_pf_link[0] = '\0';
+    net_post(upi_select_job, (void *)(intptr_t)oid);
+    upi_qr_show(NULL);
+    return true;
+}
+#endif /* PREFETCH_ENABLE */
+
 static void upi_goto_feedback_cb(lv_timer_t *t) {
-    lv_timer_del(t); sm_set(STATE_FEEDBACK);
+    lv_timer_del(t); pay_group_settled();
+}
+
+/* UPI payment status poll: the timer posts a net job, the result comes
+ * back through ui_post(). NEVER calls HTTP here. */
+#define UPI_POLL_PENDING  0
+#define UPI_POLL_PAID     1
+#define UPI_POLL_FAILED   2
+static volatile bool s_upi_poll_busy = false;
+
+static void upi_timeout_job(void *arg)   /* net task */
+{
+    net_payment_timeout((int)(intptr_t)arg, g_pay_seat);
+    net_buzz(1);
+}
+
+static void upi_poll_done(void *arg)     /* UI task */
+{
+    int res = (int)(intptr_t)arg;
+    s_upi_poll_busy = false;
+    if (upi_poll_timer == NULL) return;   /* left the UPI screen */
+
+    if (res == UPI_POLL_PAID) {
+        safe_timer_del(&upi_poll_timer);
+        if (lbl_payment_result) {
+            lv_label_set_text(lbl_payment_result, "PAYMENT SUCCESSFUL " LV_SYMBOL_OK);
+            lv_obj_set_style_text_color(lbl_payment_result, COL_SUCCESS, 0);
+        }
+        lv_timer_t *gt = lv_timer_create(upi_goto_feedback_cb, 2000, NULL);
+        if (gt) lv_timer_set_repeat_count(gt, 1);
+        ui_buzz(3);
+    } else if (res == UPI_POLL_FAILED) {
+        safe_timer_del(&upi_poll_timer);
+        if (lbl_payment_result) {
+            lv_label_set_text(lbl_payment_result, "Staff Coming for Payment");
+            lv_obj_set_style_text_color(lbl_payment_result, COL_ERROR, 0);
+        }
+        ui_buzz(1);
+    } else if (upi_timeout_count >= 100) {
+        safe_timer_del(&upi_poll_timer);
+        if (lbl_payment_result) {
+            lv_label_set_text(lbl_payment_result, "Staff Coming for Payment");
+            lv_obj_set_style_text_color(lbl_payment_result, COL_AMBER, 0);
+        }
+        net_post(upi_timeout_job, (void *)(intptr_t)sm_get_order_id());
+    }
+}
+
+static void upi_poll_job(void *arg)      /* net task */
+{
+    int oid  = (int)(intptr_t)arg;
+    int seat = g_pay_seat;
+    char status[NET_STATUS_LEN];
+    net_get_payment_status(oid, seat, status, sizeof(status));
+    /* If still pending, also try razorpay-specific endpoint */
+    if (strcmp(status, "pending") == 0)
+        net_get_razorpay_status(oid, seat, status, sizeof(status));
+
+    int res = UPI_POLL_PENDING;
+    if (strcmp(status, "paid") == 0 || strcmp(status, "verified") == 0) res = UPI_POLL_PAID;
+    else if (strcmp(status, "failed") == 0)                              res = UPI_POLL_FAILED;
+    if (!ui_post(upi_poll_done, (void *)(intptr_t)res)) s_upi_poll_busy = false;
 }
 
-/* UPI poll timer: sets a flag for deferred network call, NEVER calls HTTP here */
 static void upi_poll_cb(lv_timer_t *t)
 {
     if (upi_poll_timer == NULL) return;
     upi_timeout_count++;
-    /* Set flag — actual HTTP done in ui_check_deferred outside mutex */
-    g_pending_upi_poll = true;
+    if (s_upi_poll_busy) return;
+    s_upi_poll_busy = true;
+    if (!net_post(upi_poll_job, (void *)(intptr_t)sm_get_order_id()))
+        s_upi_poll_busy = false;
 }
 
 
@@ -1591,18 +2655,32 @@ static void build_upi(void)
 /* =====================================================================
  *  SCREEN 7B — CASH
  * ===================================================================== */
-static void cash_poll_cb(lv_timer_t *t)
+static volatile bool s_cash_poll_busy = false;
+
+static void cash_paid_done(void *arg)   /* UI task */
 {
-    if (cash_poll_timer == NULL) return;
-    char status[32];
-    net_get_payment_status(sm_get_order_id(), status, sizeof(status));
-    
+    s_cash_poll_busy = false;
+    if (cash_poll_timer == NULL || !arg) return;
+    safe_timer_del(&cash_poll_timer);
+    ui_buzz(3);
+    pay_group_settled();
+}
+
+static void cash_poll_job(void *arg)    /* net task */
+{
+    char status[NET_STATUS_LEN] = "";
+    net_get_payment_status((int)(intptr_t)arg, g_pay_seat, status, sizeof(status));
     /* SYNC FIX: check for "paid" (set by chef verify_payment/verify_manual) */
-    if (strcmp(status, "paid") == 0) {
-        safe_timer_del(&cash_poll_timer);
-        net_buzz(3);
-        sm_set(STATE_FEEDBACK);
-    }
+    bool paid = (strcmp(status, "paid") == 0);
+    if (!ui_post(cash_paid_done, (void *)(intptr_t)paid)) s_cash_poll_busy = false;
+}
+
+static void cash_poll_cb(lv_timer_t *t)
+{
+    if (cash_poll_timer == NULL || s_cash_poll_busy) return;
+    s_cash_poll_busy = true;
+    if (!net_post(cash_poll_job, (void *)(intptr_t)sm_get_order_id()))
+        s_cash_poll_busy = false;
 }
 
 static void build_cash(void)
@@ -1640,13 +2718,14 @@ static lv_obj_t *feedback_bar = NULL;
 static void star_cb(lv_event_t *e)
 {
     int idx = (int)(intptr_t)lv_event_get_user_data(e);
+    TOUCH_LAT_MARK("star");
     g_stars = idx + 1;
     for (int i = 0; i < 5; i++) {
         if (!star_btns[i]) continue;
         bool filled = (i <= idx);
         lv_obj_set_style_bg_color(star_btns[i], filled ? COL_AMBER : COL_CARD, 0);
         lv_obj_t *sl = lv_obj_get_child(star_btns[i], 0);
-        if (sl) lv_obj_set_style_text_color(sl, filled ? lv_color_hex(0x0A0A0A) : COL_AMBER, 0);
+        if (sl) lv_obj_set_style_text_color(sl, filled ? COL_BTN_TEXT : COL_AMBER, 0);
     }
     if (lbl_star_rating) lv_label_set_text(lbl_star_rating, star_rating_labels[idx]);
     /* BUG 5: High-impact bounce scale animate the tapped star */
@@ -1656,8 +2735,8 @@ static void star_cb(lv_event_t *e)
         lv_anim_set_var(&a, star_btns[idx]);
         lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_style_transform_zoom);
         lv_anim_set_values(&a, 256, 400); /* 1.56x Zoom */
-        lv_anim_set_time(&a, 200);
-        lv_anim_set_playback_time(&a, 150);
+        lv_anim_set_time(&a, anim_gov_time(200));
+        lv_anim_set_playback_time(&a, anim_gov_time(150));
         lv_anim_start(&a);
     }
 }
@@ -1673,33 +2752,41 @@ static void feedback_timer_cb(lv_timer_t *t)
     if (feedback_bar) lv_bar_set_value(feedback_bar, fb_seconds, LV_ANIM_OFF);
     if (fb_seconds <= 0) {
         if (t) { lv_timer_del(t); feedback_timer = NULL; }
-        /* BUG 5 FIX: Auto-submit also requires state reset */
-        cart_clear();
-        sm_set_order_id(0);
-        g_append_mode   = false;
-        g_star_rating   = 0;
-        g_stars         = 0;
-        g_last_status[0] = '\0';
-        g_razorpay_url[0] = '\0';
-        sm_set(STATE_SPLASH);
+        /* BUG 5 FIX: Auto-submit also requires state reset (FEEDBACK exit) */
+        sm_post(EV_SESSION_END);
     }
 }
 
+typedef struct {
+    int  oid;
+    int  stars;
+    char comment[];
+} feedback_req_t;
+
+static void submit_feedback_job(void *arg)   /* net task */
+{
+    feedback_req_t *req = (feedback_req_t *)arg;
+    net_submit_feedback(req->oid, req->stars, req->comment);
+    free(req);
+}
+
 static void submit_feedback_cb(lv_event_t *e)
 {
+    TOUCH_LAT_MARK("feedback");
     const char *comment = feedback_ta ? lv_textarea_get_text(feedback_ta) : "";
-    net_submit_feedback(sm_get_order_id(), g_stars, comment);
+    /* Copy out of the textarea: the screen may be gone before the POST runs */
+    size_t clen = strlen(comment);
+    feedback_req_t *req = (feedback_req_t *)malloc(sizeof(*req) + clen + 1);
+    if (req) {
+        req->oid   = sm_get_order_id();
+        req->stars = g_stars;
+        memcpy(req->comment, comment, clen + 1);
+        if (!net_post(submit_feedback_job, req)) free(req);
+    }
     safe_timer_del(&feedback_timer);
-    
-    /* Full Reset */
-    cart_clear();
-    sm_set_order_id(0);
-    g_append_mode   = false;
-    g_star_rating   = 0;
-    g_stars         = 0;
-    g_last_status[0] = '\0';
-    g_razorpay_url[0] = '\0';
-    sm_set(STATE_SPLASH);
+
+    /* Full Reset: FEEDBACK exit action */
+    sm_post(EV_SESSION_END);
 }
 
 /* Keyboard show/hide — also reposition submit button to stay visible */
@@ -1812,28 +2899,408 @@ static void build_feedback(void)
 /* =====================================================================
  *  PUBLIC API
  * ===================================================================== */
+#if UI_SCROLL_BENCH
+/* Scroll-FPS benchmark: step the grid down and back up, forcing a full
+ * refresh per step, and report the mean frame time. Runs once, shortly
+ * after the menu is first shown; compare UI_CARD_SKINS 0 vs 1. */
+static void menu_scroll_bench_cb(lv_timer_t *t)
+{
+    (void)t;
+    const int steps = 60, dy = 24;
+    if (!menu_grid || lv_scr_act() != scr_menu) return;
+    uint32_t t0 = lv_tick_get();
+    for (int i = 0; i < steps; i++) {
+        lv_obj_scroll_by(menu_grid, 0, (i < steps / 2) ? -dy : dy, LV_ANIM_OFF);
+        lv_refr_now(NULL);
+    }
+    uint32_t ms = lv_tick_elaps(t0);
+    net_log("[BENCH] menu scroll: %d frames in %lu ms = %lu.%lu ms/frame, skins=%d\n",
+            steps, (unsigned long)ms, (unsigned long)(ms / steps),
+            (unsigned long)((ms * 10 / steps) % 10), UI_CARD_SKINS);
+}
+#endif
+
+/* ---- Lazy screens ----------------------------------------------------
+ * Screens are built the first time they are shown. Splash and menu are
+ * pinned (every session returns to them); the rest live in an LRU and
+ * the least recently used is deleted once their combined LVGL heap cost
+ * exceeds UI_SCREEN_MEM_BUDGET. Each reset hook clears the widget
+ * handles owned by its screen so stale pointers are never touched. */
+static void reset_placed(void)   { lbl_order_id_placed = NULL; }
+static void reset_bill(void)
+{
+    bill_items_col = NULL; lbl_bill_body = NULL;
+    lbl_bill_sub = NULL; lbl_bill_gst = NULL; lbl_bill_time = NULL;
+}
+static void reset_ready(void)    { ready_card = NULL; }
+static void reset_paysel(void)   { lbl_paysel_amount = NULL; paysel_seat_row = NULL; }
+static void reset_upi(void)
+{
+    lbl_upi_amount = NULL; lbl_payment_result = NULL;
+    upi_qr_box = NULL; upi_qr_obj = NULL; upi_spinner = NULL;
+    upi_info_card = NULL; upi_qr_label = NULL;
+}
+static void reset_cash(void)     { cash_circle = NULL; cash_amt_lbl = NULL; lbl_cash_amount = NULL; }
+static void reset_feedback(void)
+{
+    feedback_ta = NULL; lbl_star_rating = NULL; fb_submit_btn = NULL;
+    fb_keyboard = NULL; lbl_fb_countdown = NULL;
+    memset(star_btns, 0, sizeof(star_btns));
+}
+
+typedef struct {
+    lv_obj_t **scr;
+    void     (*build)(void);
+    void     (*reset)(void);
+    bool       pinned;
+    uint32_t   bytes;      /* LVGL heap cost measured at build */
+    uint32_t   build_us;   /* duration of the last build        */
+    uint32_t   last_used;  /* LRU stamp */
+} screen_slot_t;
+
+static screen_slot_t s_screens[STATE_COUNT] = {
+    [STATE_SPLASH]         = { &scr_splash,      build_splash,         NULL,           true  },
+    [STATE_MENU]           = { &scr_menu,        build_menu,           NULL,           true  },
+    [STATE_ORDER_PLACED]   = { &scr_placed,      build_order_placed,   reset_placed,   false },
+    [STATE_FOOD_READY]     = { &scr_ready,       build_food_ready,     reset_ready,    false },
+    [STATE_FOOD_SERVED]    = { &scr_food_served, build_food_served,    NULL,           false },
+    [STATE_BILL]           = { &scr_bill,        build_bill,           reset_bill,     false },
+    [STATE_PAYMENT_SELECT] = { &scr_paysel,      build_payment_select, reset_paysel,   false },
+    [STATE_PAYMENT_UPI]    = { &scr_upi,         build_upi,            reset_upi,      false },
+    [STATE_PAYMENT_CASH]   = { &scr_cash,        build_cash,           reset_cash,     false },
+    [STATE_FEEDBACK]       = { &scr_feedback,    build_feedback,       reset_feedback, false },
+};
+static uint32_t s_lru_clock = 0;
+
+static uint32_t ui_heap_used(void)
+{
+    lv_mem_monitor_t m;
+    lv_mem_monitor(&m);
+    return (uint32_t)(m.total_size - m.free_size);
+}
+
+static void screen_release(app_state_t st)
+{
+    screen_slot_t *ss = &s_screens[st];
+    if (!*ss->scr) return;
+    lv_obj_del(*ss->scr);
+    *ss->scr = NULL;
+    if (ss->reset) ss->reset();
+    ss->bytes = 0;
+}
+
+/* Evict LRU screens until the unpinned ones fit the budget. Never the
+ * active screen, the one being loaded, or one still animating out. */
+static void screens_trim(app_state_t keep)
+{
+    lv_disp_t *d   = lv_disp_get_default();
+    lv_obj_t  *act = lv_scr_act();
+    lv_obj_t  *prev = d ? d->prev_scr : NULL;
+    for (;;) {
+        uint32_t total = 0;
+        int victim = -1;
+        for (int i = 0; i < STATE_COUNT; i++) {
+            screen_slot_t *ss = &s_screens[i];
+            if (ss->pinned || !*ss->scr) continue;
+            total += ss->bytes;
+            if (i == (int)keep || *ss->scr == act || *ss->scr == prev) continue;
+            if (victim < 0 || ss->last_used < s_screens[victim].last_used) victim = i;
+        }
+        if (total <= UI_SCREEN_MEM_BUDGET || victim < 0) return;
+        net_log("[UI] Evict screen %d (%lu B, budget %lu B)\n", victim,
+                (unsigned long)s_screens[victim].bytes,
+                (unsigned long)UI_SCREEN_MEM_BUDGET);
+        screen_release((app_state_t)victim);
+    }
+}
+
+static void screen_ensure(app_state_t st)
+{
+    screen_slot_t *ss = &s_screens[st];
+    ss->last_used = ++s_lru_clock;
+    if (*ss->scr) return;
+
+    uint32_t m0 = ui_heap_used();
+    uint32_t t0 = (uint32_t)micros();
+    ss->build();
+    ss->build_us = (uint32_t)micros() - t0;
+    uint32_t m1 = ui_heap_used();
+    ss->bytes = (m1 > m0) ? m1 - m0 : 0;
+
+    lv_mem_monitor_t m;
+    lv_mem_monitor(&m);
+    net_log("[UI] Built screen %d in %lu.%lu ms, %lu B (LVGL heap peak %lu B)\n",
+            st, (unsigned long)(ss->build_us / 1000),
+            (unsigned long)(ss->build_us % 1000 / 100), (unsigned long)ss->bytes,
+            (unsigned long)m.max_used);
+    if (!ss->pinned) screens_trim(st);
+}
+
+void ui_screen_build_stats(app_state_t st, uint32_t *build_us, uint32_t *bytes)
+{
+    if (build_us) *build_us = s_screens[st].build_us;
+    if (bytes)    *bytes    = s_screens[st].bytes;
+}
+
+/* Session over (paid, or the server no longer knows the order): the
+ * next party starts clean */
+static void session_reset(void)
+{
+#if PREFETCH_ENABLE
+    prefetch_invalidate();
+#endif
+    cart_clear();
+    cart_set_seat(0);            /* next party starts on the shared cart */
+#if LIVE_CART_SYNC
+    live_cart_new();
+#endif
+    bill_ledger_reset(&s_ledger);
+    sm_set_order_id(0);
+    g_append_mode   = false;
+    g_star_rating   = 0;
+    g_stars         = 0;
+    g_last_status[0] = '\0';
+    g_razorpay_url[0] = '\0';
+}
+
+/* ---- Session snapshot / resume (session_store.c) ---- */
+#if SESSION_RESUME
+static void session_save_job(void *arg)   /* net task; NULL = no session */
+{
+    session_snapshot_t *ss = (session_snapshot_t *)arg;
+    if (!ss) { session_store_clear(); return; }
+    if (session_store_save(ss) != 0) net_log("[SESSION] NVS write failed\n");
+    free(ss);
+}
+
+static void session_fill(session_snapshot_t *ss)
+{
+    memset(ss, 0, sizeof(*ss));   /* padding too: snapshots compare bytewise */
+    ss->version     = SESSION_VERSION;
+    ss->state       = (uint8_t)sm_get();
+    ss->append_mode = g_append_mode;
+    ss->order_id    = sm_get_order_id();
+    ss->pay_seat    = g_pay_seat;
+    ss->bill_total  = g_total_bill_rupees;
+    ss->split       = s_split;
+    ss->active_seat = (uint8_t)cart_get_seat();
+    if (s_resume.cart_count) {
+        /* Restored cart not applied yet (no menu): keep it as it was */
+        ss->cart_count = s_resume.cart_count;
+        memcpy(ss->cart, s_resume.cart, sizeof(ss->cart[0]) * s_resume.cart_count);
+        return;
+    }
+    for (const cart_item_t *it = cart_first(); it && ss->cart_count < CART_HARD_CAP;
+         it = cart_next(it)) {
+        session_cart_line_t *ln = &ss->cart[ss->cart_count++];
+        ln->id   = it->id;
+        ln->seat = it->seat;
+        ln->qty  = it->qty;
+    }
+}
+
+/* UI task: on every transition and from session_timer. The flash write
+ * itself runs on the net task, and only if the bytes changed. */
+static void session_save(void)
+{
+    static session_snapshot_t ss;
+    session_fill(&ss);
+    int len = ss.state == STATE_SPLASH ? 0 : session_snapshot_size(&ss);
+    if (len == s_sess_last_len && memcmp(&ss, &s_sess_last, len) == 0) return;
+
+    session_snapshot_t *copy = NULL;
+    if (len) {
+        copy = (session_snapshot_t *)malloc(len);
+        if (!copy) return;
+        memcpy(copy, &ss, len);
+    }
+    if (!net_post(session_save_job, copy)) { free(copy); return; }   /* next tick */
+    memcpy(&s_sess_last, &ss, len);
+    s_sess_last_len = len;
+}
+
+static void session_timer_cb(lv_timer_t *t) { (void)t; session_save(); }
+
+/* Restored cart lines are priced from the menu, so they wait for it.
+ * Items that left the menu meanwhile are dropped. */
+static void resume_cart_apply(void)
+{
+    if (s_resume.cart_count == 0 || menu_model_count() == 0) return;
+    int lines = 0, dropped = 0;
+    for (int i = 0; i < s_resume.cart_count; i++) {
+        const session_cart_line_t *ln = &s_resume.cart[i];
+        int idx = menu_model_find(ln->id);
+        const menu_item_t *m = idx >= 0 ? menu_model_get(idx) : NULL;
+        if (!m || !m->available) { dropped++; continue; }
+        cart_set_seat(ln->seat);
+        for (int q = 0; q < ln->qty; q++)
+            cart_add(m->id, m->name, m->price_paise, m->is_veg);
+        lines++;
+    }
+    cart_set_seat(s_resume.active_seat);
+    s_resume.cart_count = 0;
+    refresh_cart_panel();
+    net_log("[SESSION] cart restored: %d line(s), %d no longer on the menu\n",
+            lines, dropped);
+}
+
+/* Verdict of the background order check, packed with the order id */
+#define RESUME_OK    0
+#define RESUME_GONE  1     /* server has no such order      */
+#define RESUME_PAID  2     /* paid while the table was down */
+
+static void resume_checked(void *arg)   /* UI task */
+{
+    int v   = (int)(intptr_t)arg;
+    int oid = v >> 2;
+    app_state_t st = sm_get();
+    if (oid != sm_get_order_id()) return;   /* session moved on meanwhile */
+
+    switch (v & 3) {
+        case RESUME_GONE:
+            if (st == STATE_SPLASH || st == STATE_FEEDBACK) break;
+            net_log("[SESSION] order #%d unknown to server, starting over\n", oid);
+            session_reset();
+            sm_post(EV_ORDER_LOST);
+            break;
+        case RESUME_PAID:
+            sm_post(EV_PAID_REMOTELY);   /* only from the bill/payment screens */
+            break;
+        default:
+            /* These screens fetched before WiFi was up: fetch again */
+            if (st == STATE_BILL)
+                net_post(bill_fetch_job, (void *)(intptr_t)oid);
+            else if (st == STATE_PAYMENT_UPI)
+                upi_fetch_post(oid);
+            break;
+    }
+}
+
+static void resume_check(void)   /* net task, WiFi up */
+{
+    int oid = s_resume_check_oid;
+    static char json[1024];
+    int rc = net_get_order_json(oid, json, sizeof(json));
+    if (rc == -1) return;                    /* no answer: next round */
+
+    int v = RESUME_OK;
+    if (rc == -2) {
+        v = RESUME_GONE;
+    } else {
+        char status[32];
+        order_json_status(json, status, sizeof(status));
+        if (strcmp(status, "paid") == 0) v = RESUME_PAID;
+    }
+    if (ui_post(resume_checked, (void *)(intptr_t)((oid << 2) | v)))
+        s_resume_check_oid = 0;
+}
+#endif /* SESSION_RESUME */
+
+bool ui_resume_session(void)
+{
+#if SESSION_RESUME
+    LVGL_ASSERT_LOCKED();
+    session_snapshot_t *ss = &s_resume;
+    if (!session_store_load(ss)) return false;
+    bool has_order = ss->order_id > 0;
+    if (ss->state <= STATE_SPLASH || ss->state >= STATE_COUNT ||
+        (ss->state != STATE_MENU && !has_order)) {
+        ss->cart_count = 0;
+        session_store_clear();
+        return false;
+    }
+    if (has_order) sm_set_order_id(ss->order_id);
+    g_append_mode       = ss->append_mode;
+    g_pay_seat          = ss->pay_seat;
+    g_total_bill_rupees = ss->bill_total;
+    s_split             = ss->split;
+    cart_set_seat(ss->active_seat);
+    /* What was submitted before the reset is only on the server now:
+     * the bill waits for it instead of showing a partial ledger. */
+    s_ledger.overflow   = has_order;
+    s_resume_check_oid  = has_order ? ss->order_id : 0;
+
+    sm_resume((app_state_t)ss->state);
+    net_log("[SESSION] resumed %s, order #%d, %d cart line(s) pending menu\n",
+            sm_state_name((app_state_t)ss->state), ss->order_id, ss->cart_count);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* ---- State machine actions (state_machine.c calls these) ---- */
+static void ui_state_enter(app_state_t state, app_state_t from)
+{
+    (void)from;
+    ui_show_screen(state);
+#if SESSION_RESUME
+    session_save();
+#endif
+}
+
+/* Each state stops what it started, so nothing it scheduled can fire on
+ * the next screen. */
+static void ui_state_exit(app_state_t state, app_state_t to)
+{
+    (void)to;
+    switch (state) {
+        case STATE_ORDER_PLACED: safe_timer_del(&poll_timer);      break;
+        case STATE_PAYMENT_UPI:  safe_timer_del(&upi_poll_timer);  break;
+        case STATE_PAYMENT_CASH: safe_timer_del(&cash_poll_timer); break;
+        case STATE_FEEDBACK:
+            safe_timer_del(&feedback_timer);
+            session_reset();
+            break;
+        default: break;
+    }
+}
+
+/* Build the menu screen ahead of first use while the guest sits on the
+ * splash. One-shot lv_timer: runs on the UI task once the splash fade is
+ * done, so no other task holds the LVGL lock through the build. */
+static void ui_prewarm_cb(lv_timer_t *t)
+{
+    (void)t;
+    if (sm_get() != STATE_SPLASH || scr_menu) return;
+    screen_ensure(STATE_MENU);
+}
+
 void ui_init(void)
 {
-    build_splash(); build_menu(); build_order_placed(); build_food_ready();
-    build_food_served();
-    build_bill(); build_payment_select(); build_upi(); build_cash(); build_feedback();
+    ui_theme_init();
+    for (int st = 0; st < STATE_COUNT; st++)
+        sm_bind((app_state_t)st, ui_state_enter, ui_state_exit);
+    /* Only the boot screen is built here; the rest on first use */
+    screen_ensure(STATE_SPLASH);
+#if SESSION_RESUME
+    /* Cart edits and seat-by-seat payments between transitions */
+    lv_timer_create(session_timer_cb, SESSION_SAVE_MS, NULL);
+#endif
+#if LIVE_CART_SYNC
+    live_cart_new();             /* reads the boot epoch: flash, so here */
+    lv_timer_create(live_cart_timer_cb, LIVE_CART_BATCH_MS, NULL);
+#endif
+    lv_timer_t *pw = lv_timer_create(ui_prewarm_cb, UI_PREWARM_MS, NULL);
+    if (pw) lv_timer_set_repeat_count(pw, 1);
 }
 
 void ui_show_screen(app_state_t state)
 {
-    net_log("[UI] Transition to state %d\n", state);
-    /* Safe Cleanup: Central authority for timer destruction */
-    safe_timer_del(&poll_timer);
-    safe_timer_del(&upi_poll_timer);
-    safe_timer_del(&cash_poll_timer);
-    safe_timer_del(&feedback_timer);
+    LVGL_ASSERT_LOCKED();
+    /* Timers of the state being left are stopped by ui_state_exit */
+
+    /* Food-served screen is rebuilt on each visit (fresh animation state) */
+    if (state == STATE_FOOD_SERVED && scr_food_served != lv_scr_act())
+        screen_release(STATE_FOOD_SERVED);
+    screen_ensure(state);
 
     switch (state) {
         case STATE_SPLASH:
-            lv_scr_load_anim(scr_splash, LV_SCR_LOAD_ANIM_FADE_IN, 400, 0, false);
+            lv_scr_load_anim(scr_splash, LV_SCR_LOAD_ANIM_FADE_IN, anim_gov_time(400), 0, false);
             break;
         case STATE_MENU: {
-            lv_scr_load_anim(scr_menu, LV_SCR_LOAD_ANIM_MOVE_LEFT, 400, 0, false);
+            lv_scr_load_anim(scr_menu, LV_SCR_LOAD_ANIM_MOVE_LEFT, anim_gov_time(400), 0, false);
             /* BUG 1 FIX: update banner/title logic */
             if (lbl_append_banner) {
                 if (g_append_mode) {
@@ -1859,10 +3326,19 @@ void ui_show_screen(app_state_t state)
                                       g_append_mode ? "ADD TO ORDER" : "PLACE ORDER");
             }
             refresh_cart_panel();
+            cart_seat_label_update();
+#if UI_SCROLL_BENCH
+            { static bool benched = false;
+              if (!benched) {
+                  benched = true;
+                  lv_timer_t *bt = lv_timer_create(menu_scroll_bench_cb, 1500, NULL);
+                  if (bt) lv_timer_set_repeat_count(bt, 1);
+              } }
+#endif
             break;
         }
         case STATE_ORDER_PLACED:
-            lv_scr_load_anim(scr_placed, LV_SCR_LOAD_ANIM_FADE_IN, 300, 0, false);
+            lv_scr_load_anim(scr_placed, LV_SCR_LOAD_ANIM_FADE_IN, anim_gov_time(300), 0, false);
             if (lbl_order_id_placed && sm_get_order_id() > 0) {
                 char buf[48];
                 snprintf(buf, sizeof(buf), "Order #%d sent to kitchen", sm_get_order_id());
@@ -1872,37 +3348,47 @@ void ui_show_screen(app_state_t state)
             poll_timer = lv_timer_create(order_poll_cb, ORDER_POLL_INTERVAL_MS, NULL);
             break;
         case STATE_FOOD_READY:
-            lv_scr_load_anim(scr_ready, LV_SCR_LOAD_ANIM_FADE_IN, 500, 0, false);
-            /* Premium Ready Animation: bounce the card */
-            {
-               lv_anim_t a; lv_anim_init(&a);
-               lv_anim_set_var(&a, lv_scr_act());
-               lv_anim_set_values(&a, 0, -15);
-               lv_anim_set_time(&a, 600);
-               lv_anim_set_playback_time(&a, 600);
-               lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
-               lv_anim_start(&a);
-            }
+            lv_scr_load_anim(scr_ready, LV_SCR_LOAD_ANIM_FADE_IN, anim_gov_time(500), 0, false);
+            /* Premium Ready Animation: bounce the card (restarted, not
+             * stacked, on re-entry; the governor pauses it under load) */
+            anim_gov_loop(ready_card, anim_translate_y_cb, 0, -15, 600);
             break;
         case STATE_FOOD_SERVED:
-            if (scr_food_served) { lv_obj_del(scr_food_served); scr_food_served = NULL; }
-            build_food_served();
-            lv_scr_load_anim(scr_food_served, LV_SCR_LOAD_ANIM_MOVE_BOTTOM, 500, 0, false);
+            lv_scr_load_anim(scr_food_served, LV_SCR_LOAD_ANIM_MOVE_BOTTOM, anim_gov_time(500), 0, false);
+#if PREFETCH_ENABLE
+            prefetch_bill();
+#endif
             break;
         case STATE_BILL:
-            lv_scr_load_anim(scr_bill, LV_SCR_LOAD_ANIM_MOVE_LEFT, 450, 0, false);
-            if (lbl_bill_body) lv_label_set_text(lbl_bill_body, "Processing your digital bill...");
-            { lv_timer_t *bt = lv_timer_create(load_bill_cb, 350, NULL);
-              if (bt) lv_timer_set_repeat_count(bt, 1); }
+        {
+            lv_scr_load_anim(scr_bill, LV_SCR_LOAD_ANIM_MOVE_LEFT, anim_gov_time(450), 0, false);
+            bool shown = false;
+#if PREFETCH_ENABLE
+            shown = bill_show_prefetched(prefetch_take_bill());
+#endif
+            if (shown || bill_show_local()) {
+                /* Drawn this frame (prefetch or ledger); the server bill reconciles */
+                if (sm_get_order_id() > 0)
+                    net_post(bill_fetch_job, (void *)(intptr_t)sm_get_order_id());
+#if PREFETCH_ENABLE
+                prefetch_link();
+#endif
+            } else {
+                if (lbl_bill_body) lv_label_set_text(lbl_bill_body, "Processing your digital bill...");
+                lv_timer_t *bt = lv_timer_create(load_bill_cb, 350, NULL);
+                if (bt) lv_timer_set_repeat_count(bt, 1);
+            }
             break;
+        }
         case STATE_PAYMENT_SELECT:
         {
             paysel_entry_ms = lv_tick_get(); /* Mark entry time for touch guard */
-            if (lbl_paysel_amount) {
-                char b[64]; snprintf(b, sizeof(b), "Amount Due: Rs. %d", g_total_bill_rupees);
-                lv_label_set_text(lbl_paysel_amount, b);
-            }
-            lv_scr_load_anim(scr_paysel, LV_SCR_LOAD_ANIM_FADE_IN, 400, 0, false);
+            paysel_seat_chips_rebuild();
+            paysel_amount_update();
+#if PREFETCH_ENABLE
+            prefetch_link();
+#endif
+            lv_scr_load_anim(scr_paysel, LV_SCR_LOAD_ANIM_FADE_IN, anim_gov_time(400), 0, false);
             /* Bounce Animation on Payment Options */
             uint32_t i;
             for(i=0; i<lv_obj_get_child_cnt(scr_paysel); i++) {
@@ -1913,8 +3399,8 @@ void ui_show_screen(app_state_t state)
                     lv_anim_set_var(&a, c);
                     lv_anim_set_exec_cb(&a, anim_zoom_cb);
                     lv_anim_set_values(&a, 0, 256);
-                    lv_anim_set_time(&a, 600);
-                    lv_anim_set_delay(&a, 100 + (i * 100));
+                    lv_anim_set_time(&a, anim_gov_time(600));
+                    lv_anim_set_delay(&a, anim_gov_time(100 + (i * 100)));
                     lv_anim_set_path_cb(&a, lv_anim_path_overshoot);
                     lv_anim_start(&a);
                 }
@@ -1922,16 +3408,23 @@ void ui_show_screen(app_state_t state)
             break;
         }
         case STATE_PAYMENT_UPI:
-            lv_scr_load_anim(scr_upi, LV_SCR_LOAD_ANIM_MOVE_LEFT, 500, 0, false);
+            lv_scr_load_anim(scr_upi, LV_SCR_LOAD_ANIM_MOVE_LEFT, anim_gov_time(500), 0, false);
             if (lbl_payment_result) lv_label_set_text(lbl_payment_result, "");
+            if (lbl_upi_amount) {
+                char b[48]; snprintf(b, sizeof(b), "Amount Due: Rs. %d", pay_amount_rupees());
+                lv_label_set_text(lbl_upi_amount, b);
+            }
             upi_timeout_count = 0;  /* reset 5-min timer */
             
             /* Show spinner while fetching */
             if (upi_spinner) lv_obj_clear_flag(upi_spinner, LV_OBJ_FLAG_HIDDEN);
             if (upi_qr_obj) lv_obj_set_style_transform_zoom(upi_qr_obj, 0, 0);
 
-            /* Deferred HTTP: Set flag to run in loop OUTSIDE main mutex */
-            g_pending_upi_fetch = true;
+            /* Link creation runs on the net task, OUTSIDE the LVGL mutex */
+#if PREFETCH_ENABLE
+            if (!upi_show_prefetched())
+#endif
+                upi_fetch_post(sm_get_order_id());
             
             if (upi_info_card) {
                 lv_obj_set_style_border_color(upi_info_card, COL_AMBER, 0);
@@ -1940,181 +3433,98 @@ void ui_show_screen(app_state_t state)
             upi_poll_timer = lv_timer_create(upi_poll_cb, 3000, NULL);
             break;
         case STATE_PAYMENT_CASH:
-            lv_scr_load_anim(scr_cash, LV_SCR_LOAD_ANIM_MOVE_LEFT, 500, 0, false);
+            lv_scr_load_anim(scr_cash, LV_SCR_LOAD_ANIM_MOVE_LEFT, anim_gov_time(500), 0, false);
+            if (lbl_cash_amount) {
+                char b[16]; snprintf(b, sizeof(b), "Rs. %d", pay_amount_rupees());
+                lv_label_set_text(lbl_cash_amount, b);
+            }
             cash_poll_timer = lv_timer_create(cash_poll_cb, PAYMENT_POLL_MS, NULL);
             break;
         case STATE_FEEDBACK:
             fb_seconds = 20;
             if (lbl_fb_countdown) lv_label_set_text(lbl_fb_countdown, "Thank you! Redirecting in 20s");
             g_stars = 0;
-            lv_scr_load_anim(scr_feedback, LV_SCR_LOAD_ANIM_FADE_IN, 500, 0, false);
+            lv_scr_load_anim(scr_feedback, LV_SCR_LOAD_ANIM_FADE_IN, anim_gov_time(500), 0, false);
             feedback_timer = lv_timer_create(feedback_timer_cb, 1000, NULL);
             break;
         default: break;
     }
 }
 
-/* Deferred action handler — called from loop() OUTSIDE lvgl_acquire.
- * Any LVGL calls here must be wrapped in lvgl_acquire/release. */
-void ui_check_deferred(void)
+#if SM_TRACE_RING && SM_TRACE_UPLOAD_MS
+/* Net task: send what the trace ring gained since the last upload, a
+ * batch per POST. On failure the cursor stays and the next period
+ * retries; anything the ring overwrote meanwhile is reported as lost. */
+static void trace_upload(void)
 {
-    /* ---- Screen transitions (safe, no network) ---- */
-    if (g_goto_menu) {
-        g_goto_menu = false;
-        lvgl_acquire();
-        sm_set(STATE_MENU);
+    static sm_trace_t batch[SM_TRACE_BATCH];
+    static char       json[SM_TRACE_BATCH * 200 + 64];
+    static uint32_t   cursor;
+    for (;;) {
+        uint32_t cur = cursor, lost;
+        lvgl_acquire();          /* the ring is written under this lock */
+        int n = sm_trace_read(&cur, batch, SM_TRACE_BATCH, &lost);
         lvgl_release();
+        if (n == 0) return;
+        if (sm_trace_json(batch, n, lost, json, sizeof(json)) < 0 ||
+            net_post_trace(json) != 0)
+            return;
+        cursor = cur;
+        if (n < SM_TRACE_BATCH) return;
     }
-    if (g_goto_splash) {
-        g_goto_splash = false;
-        lvgl_acquire();
-        sm_set(STATE_SPLASH);
-        lvgl_release();
-    }
-    if (g_pending_cash_select) {
-        /* No network held while calling this — safest */
-        g_pending_cash_select = false;
-        net_select_payment(sm_get_order_id(), "cash");
-        net_buzz(2);
-    }
-    if (g_pending_food_served) {
-        g_pending_food_served = false;
-        net_food_served(sm_get_order_id());
-        net_buzz(2);
-    }
+}
+#endif
 
-    /* ---- Deferred Action: Buzzer Pattern ---- */
-    if (g_pending_buzz) {
-        int pat = g_pending_buzz;
-        g_pending_buzz = 0;
-        net_buzz(pat);
-    }
+static void wifi_status_job(void *arg) { ui_set_wifi_connected(arg != NULL); }
 
+/* Periodic net-task work (WiFi, menu refresh) — called OUTSIDE
+ * lvgl_acquire. One-off requests are net_post() jobs posted by the
+ * screens; results that touch widgets go back through ui_post(), so the
+ * UI task never waits on this one for the LVGL lock. */
+void ui_check_deferred(void)
+{
     /* ---- Deferred Action: WiFi Ticker ---- */
     uint32_t now = lv_tick_get();
     if (now - last_wifi_ms >= 5000) {
         last_wifi_ms = now;
-        bool ok = net_is_wifi_ok();
-        lvgl_acquire();
-        ui_set_wifi_connected(ok);
-        lvgl_release();
+        ui_post(wifi_status_job, net_is_wifi_ok() ? (void *)1 : NULL);
     }
 
-    /* ---- Deferred UPI link creation (blocking HTTP) ---- */
-    if (g_pending_upi_fetch) {
-        g_pending_upi_fetch = false;
-        
-        /* Small delay to let LVGL transition finish safely before network hit */
-        net_delay(200); 
-
-        int oid = sm_get_order_id();
-        net_log("[NET] Fetching UPI link for order #%d\n", oid);
-
-        /* Network calls — NO mutex held */
-        net_select_payment(oid, "upi");
-        char *json = net_create_razorpay_order(oid);
-
-        if (json) {
-            net_log("[NET] Parsing JSON...\n");
-            const char *k = strstr(json, "\"qr_url\"");
-            if (k) {
-                k = strchr(k, ':');
-                if (k) {
-                    k++; while (*k == ' ') k++;
-                    if (*k == '"') k++;
-                    const char *end = strchr(k, '"');
-                    int qlen = end ? (int)(end - k) : 0;
-                    if (qlen > 0 && qlen < (int)sizeof(g_razorpay_url)) {
-                        memcpy(g_razorpay_url, k, qlen);
-                        g_razorpay_url[qlen] = '\0';
-                    }
-                }
-            }
-            free(json);
-        }
-
-        /* Now update LVGL widgets — acquire mutex */
-        lvgl_acquire();
-        if (g_razorpay_url[0] != '\0' && upi_qr_obj) {
-            lv_qrcode_update(upi_qr_obj, g_razorpay_url, strlen(g_razorpay_url));
-            if (upi_spinner) lv_obj_add_flag(upi_spinner, LV_OBJ_FLAG_HIDDEN);
-            lv_anim_t a; lv_anim_init(&a);
-            lv_anim_set_var(&a, upi_qr_obj);
-            lv_anim_set_values(&a, 0, 256);
-            lv_anim_set_time(&a, 400);
-            lv_anim_set_exec_cb(&a, anim_zoom_cb);
-            lv_anim_set_path_cb(&a, lv_anim_path_overshoot);
-            lv_anim_start(&a);
-            net_buzz(2);
-        } else {
-            /* QR failed — show fallback */
-            if (upi_spinner) lv_obj_add_flag(upi_spinner, LV_OBJ_FLAG_HIDDEN);
-            if (upi_qr_label) {
-                lv_obj_clear_flag(upi_qr_label, LV_OBJ_FLAG_HIDDEN);
-                lv_label_set_text(upi_qr_label, "Staff Coming\nfor Payment\n\n(QR Unavailable)");
-            }
-            if (lbl_payment_result) {
-                lv_label_set_text(lbl_payment_result, "Manual payment - staff notified");
-                lv_obj_set_style_text_color(lbl_payment_result, COL_AMBER, 0);
-            }
-            net_buzz(1);
-        }
-        lvgl_release();
+#if SM_TRACE_RING && SM_TRACE_UPLOAD_MS
+    /* ---- Deferred Action: state trace batch upload ---- */
+    static uint32_t last_trace_ms;
+    if (now - last_trace_ms >= SM_TRACE_UPLOAD_MS && net_is_wifi_ok()) {
+        last_trace_ms = now;
+        trace_upload();
     }
+#endif
 
-    /* ---- Deferred UPI payment status poll (blocking HTTP) ---- */
-    if (g_pending_upi_poll) {
-        g_pending_upi_poll = false;
-        int oid = sm_get_order_id();
-
-        /* Network calls — NO mutex held */
-        char status[NET_STATUS_LEN];
-        net_get_payment_status(oid, status, sizeof(status));
-        /* If still pending, also try razorpay-specific endpoint */
-        if (strcmp(status, "pending") == 0) {
-            net_get_razorpay_status(oid, status, sizeof(status));
-        }
-
-        /* Now update UI — acquire mutex */
-        lvgl_acquire();
-        if (strcmp(status, "paid") == 0 || strcmp(status, "verified") == 0) {
-            safe_timer_del(&upi_poll_timer);
-            if (lbl_payment_result) {
-                lv_label_set_text(lbl_payment_result, "PAYMENT SUCCESSFUL " LV_SYMBOL_OK);
-                lv_obj_set_style_text_color(lbl_payment_result, COL_SUCCESS, 0);
-            }
-            lv_timer_t *gt = lv_timer_create(upi_goto_feedback_cb, 2000, NULL);
-            if (gt) lv_timer_set_repeat_count(gt, 1);
-            lvgl_release();
-            net_buzz(3);
-        }
-        else if (strcmp(status, "failed") == 0) {
-            safe_timer_del(&upi_poll_timer);
-            if (lbl_payment_result) {
-                lv_label_set_text(lbl_payment_result, "Staff Coming for Payment");
-                lv_obj_set_style_text_color(lbl_payment_result, COL_ERROR, 0);
-            }
-            lvgl_release();
-            net_buzz(1);
-        }
-        else if (upi_timeout_count >= 100) {
-            safe_timer_del(&upi_poll_timer);
-            if (lbl_payment_result) {
-                lv_label_set_text(lbl_payment_result, "Staff Coming for Payment");
-                lv_obj_set_style_text_color(lbl_payment_result, COL_AMBER, 0);
-            }
-            lvgl_release();
-            net_payment_timeout(oid);
-            net_buzz(1);
-        }
-        else {
-            lvgl_release();
+#if SESSION_RESUME
+    /* ---- Deferred Action: re-check a resumed order with the server ---- */
+    if (s_resume_check_oid > 0 && net_is_wifi_ok() && now - s_resume_check_ms >= 2000) {
+        s_resume_check_ms = now;
+        resume_check();
+    }
+#endif
+
+    /* ---- Deferred Action: Live menu availability / refresh ----
+     * Only while the guest is looking at the menu. The availability map is
+     * tiny; the full menu is re-diffed far less often for price/item edits. */
+    if (sm_get() == STATE_MENU && menu_model_count() > 0 && net_is_wifi_ok()) {
+        if (now - last_menu_ms >= MENU_REFRESH_MS) {
+            last_menu_ms  = now;
+            last_avail_ms = now;
+            ui_menu_post(net_fetch_menu());     /* parsed here, applied by the UI task */
+        } else if (now - last_avail_ms >= MENU_AVAIL_POLL_MS) {
+            last_avail_ms = now;
+            ui_avail_post(net_get_availability());
         }
     }
 }
 
 void ui_set_wifi_connected(bool connected)
 {
+    LVGL_ASSERT_LOCKED();
     g_wifi_ok = connected;
     if (!lbl_wifi_status) return;
     lv_label_set_text(lbl_wifi_status, connected ? "Connected" : "Offline");
@@ -2134,103 +3544,95 @@ void ui_set_wifi_connected(bool connected)
 
 void ui_menu_load(const char *menu_json)
 {
-    if (!menu_json || !menu_grid) return;
-    lv_obj_clean(menu_grid);
-    char last_cat[64] = "";
-    
-    const char *p = menu_json;
-    int parsed_count = 0;
-    while ((p = strchr(p, '{')) != NULL) {
-        const char *obj_end = find_obj_end(p);
-        if (!obj_end) break;
-        int id=0, price=0, is_veg=1, available=1;
-        char name[64]="", desc[128]="", cat[64]="Main Course";
-        const char *f;
-        
-        /* 1. Extract ID */
-        f = strstr(p, "\"id\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) { f++; while(*f == ' ') f++; id = atoi(f); }
-        }
+    if (menu_json) ui_menu_load_parsed(menu_parsed_new(menu_json));
+}
 
-        /* 2. Extract Name */
-        f = strstr(p, "\"name\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) {
-                f++; while(*f == ' ' || *f == '"') f++;
-                const char *q = strchr(f, '"');
-                if (q && q < obj_end) {
-                    int l = (int)(q - f); if(l >= 64) l = 63;
-                    memcpy(name, f, l); name[l] = 0;
-                }
-            }
-        }
+void ui_menu_load_parsed(menu_parsed_t *m)
+{
+    LVGL_ASSERT_LOCKED();
+    if (!m) return;
+    if (!menu_grid) {
+        /* Menu screen not built yet — keep the data, build_menu lays it out */
+        if (menu_model_count() == 0) menu_model_adopt(m);
+        else { menu_model_apply_parsed(m); menu_parsed_free(m); }
+#if SESSION_RESUME
+        resume_cart_apply();
+#endif
+        return;
+    }
+    if (menu_model_count() == 0) {
+        int n = menu_model_adopt(m);
+#if SESSION_RESUME
+        resume_cart_apply();
+#endif
+        menu_virt_layout();
+        lv_obj_scroll_to_y(menu_grid, 0, LV_ANIM_OFF);
+        menu_virt_update();
+        net_log("[UI] Menu loaded: %d items, %d rows, %d pooled cards\n",
+                n, s_row_count, MENU_POOL_CARDS);
+        return;
+    }
 
-        /* 3. Extract Description */
-        f = strstr(p, "\"description\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) {
-                f++; while(*f == ' ' || *f == '"') f++;
-                const char *q = strchr(f, '"');
-                if (q && q < obj_end) {
-                    int l = (int)(q - f); if(l >= 128) l = 127;
-                    memcpy(desc, f, l); desc[l] = 0;
-                }
-            }
-        }
+    /* Refresh: diff by id, keep the scroll position, touch changed cards only */
+    unsigned diff = menu_model_apply_parsed(m);
+    menu_parsed_free(m);
+    if (diff & MENU_DIFF_LAYOUT) {
+        menu_virt_layout();
+        menu_virt_update();
+    } else if (diff & MENU_DIFF_ITEMS) {
+        menu_virt_refresh();
+    }
+    if (diff != MENU_DIFF_NONE)
+        net_log("[UI] Menu diff: %s%s(%d items)\n",
+                (diff & MENU_DIFF_LAYOUT) ? "layout " : "",
+                (diff & MENU_DIFF_ITEMS)  ? "items "  : "", menu_model_count());
+}
 
-        /* 4. Extract Category */
-        f = strstr(p, "\"category\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) {
-                f++; while(*f == ' ' || *f == '"') f++;
-                const char *q = strchr(f, '"');
-                if (q && q < obj_end) {
-                    int l = (int)(q - f); if(l >= 64) l = 63;
-                    memcpy(cat, f, l); cat[l] = 0;
-                }
-            }
-        }
+static void ui_menu_apply_avail(const menu_avail_t *a)
+{
+    LVGL_ASSERT_LOCKED();
+    int changed = menu_model_apply_avail(a);
+    if (changed == 0) return;
+    menu_virt_refresh();
+    net_log("[UI] Availability: %d item(s) changed\n", changed);
+}
 
-        /* 5. Extract Price */
-        f = strstr(p, "\"price\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) { f++; while(*f == ' ') f++; price = atoi(f); }
-        }
+void ui_menu_apply_availability(const char *avail_json)
+{
+    menu_avail_t *a = menu_avail_new(avail_json);
+    ui_menu_apply_avail(a);
+    free(a);
+}
 
-        /* 6. Extract Boolean fields */
-        f = strstr(p, "\"is_veg\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) { f++; while(*f == ' ') f++; is_veg = (*f == 't' || *f == '1'); }
-        }
-        f = strstr(p, "\"available\"");
-        if (f && f < obj_end) {
-            f = strchr(f, ':');
-            if (f) { f++; while(*f == ' ') f++; available = (*f == 't' || *f == '1'); }
-        }
+static void menu_parsed_job(void *arg) { ui_menu_load_parsed((menu_parsed_t *)arg); }
 
-        if (id > 0 && name[0]) {
-            if (strcmp(cat, last_cat) != 0) {
-                make_category_header(cat);
-                strncpy(last_cat, cat, sizeof(last_cat)-1);
-            }
-            add_menu_card(id, name, desc, cat, price*100, is_veg!=0, available!=0);
-        parsed_count++;
-        }
-        p = obj_end + 1;
-    }
+static void avail_job(void *arg)
+{
+    ui_menu_apply_avail((const menu_avail_t *)arg);
+    free(arg);
+}
+
+void ui_menu_post(char *menu_json)
+{
+    menu_parsed_t *m = menu_parsed_new(menu_json);
+    free(menu_json);
+    if (m && !ui_post(menu_parsed_job, m)) menu_parsed_free(m);
 }
 
-void ui_menu_item_set_available(int item_id, bool available) { (void)item_id; (void)available; }
+void ui_avail_post(char *avail_json)
+{
+    menu_avail_t *a = menu_avail_new(avail_json);
+    free(avail_json);
+    if (a && !ui_post(avail_job, a)) free(a);
+}
+
+void ui_menu_item_set_available(int item_id, bool available)
+{
+    if (menu_model_set_available(item_id, available)) menu_virt_refresh();
+}
 void ui_cart_refresh(void) { refresh_cart_panel(); }
 void ui_order_set_wait_time(int minutes) { (void)minutes; }
-void ui_food_ready_show(void) { sm_set(STATE_FOOD_READY); }
+void ui_food_ready_show(void) { sm_post(EV_FOOD_READY); }
 void ui_bill_load(const char *bill_json) { (void)bill_json; }
 
 void ui_payment_set_amount(int paise)
@@ -2273,5 +3675,16 @@ void ui_feedback_set_countdown(int seconds)
 void ui_add_menu_card(int id, const char *name, const char *desc,
                       int price_rupees, bool is_veg, bool available)
 {
-    add_menu_card(id, name, desc, "General", price_rupees * 100, is_veg, available);
+    menu_item_t it;
+    memset(&it, 0, sizeof(it));
+    it.id          = id;
+    it.price_paise = price_rupees * 100;
+    it.is_veg      = is_veg;
+    it.available   = available;
+    strncpy(it.name, name ? name : "", sizeof(it.name) - 1);
+    strncpy(it.desc, desc ? desc : "", sizeof(it.desc) - 1);
+    strcpy(it.cat, "General");
+    if (!menu_model_append(&it)) return;
+    menu_virt_layout();
+    menu_virt_update();
 }
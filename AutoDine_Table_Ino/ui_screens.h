@@ -4,28 +4,49 @@
  * ===================================================================== */
 #include "lvgl.h"
 #include "state_machine.h"
+#include "menu_model.h"
 
 /* Initialise UI subsystem — call once after LVGL is ready */
 void ui_init(void);
 
+/* Boot: reopen the screen of the session saved before a reset
+ * (session_store.h). False = nothing to resume, show the splash. */
+bool ui_resume_session(void);
+
 /* Show a specific screen (called by state machine) */
 void ui_show_screen(app_state_t state);
 
-/* Check deferred actions (call from main loop, inside lvgl_acquire) */
+/* Duration and LVGL heap cost of a screen's most recent build
+ * (both 0 if it has never been built) */
+void ui_screen_build_stats(app_state_t st, uint32_t *build_us, uint32_t *bytes);
+
+/* Check deferred actions (call from the net task, NOT inside lvgl_acquire;
+ * it blocks on HTTP and takes the lock itself around widget updates) */
 void ui_check_deferred(void);
 
 /* ---- Per-screen update functions (safe to call from network task) -- */
-/* Must only be called inside lvgl_acquire() / lvgl_release() block     */
+/* Must only be called inside lvgl_acquire() / lvgl_release() block,    */
+/* or from a ui_post() job (checked when LVGL_LOCK_DEBUG is set)        */
 
 /* Update WiFi indicator icon on current screen */
 void ui_set_wifi_connected(bool connected);
 
-/* Rebuild menu grid from JSON string (server response) */
+/* Load menu from JSON (server response). First call builds the layout;
+ * later calls diff against the current model by item id. */
 void ui_menu_load(const char *menu_json);
+void ui_menu_load_parsed(menu_parsed_t *m);   /* takes m over */
+
+/* Net task: parse json (then freed) there and hand the menu to the UI
+ * task, which only diffs and rebinds. Same for the availability map. */
+void ui_menu_post(char *menu_json);
+void ui_avail_post(char *avail_json);
 
 /* Mark a menu item as unavailable */
 void ui_menu_item_set_available(int item_id, bool available);
 
+/* Apply GET /api/menu/availability JSON; only changed cards are redrawn */
+void ui_menu_apply_availability(const char *avail_json);
+
 /* Update cart panel quantities after add/remove */
 void ui_cart_refresh(void);
 
@@ -0,0 +1,310 @@
+/* =====================================================================
+ *  ui_theme.c — AutoDine V4.0 shared LVGL styles
+ * ===================================================================== */
+#include "ui_theme.h"
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#ifdef ARDUINO
+#include "esp_heap_caps.h"
+#endif
+
+#define TEXT_STYLE_SLOTS  40   /* distinct (color, font) pairs in the UI  */
+#define CAT_COUNT         5
+#define SKIN_SLOTS        4    /* distinct card sizes worth caching       */
+
+typedef struct {
+    lv_style_t        style;
+    lv_color_t        col;
+    const lv_font_t  *font;
+    bool              has_col;
+    bool              used;
+} text_style_t;
+
+static lv_style_t   s_styles[UI_STYLE_COUNT];
+static text_style_t s_text[TEXT_STYLE_SLOTS];
+static lv_style_t   s_cat_bar[CAT_COUNT];
+static bool         s_ready = false;
+
+typedef struct {
+    lv_coord_t    w, h;
+    lv_img_dsc_t  img;
+} card_skin_t;
+static card_skin_t  s_skins[SKIN_SLOTS];
+static int          s_skin_count = 0;
+
+/* Category order: starter, main, drink, dessert, other */
+static int cat_index(const char *cat)
+{
+    if (!cat) return 1;
+    char lower[64];
+    strncpy(lower, cat, 63); lower[63] = 0;
+    for (char *p = lower; *p; p++) *p = tolower((unsigned char)*p);
+
+    if (strstr(lower, "starter") || strstr(lower, "appetizer")) return 0;
+    if (strstr(lower, "main") || strstr(lower, "course")) return 1;
+    if (strstr(lower, "drink") || strstr(lower, "beverage")) return 2;
+    if (strstr(lower, "dessert") || strstr(lower, "sweet")) return 3;
+    return 4;
+}
+
+static lv_color_t cat_color_at(int i)
+{
+    switch (i) {
+    case 0:  return COL_SUCCESS;
+    case 1:  return COL_AMBER;
+    case 2:  return lv_color_hex(0x3B82F6); /* blue */
+    case 3:  return lv_color_hex(0xEC4899); /* pink */
+    default: return lv_color_hex(0x94A3B8); /* grey for others */
+    }
+}
+
+void ui_theme_init(void)
+{
+    if (s_ready) return;
+    lv_style_t *s;
+
+    s = &s_styles[UI_STYLE_SCREEN];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_BG);
+    lv_style_set_bg_grad_color(s, COL_BG2);
+    lv_style_set_bg_grad_dir(s, LV_GRAD_DIR_VER);
+    lv_style_set_bg_opa(s, LV_OPA_COVER);
+
+    s = &s_styles[UI_STYLE_CARD];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_CARD);
+    lv_style_set_bg_opa(s, 235);
+    lv_style_set_border_width(s, 1);
+    lv_style_set_border_color(s, COL_DIVIDER);
+    lv_style_set_radius(s, 24);
+    lv_style_set_pad_all(s, 16);
+    lv_style_set_shadow_width(s, 30);
+    lv_style_set_shadow_color(s, lv_color_hex(0x000000));
+    lv_style_set_shadow_opa(s, 100);
+
+    s = &s_styles[UI_STYLE_CARD_COMPACT];
+    lv_style_init(s);
+    lv_style_set_pad_all(s, 8);
+    lv_style_set_pad_left(s, 12);
+
+    s = &s_styles[UI_STYLE_ACCENT];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_AMBER);
+    lv_style_set_bg_opa(s, LV_OPA_COVER);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_radius(s, 2);
+
+    s = &s_styles[UI_STYLE_BTN_AMBER];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_AMBER);
+    lv_style_set_bg_grad_color(s, COL_AMBER2);
+    lv_style_set_bg_grad_dir(s, LV_GRAD_DIR_HOR);
+    lv_style_set_radius(s, 12);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_shadow_width(s, 10);
+    lv_style_set_shadow_color(s, COL_AMBER);
+    lv_style_set_shadow_opa(s, 60);
+
+    s = &s_styles[UI_STYLE_BTN_AMBER_PR];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_AMBER2);
+
+    s = &s_styles[UI_STYLE_BTN_QTY];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_AMBER);
+    lv_style_set_radius(s, 6);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+
+    s = &s_styles[UI_STYLE_CLEAR];
+    lv_style_init(s);
+    lv_style_set_bg_opa(s, LV_OPA_TRANSP);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_pad_all(s, 0);
+
+    s = &s_styles[UI_STYLE_BAR];
+    lv_style_init(s);
+    lv_style_set_bg_opa(s, LV_OPA_COVER);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_radius(s, 0);
+
+    s = &s_styles[UI_STYLE_DIVIDER];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_DIVIDER);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+
+    s = &s_styles[UI_STYLE_DOT];
+    lv_style_init(s);
+    lv_style_set_radius(s, LV_RADIUS_CIRCLE);
+    lv_style_set_border_color(s, COL_WHITE);
+    lv_style_set_border_width(s, 1);
+    lv_style_set_border_opa(s, LV_OPA_COVER);
+
+    s = &s_styles[UI_STYLE_DOT_VEG];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_SUCCESS);
+
+    s = &s_styles[UI_STYLE_DOT_NONVEG];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_ERROR);
+
+    s = &s_styles[UI_STYLE_OVERLAY];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_BTN_TEXT);
+    lv_style_set_bg_opa(s, 190);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_radius(s, 16);
+
+    s = &s_styles[UI_STYLE_TOAST];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_ERROR);
+    lv_style_set_bg_opa(s, LV_OPA_COVER);
+    lv_style_set_radius(s, 12);
+    lv_style_set_border_color(s, lv_color_hex(0xFFFFFF));
+    lv_style_set_border_width(s, 1);
+    lv_style_set_shadow_width(s, 20);
+    lv_style_set_shadow_opa(s, 80);
+
+    s = &s_styles[UI_STYLE_CART_ROW];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_CARD);
+    lv_style_set_bg_opa(s, LV_OPA_COVER);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_radius(s, 6);
+    lv_style_set_pad_all(s, 4);
+
+    s = &s_styles[UI_STYLE_CART_ROW_ALT];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_CARD2);
+
+    s = &s_styles[UI_STYLE_CHIP];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_CARD);
+    lv_style_set_bg_opa(s, LV_OPA_COVER);
+    lv_style_set_border_color(s, COL_AMBER);
+    lv_style_set_border_width(s, 1);
+    lv_style_set_border_opa(s, LV_OPA_COVER);
+    lv_style_set_radius(s, LV_RADIUS_CIRCLE);
+    lv_style_set_shadow_width(s, 0);
+    lv_style_set_pad_hor(s, 14);
+
+    s = &s_styles[UI_STYLE_CHIP_SEL];
+    lv_style_init(s);
+    lv_style_set_bg_color(s, COL_AMBER);
+
+    s = &s_styles[UI_STYLE_CHIP_PAID];
+    lv_style_init(s);
+    lv_style_set_border_color(s, COL_SUCCESS);
+
+    s = &s_styles[UI_STYLE_CHIP_ROW];
+    lv_style_init(s);
+    lv_style_set_bg_opa(s, LV_OPA_TRANSP);
+    lv_style_set_border_opa(s, LV_OPA_TRANSP);
+    lv_style_set_pad_all(s, 4);
+    lv_style_set_pad_column(s, 8);
+
+    for (int i = 0; i < CAT_COUNT; i++) {
+        lv_style_init(&s_cat_bar[i]);
+        lv_style_set_bg_color(&s_cat_bar[i], cat_color_at(i));
+    }
+    s_ready = true;
+}
+
+lv_style_t *ui_theme_style(ui_style_id_t id)
+{
+    return &s_styles[id];
+}
+
+static lv_style_t *text_lookup(lv_color_t col, bool has_col, const lv_font_t *font)
+{
+    for (int i = 0; i < TEXT_STYLE_SLOTS; i++) {
+        text_style_t *t = &s_text[i];
+        if (!t->used) {
+            lv_style_init(&t->style);
+            if (has_col) lv_style_set_text_color(&t->style, col);
+            if (font)    lv_style_set_text_font(&t->style, font);
+            t->col = col; t->has_col = has_col; t->font = font; t->used = true;
+            return &t->style;
+        }
+        if (t->font == font && t->has_col == has_col &&
+            (!has_col || t->col.full == col.full))
+            return &t->style;
+    }
+    return NULL;
+}
+
+lv_style_t *ui_theme_text(lv_color_t col, const lv_font_t *font)
+{
+    return text_lookup(col, true, font);
+}
+
+lv_style_t *ui_theme_font(const lv_font_t *font)
+{
+    return text_lookup(lv_color_hex(0), false, font);
+}
+
+lv_color_t ui_theme_cat_color(const char *cat)
+{
+    return cat_color_at(cat_index(cat));
+}
+
+lv_style_t *ui_theme_cat_bar(const char *cat)
+{
+    return &s_cat_bar[cat_index(cat)];
+}
+
+/* Skins are large (RGB565 + alpha); keep them out of internal RAM */
+static void *skin_alloc(size_t sz)
+{
+#ifdef ARDUINO
+    void *p = heap_caps_malloc(sz, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p) return p;
+#endif
+    return malloc(sz);
+}
+
+const lv_img_dsc_t *ui_theme_card_skin(lv_coord_t w, lv_coord_t h)
+{
+    for (int i = 0; i < s_skin_count; i++)
+        if (s_skins[i].w == w && s_skins[i].h == h) return &s_skins[i].img;
+    if (s_skin_count >= SKIN_SLOTS) return NULL;
+
+    lv_coord_t sw = w + 2 * UI_SKIN_MARGIN;
+    lv_coord_t sh = h + 2 * UI_SKIN_MARGIN;
+    void *buf = skin_alloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR_ALPHA(sw, sh));
+    if (!buf) return NULL;
+
+    /* Render through a throw-away canvas on a detached screen */
+    lv_obj_t *tmp    = lv_obj_create(NULL);
+    lv_obj_t *canvas = lv_canvas_create(tmp);
+    lv_canvas_set_buffer(canvas, buf, sw, sh, LV_IMG_CF_TRUE_COLOR_ALPHA);
+    lv_canvas_fill_bg(canvas, lv_color_black(), LV_OPA_TRANSP);
+
+    lv_draw_rect_dsc_t d;
+    lv_draw_rect_dsc_init(&d);
+    d.radius       = 24;
+    d.bg_color     = COL_CARD;
+    d.bg_opa       = 235;
+    d.border_width = 1;
+    d.border_color = COL_DIVIDER;
+    d.border_opa   = LV_OPA_COVER;
+    d.shadow_width = 30;
+    d.shadow_color = lv_color_hex(0x000000);
+    d.shadow_opa   = 100;
+    lv_canvas_draw_rect(canvas, UI_SKIN_MARGIN, UI_SKIN_MARGIN, w, h, &d);
+
+    card_skin_t *sk = &s_skins[s_skin_count++];
+    sk->w   = w;
+    sk->h   = h;
+    sk->img = *lv_canvas_get_img(canvas);   /* header + data -> buf */
+    lv_obj_del(tmp);
+    return &sk->img;
+}
+
+void ui_theme_swap(lv_obj_t *obj, lv_style_t **cur, lv_style_t *next)
+{
+    if (*cur == next) return;
+    if (*cur) lv_obj_remove_style(obj, *cur, 0);
+    if (next) lv_obj_add_style(obj, next, 0);
+    *cur = next;
+}
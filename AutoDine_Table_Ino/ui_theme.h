@@ -0,0 +1,80 @@
+#pragma once
+/* =====================================================================
+ *  ui_theme.h — AutoDine V4.0 shared LVGL styles
+ *
+ *  Styles are built once by ui_theme_init() and attached by reference
+ *  with lv_obj_add_style(), so a widget carries a pointer to a shared
+ *  lv_style_t instead of its own list of local style properties.
+ * ===================================================================== */
+#include "lvgl.h"
+
+/* ---- THEME / COLORS (WOW Aesthetics) ----------------------- */
+#define COL_BG       lv_color_hex(0x020617) /* Deep Navy           */
+#define COL_BG2      lv_color_hex(0x0F172A) /* Slate Gradient      */
+#define COL_CARD     lv_color_hex(0x0F172A) /* Slate Navy          */
+#define COL_CARD2    lv_color_hex(0x1E293B) /* Lighter Slate       */
+#define COL_AMBER    lv_color_hex(0xF59E0B) /* Premium Gold        */
+#define COL_AMBER2   lv_color_hex(0xD97706) /* Dimmed Gold         */
+#define COL_EMERALD  lv_color_hex(0x10B981) /* Success Emerald     */
+#define COL_SUCCESS  lv_color_hex(0x10B981) /* (Alias)             */
+#define COL_WHITE    lv_color_hex(0xF8FAFC) /* Off White           */
+#define COL_GREY     lv_color_hex(0x64748B) /* Slate Grey          */
+#define COL_ERROR    lv_color_hex(0xEF4444) /* Error Red           */
+#define COL_INFO     lv_color_hex(0x3B82F6) /* Info Blue           */
+#define COL_DARK     lv_color_hex(0x020617) /* Pure Dark           */
+#define COL_BTN_TEXT lv_color_hex(0x0A0A0A) /* Text on amber       */
+#define COL_DIVIDER  lv_color_hex(0x334155) /* Card border / rules */
+
+typedef enum {
+    UI_STYLE_SCREEN = 0,      /* navy vertical gradient, full opacity     */
+    UI_STYLE_CARD,            /* slate card, border, radius 24, shadow    */
+    UI_STYLE_CARD_COMPACT,    /* padding override for menu cards          */
+    UI_STYLE_ACCENT,          /* amber 3px stripe on top of cards         */
+    UI_STYLE_BTN_AMBER,       /* amber gradient button                    */
+    UI_STYLE_BTN_AMBER_PR,    /* pressed state (LV_STATE_PRESSED)         */
+    UI_STYLE_BTN_QTY,         /* small amber +/- buttons                  */
+    UI_STYLE_CLEAR,           /* transparent bg + border, no padding      */
+    UI_STYLE_BAR,             /* solid strip: opaque bg, no border/radius */
+    UI_STYLE_DIVIDER,         /* 1px slate rule                           */
+    UI_STYLE_DOT,             /* veg/non-veg dot outline                  */
+    UI_STYLE_DOT_VEG,
+    UI_STYLE_DOT_NONVEG,
+    UI_STYLE_OVERLAY,         /* "Currently Unavailable" dim layer        */
+    UI_STYLE_TOAST,           /* red error toast                          */
+    UI_STYLE_CART_ROW,        /* cart panel line (even rows)              */
+    UI_STYLE_CART_ROW_ALT,    /* bg override for odd rows                 */
+    UI_STYLE_CHIP,            /* seat chip: pill, amber outline            */
+    UI_STYLE_CHIP_SEL,        /* bg override for the selected chip        */
+    UI_STYLE_CHIP_PAID,       /* border override for a seat that has paid */
+    UI_STYLE_CHIP_ROW,        /* transparent flex row holding chips       */
+    UI_STYLE_COUNT
+} ui_style_id_t;
+
+/* Build every shared style. Call once after lv_init(), before any screen. */
+void ui_theme_init(void);
+
+lv_style_t *ui_theme_style(ui_style_id_t id);
+
+/* Text style for a (color, font) pair; font may be NULL. Styles are
+ * cached, so every label with the same look shares one lv_style_t.
+ * Returns NULL only if the cache is full (caller falls back to locals). */
+lv_style_t *ui_theme_text(lv_color_t col, const lv_font_t *font);
+
+/* Font-only text style (keeps the theme's default text colour) */
+lv_style_t *ui_theme_font(const lv_font_t *font);
+
+/* Category accent colour and the matching bar style (bg colour only) */
+lv_color_t  ui_theme_cat_color(const char *cat);
+lv_style_t *ui_theme_cat_bar(const char *cat);
+
+/* ---- Pre-rendered card skins ----
+ * A UI_STYLE_CARD look (bg, border, radius, shadow) rendered once per
+ * size into an ARGB image. The image is UI_SKIN_MARGIN larger on every
+ * side to hold the shadow; place it at (x - margin, y - margin). Blitting
+ * it replaces the per-frame shadow blur while scrolling. NULL if out of
+ * memory or the cache is full — fall back to UI_STYLE_CARD. */
+#define UI_SKIN_MARGIN   16
+const lv_img_dsc_t *ui_theme_card_skin(lv_coord_t w, lv_coord_t h);
+
+/* Replace one shared style with another on obj (no-op if unchanged) */
+void ui_theme_swap(lv_obj_t *obj, lv_style_t **cur, lv_style_t *next);
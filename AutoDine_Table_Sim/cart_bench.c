@@ -0,0 +1,180 @@
+/* =====================================================================
+ *  cart_bench.c — AutoDine host micro-benchmark for cart.c
+ *
+ *  Replays a random tap mix (mostly +/-, some new items, a few clears)
+ *  against cart.c and a naive reference model, checks every total after
+ *  every operation, checks that 1000-op rounds leave pool and heap
+ *  usage unchanged, then times each public call in ns/op.
+ *
+ *    cmake -S AutoDine_Table_Sim -B build-sim && cmake --build build-sim --target cart_bench
+ *    ./build-sim/cart_bench [iterations]
+ * ===================================================================== */
+#include "cart.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define MENU_IDS  (CART_HARD_CAP + 32)   /* more ids than fit: cart hits the cap */
+#define FULL      32                      /* "full" cart for the timing loops   */
+
+/* Reference model: per-id quantities, totals recomputed from scratch */
+static int s_ref_qty[MENU_IDS];
+static unsigned s_ref_since[MENU_IDS], s_ref_adds;   /* order of first add */
+
+static int   item_id(int k)    { return 1000 + k * 37; }   /* sparse, like Firestore ids */
+static int   item_price(int k) { return (49 + k * 13) * 100; }
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int check(int step)
+{
+    int sub = 0, qty = 0, uniq = 0;
+    for (int k = 0; k < MENU_IDS; k++) {
+        if (cart_get_qty(item_id(k)) != s_ref_qty[k]) {
+            fprintf(stderr, "step %d: qty mismatch for id %d\n", step, item_id(k));
+            return 0;
+        }
+        sub  += s_ref_qty[k] * item_price(k);
+        qty  += s_ref_qty[k];
+        uniq += s_ref_qty[k] > 0;
+    }
+    int gst = sub * 5 / 100;
+    if (cart_subtotal_paise() != sub || cart_gst_paise() != gst ||
+        cart_grand_total_paise() != sub + gst || cart_total_items() != qty ||
+        cart_item_count() != uniq) {
+        fprintf(stderr, "step %d: totals mismatch\n", step);
+        return 0;
+    }
+    int walked = 0;
+    unsigned last = 0;
+    for (const cart_item_t *it = cart_first(); it; it = cart_next(it), walked++) {
+        if (it->qty <= 0) { fprintf(stderr, "step %d: empty slot %d\n", step, walked); return 0; }
+        unsigned since = s_ref_since[(it->id - 1000) / 37];
+        if (since <= last) { fprintf(stderr, "step %d: out of order at %d\n", step, walked); return 0; }
+        last = since;
+    }
+    if (walked != cart_item_count()) { fprintf(stderr, "step %d: walk length wrong\n", step); return 0; }
+    return 1;
+}
+
+static int verify(int steps)
+{
+    srand(1);
+    cart_clear();
+    memset(s_ref_qty, 0, sizeof(s_ref_qty));
+    for (int n = 0; n < steps; n++) {
+        int r = rand() % 100, k = rand() % MENU_IDS;
+        if (r < 1) {
+            cart_clear();
+            memset(s_ref_qty, 0, sizeof(s_ref_qty));
+        } else if (r < 60) {
+            bool fits = s_ref_qty[k] > 0 || cart_item_count() < CART_HARD_CAP;
+            if (cart_add(item_id(k), "item", item_price(k), k & 1) != fits) {
+                fprintf(stderr, "step %d: cart_add result wrong\n", n);
+                return 0;
+            }
+            if (fits && s_ref_qty[k]++ == 0) s_ref_since[k] = ++s_ref_adds;
+        } else {
+            cart_remove_one(item_id(k));
+            if (s_ref_qty[k] > 0) s_ref_qty[k]--;
+        }
+        if (!check(n)) return 0;
+    }
+    return 1;
+}
+
+static size_t heap_in_use(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+/* 1000 random adds/removes per round over more ids than the cap; pool
+ * and heap usage must stop moving once the first round has grown it */
+static int stress(void)
+{
+    srand(7);
+    cart_clear();
+    size_t pool0 = 0, heap0 = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int n = 0; n < 1000; n++) {
+            int k = rand() % MENU_IDS;
+            if (rand() % 100 < 55) cart_add(item_id(k), "item", item_price(k), false);
+            else                   cart_remove_one(item_id(k));
+        }
+        if (round == 0) {
+            cart_clear();
+            for (int k = 0; k < MENU_IDS; k++) cart_add(item_id(k), "item", item_price(k), false);
+            cart_clear();                      /* pool now at its high-water mark */
+            pool0 = cart_pool_bytes();
+            heap0 = heap_in_use();
+        } else if (cart_pool_bytes() != pool0 || heap_in_use() != heap0) {
+            fprintf(stderr, "stress round %d: pool %zu -> %zu B, heap %zu -> %zu B\n",
+                    round, pool0, cart_pool_bytes(), heap0, heap_in_use());
+            return 0;
+        }
+    }
+    printf("cart_bench: 9 x 1000 add/remove ops, pool %zu B and heap %zu B constant\n",
+           pool0, heap0);
+    return 1;
+}
+
+static void fill(int uniq)
+{
+    cart_clear();
+    for (int k = 0; k < uniq; k++) cart_add(item_id(k), "item", item_price(k), false);
+}
+
+int main(int argc, char **argv)
+{
+    long iters = argc > 1 ? atol(argv[1]) : 2000000;
+
+    if (!verify(200000)) return 1;
+    printf("cart_bench: 200000 random ops match the reference model\n");
+    if (!stress()) return 1;
+
+    volatile int sink = 0;
+    double t0;
+
+    fill(FULL);
+    t0 = now_ns();
+    for (long n = 0; n < iters; n++) {
+        int k = (int)(n % FULL);
+        cart_add(item_id(k), "item", item_price(k), false);   /* existing: qty++ */
+        cart_remove_one(item_id(k));                          /* qty-- (stays > 0) */
+    }
+    printf("  +1/-1 on a full cart      %6.1f ns/pair\n", (now_ns() - t0) / iters);
+
+    t0 = now_ns();
+    for (long n = 0; n < iters; n++) sink += cart_get_qty(item_id((int)(n % MENU_IDS)));
+    printf("  cart_get_qty              %6.1f ns/op\n", (now_ns() - t0) / iters);
+
+    t0 = now_ns();
+    for (long n = 0; n < iters; n++)
+        sink += cart_grand_total_paise() + cart_total_items() + cart_gst_paise();
+    printf("  totals (panel refresh)    %6.1f ns/op\n", (now_ns() - t0) / iters);
+
+    long rounds = iters / FULL;
+    t0 = now_ns();
+    for (long n = 0; n < rounds; n++) {
+        fill(FULL);
+        for (int k = 0; k < FULL; k++) cart_remove_one(item_id(k));
+    }
+    printf("  fill + drain %2d items     %6.1f ns/item\n", FULL,
+           (now_ns() - t0) / ((double)rounds * FULL));
+
+    (void)sink;
+    return 0;
+}
@@ -0,0 +1,51 @@
+/* =====================================================================
+ *  lv_conf.h — LVGL v8.3 configuration for the AutoDine host simulator
+ *
+ *  Only the settings the table UI depends on; everything else keeps the
+ *  lv_conf_internal.h default. Mirrors the panel build: RGB565, built-in
+ *  LVGL heap (so lv_mem_monitor() reports real use), QR code widget and
+ *  every Montserrat size ui_screens.c references.
+ * ===================================================================== */
+#if 1 /* Set this to "1" to enable content */
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#include <stdint.h>
+
+#define LV_COLOR_DEPTH          16
+#define LV_COLOR_16_SWAP        0
+
+#define LV_MEM_CUSTOM           0
+#define LV_MEM_SIZE             (128U * 1024U)
+
+/* The simulator advances the tick itself (lv_tick_inc) on a virtual clock */
+#define LV_TICK_CUSTOM          0
+#define LV_DISP_DEF_REFR_PERIOD 30
+#define LV_INDEV_DEF_READ_PERIOD 30
+
+#define LV_USE_LOG              0
+#define LV_USE_ASSERT_NULL      1
+#define LV_USE_ASSERT_MALLOC    1
+#define LV_USE_PERF_MONITOR     0
+#define LV_USE_MEM_MONITOR      0
+#define LV_USE_USER_DATA        1
+
+#define LV_FONT_MONTSERRAT_10   1
+#define LV_FONT_MONTSERRAT_12   1
+#define LV_FONT_MONTSERRAT_14   1
+#define LV_FONT_MONTSERRAT_16   1
+#define LV_FONT_MONTSERRAT_18   1
+#define LV_FONT_MONTSERRAT_20   1
+#define LV_FONT_MONTSERRAT_22   1
+#define LV_FONT_MONTSERRAT_28   1
+#define LV_FONT_MONTSERRAT_32   1
+#define LV_FONT_MONTSERRAT_40   1
+#define LV_FONT_MONTSERRAT_48   1
+#define LV_FONT_DEFAULT         &lv_font_montserrat_14
+
+#define LV_USE_CANVAS           1
+#define LV_USE_QRCODE           1
+
+#endif /* LV_CONF_H */
+#endif /* Enable content */
@@ -0,0 +1,57 @@
+/* =====================================================================
+ *  sim_hal.c — AutoDine host simulator: task/lock shims
+ * ===================================================================== */
+#include "sim_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIM_QUEUE_LEN  TASK_QUEUE_LEN
+
+typedef struct { task_job_fn fn; void *arg; } sim_job_t;
+typedef struct {
+    sim_job_t jobs[SIM_QUEUE_LEN];
+    int       head, count;
+} sim_queue_t;
+
+static sim_queue_t s_ui, s_net;
+static int         s_lock_depth = 0;
+
+void lvgl_acquire(void) { s_lock_depth++; }
+void lvgl_release(void) { if (s_lock_depth > 0) s_lock_depth--; }
+
+#if LVGL_LOCK_DEBUG
+/* Single thread: the sim loop itself counts as holding the lock */
+bool lvgl_lock_held(void) { return true; }
+void lvgl_lock_violation(const char *where)
+{
+    fprintf(stderr, "[LVGL] %s called without lvgl_acquire()\n", where);
+    abort();
+}
+#endif
+
+static bool queue_push(sim_queue_t *q, task_job_fn fn, void *arg)
+{
+    if (!fn || q->count >= SIM_QUEUE_LEN) return false;
+    q->jobs[(q->head + q->count) % SIM_QUEUE_LEN] = (sim_job_t){ fn, arg };
+    q->count++;
+    return true;
+}
+
+static int queue_drain(sim_queue_t *q)
+{
+    int n = 0;
+    while (q->count > 0) {
+        sim_job_t j = q->jobs[q->head];
+        q->head = (q->head + 1) % SIM_QUEUE_LEN;
+        q->count--;
+        j.fn(j.arg);           /* may post more jobs */
+        n++;
+    }
+    return n;
+}
+
+bool ui_post(task_job_fn fn, void *arg)  { return queue_push(&s_ui,  fn, arg); }
+bool net_post(task_job_fn fn, void *arg) { return queue_push(&s_net, fn, arg); }
+
+int sim_run_ui_jobs(void)  { return queue_drain(&s_ui);  }
+int sim_run_net_jobs(void) { return queue_drain(&s_net); }
@@ -0,0 +1,13 @@
+#pragma once
+/* =====================================================================
+ *  sim_hal.h — AutoDine host simulator: task/lock shims
+ *
+ *  The firmware's UI and net tasks become one thread. lvgl_acquire() /
+ *  lvgl_release() are no-ops, ui_post() / net_post() fill two FIFOs
+ *  that sim_main.c drains at the points where the tasks would run.
+ * ===================================================================== */
+#include "hardware_compat.h"
+
+/* Run every queued job; returns how many ran */
+int sim_run_ui_jobs(void);
+int sim_run_net_jobs(void);
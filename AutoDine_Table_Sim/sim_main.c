@@ -0,0 +1,420 @@
+/* =====================================================================
+ *  sim_main.c — AutoDine host simulator (headless LVGL)
+ *
+ *  Runs the table UI (ui_screens.c, cart.c, state_machine.c, ...) on
+ *  Linux against an in-memory 800x480 RGB565 framebuffer. A virtual
+ *  clock advances UI_TASK_PERIOD_MS per step; the net task's work runs
+ *  every NET_TASK_PERIOD_MS of virtual time against sim_net.c.
+ *
+ *  A script drives the guest flow through the real input path:
+ *    wait <ms>             advance virtual time
+ *    tap <x> <y>           press + release at a point
+ *    click [#n] <text>     tap the n-th visible label containing text
+ *    shot <name>           write <outdir>/<name>.png
+ *    state <name>          force a state (splash, menu, bill, ...)
+ *    expect <name>         fail the run unless in that state
+ *    report                print the per-screen table now
+ *  Without -s the built-in guest flow below is used.
+ *
+ *  Usage: autodine_sim [-s script] [-o outdir] [-v]
+ * ===================================================================== */
+#include "lvgl.h"
+#include "app_config.h"
+#include "cart.h"
+#include "state_machine.h"
+#include "ui_screens.h"
+#include "anim_governor.h"
+#include "sim_hal.h"
+#include "sim_net.h"
+#include "sim_png.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_STEP_MS       UI_TASK_PERIOD_MS
+#define SIM_TAP_MS        60      /* finger down time for tap / click  */
+#define SIM_BUF_LINES     40      /* same stripe as the PARTIAL render mode */
+
+static const char *s_default_script[] = {
+    "wait 800",
+    "shot 01_splash",
+    "click TOUCH TO START",
+    "wait 1000",
+    "expect menu",
+    "shot 02_menu",
+    "click +",
+    "click +",
+    "click #3 +",
+    "wait 300",
+    "shot 03_cart",
+    "click PLACE ORDER",
+    "wait 600",
+    "expect placed",
+    "shot 04_placed",
+    "wait 9500",
+    "expect ready",
+    "shot 05_ready",
+    "click Received the Food",
+    "wait 900",
+    "expect served",
+    "shot 06_served",
+    "click DIGITAL BILL",
+    "wait 1000",
+    "expect bill",
+    "shot 07_bill",
+    "click Proceed to Payment",
+    "wait 1200",
+    "expect paysel",
+    "shot 08_paysel",
+    "click CASH / CARD",
+    "wait 600",
+    "expect cash",
+    "shot 09_cash",
+    "wait 9500",
+    "expect feedback",
+    "click #5 *",
+    "wait 400",
+    "shot 10_feedback",
+    "click SUBMIT FEEDBACK",
+    "wait 800",
+    "expect splash",
+    NULL
+};
+
+static const char *s_state_names[STATE_COUNT] = {
+    [STATE_SPLASH]         = "splash",
+    [STATE_MENU]           = "menu",
+    [STATE_ORDER_PLACED]   = "placed",
+    [STATE_FOOD_READY]     = "ready",
+    [STATE_FOOD_SERVED]    = "served",
+    [STATE_BILL]           = "bill",
+    [STATE_PAYMENT_SELECT] = "paysel",
+    [STATE_PAYMENT_UPI]    = "upi",
+    [STATE_PAYMENT_CASH]   = "cash",
+    [STATE_FEEDBACK]       = "feedback",
+};
+
+typedef struct {
+    uint32_t visits;
+    uint32_t enter_us_max;   /* pass that switched to this screen */
+    uint32_t frames;
+    uint64_t render_us;      /* passes that ended in a refresh */
+    uint32_t render_max_us;
+    uint64_t px;
+    uint32_t heap_max;       /* LVGL heap in use while shown */
+} state_stats_t;
+
+static uint16_t      s_fb[LCD_H_RES * LCD_V_RES];
+static lv_color_t    s_buf[LCD_H_RES * SIM_BUF_LINES];
+static state_stats_t s_stats[STATE_COUNT];
+
+static uint32_t   s_now_ms      = 0;
+static uint32_t   s_last_net_ms = 0;
+static bool       s_frame_done  = false;
+static uint32_t   s_frame_px    = 0;
+static lv_point_t s_ptr         = { 0, 0 };
+static bool       s_ptr_down    = false;
+static bool       s_net_started = false;
+static const char *s_outdir     = ".";
+static int        s_failures    = 0;
+
+static uint32_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static uint32_t heap_used(void)
+{
+    lv_mem_monitor_t m;
+    lv_mem_monitor(&m);
+    return (uint32_t)(m.total_size - m.free_size);
+}
+
+/* ---- Display / input drivers ---------------------------------------- */
+static void sim_flush(lv_disp_drv_t *drv, const lv_area_t *a, lv_color_t *px)
+{
+    int w = a->x2 - a->x1 + 1;
+    for (int y = a->y1; y <= a->y2; y++) {
+        memcpy(&s_fb[y * LCD_H_RES + a->x1], px, w * sizeof(lv_color_t));
+        px += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void sim_monitor(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+    (void)drv; (void)time_ms;
+    s_frame_done = true;
+    s_frame_px  += px;
+}
+
+static void sim_pointer_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    (void)drv;
+    data->point = s_ptr;
+    data->state = s_ptr_down ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    anim_gov_touch(s_ptr_down);
+}
+
+/* ---- Task emulation -------------------------------------------------- */
+static void wifi_up_job(void *arg)  { (void)arg; ui_set_wifi_connected(true); }
+static void menu_load_job(void *arg) { ui_menu_load((const char *)arg); free(arg); }
+
+/* What net_task() does in the firmware, minus the WiFi wait */
+static void sim_net_pass(void)
+{
+    sim_run_net_jobs();
+    ui_check_deferred();
+    if (!s_net_started) {
+        s_net_started = true;
+        ui_post(wifi_up_job, NULL);
+        char *json = net_fetch_menu();
+        if (json && !ui_post(menu_load_job, json)) free(json);
+    }
+}
+
+/* One UI task pass at virtual time s_now_ms */
+static void sim_step(void)
+{
+    lv_tick_inc(SIM_STEP_MS);
+    s_now_ms += SIM_STEP_MS;
+
+    app_state_t before = sm_get();
+    s_frame_done = false;
+    s_frame_px   = 0;
+
+    uint32_t t0 = now_us();
+    lvgl_acquire();
+    lv_timer_handler();
+    sim_run_ui_jobs();
+    sm_update();
+    lvgl_release();
+    uint32_t dt = now_us() - t0;
+
+    app_state_t st = sm_get();
+    state_stats_t *ss = &s_stats[st];
+    if (st != before) {
+        ss->visits++;
+        if (dt > ss->enter_us_max) ss->enter_us_max = dt;
+    }
+    if (s_frame_done) {
+        ss->frames++;
+        ss->render_us += dt;
+        ss->px        += s_frame_px;
+        if (dt > ss->render_max_us) ss->render_max_us = dt;
+        anim_gov_frame((dt + 500) / 1000);
+    }
+    anim_gov_tick();
+    uint32_t used = heap_used();
+    if (used > ss->heap_max) ss->heap_max = used;
+
+    if (s_now_ms - s_last_net_ms >= NET_TASK_PERIOD_MS) {
+        s_last_net_ms = s_now_ms;
+        sim_net_pass();
+    }
+}
+
+static void sim_wait(uint32_t ms)
+{
+    for (uint32_t t = 0; t < ms; t += SIM_STEP_MS) sim_step();
+}
+
+static void sim_tap(lv_coord_t x, lv_coord_t y)
+{
+    s_ptr.x = x; s_ptr.y = y;
+    s_ptr_down = true;
+    sim_wait(SIM_TAP_MS);
+    s_ptr_down = false;
+    sim_wait(SIM_STEP_MS * 2);
+}
+
+/* ---- Script helpers --------------------------------------------------- */
+static bool obj_visible(lv_obj_t *o)
+{
+    for (; o; o = lv_obj_get_parent(o))
+        if (lv_obj_has_flag(o, LV_OBJ_FLAG_HIDDEN)) return false;
+    return true;
+}
+
+/* Depth-first search for the n-th visible label containing text */
+static lv_obj_t *find_label(lv_obj_t *root, const char *text, int *nth)
+{
+    if (lv_obj_check_type(root, &lv_label_class) && obj_visible(root) &&
+        strstr(lv_label_get_text(root), text) && --(*nth) == 0)
+        return root;
+    uint32_t cnt = lv_obj_get_child_cnt(root);
+    for (uint32_t i = 0; i < cnt; i++) {
+        lv_obj_t *hit = find_label(lv_obj_get_child(root, i), text, nth);
+        if (hit) return hit;
+    }
+    return NULL;
+}
+
+static bool sim_click(const char *text, int nth)
+{
+    lv_obj_t *lbl = find_label(lv_layer_top(), text, &nth);
+    if (!lbl) lbl = find_label(lv_scr_act(), text, &nth);
+    if (!lbl) return false;
+
+    lv_obj_t *target = lbl;
+    while (target && !lv_obj_has_flag(target, LV_OBJ_FLAG_CLICKABLE))
+        target = lv_obj_get_parent(target);
+    if (!target) return false;
+
+    lv_obj_scroll_to_view_recursive(target, LV_ANIM_OFF);
+    lv_obj_update_layout(target);
+    lv_area_t a;
+    lv_obj_get_coords(target, &a);
+    sim_tap((a.x1 + a.x2) / 2, (a.y1 + a.y2) / 2);
+    return true;
+}
+
+static int state_by_name(const char *name)
+{
+    for (int i = 0; i < STATE_COUNT; i++)
+        if (strcmp(s_state_names[i], name) == 0) return i;
+    return -1;
+}
+
+static void sim_shot(const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.png", s_outdir, name);
+    if (sim_png_write_rgb565(path, s_fb, LCD_H_RES, LCD_V_RES) == 0)
+        printf("[SIM] %6lu ms  shot %s\n", (unsigned long)s_now_ms, path);
+    else
+        printf("[SIM] cannot write %s\n", path);
+}
+
+static void sim_report(void)
+{
+    lv_mem_monitor_t m;
+    lv_mem_monitor(&m);
+    printf("\n%-9s %6s %9s %9s %7s %7s %9s %9s %9s %9s\n",
+           "screen", "visits", "build_ms", "build_B", "enter", "frames",
+           "rend_avg", "rend_max", "px/frame", "heap_max");
+    for (int i = 0; i < STATE_COUNT; i++) {
+        state_stats_t *ss = &s_stats[i];
+        uint32_t b_us = 0, b_bytes = 0;
+        ui_screen_build_stats((app_state_t)i, &b_us, &b_bytes);
+        if (!ss->visits && !ss->frames && !b_us) continue;
+        printf("%-9s %6lu %9.2f %9lu %5.2fms %7lu %7.2fms %7.2fms %9lu %9lu\n",
+               s_state_names[i], (unsigned long)ss->visits, b_us / 1000.0,
+               (unsigned long)b_bytes, ss->enter_us_max / 1000.0,
+               (unsigned long)ss->frames,
+               ss->frames ? ss->render_us / 1000.0 / ss->frames : 0.0,
+               ss->render_max_us / 1000.0,
+               (unsigned long)(ss->frames ? ss->px / ss->frames : 0),
+               (unsigned long)ss->heap_max);
+    }
+    printf("LVGL heap: %lu B total, %lu B peak, %u%% frag; %d net calls; "
+           "%lu ms virtual\n\n",
+           (unsigned long)m.total_size, (unsigned long)m.max_used, m.frag_pct,
+           sim_net_calls(), (unsigned long)s_now_ms);
+}
+
+static void run_line(const char *line)
+{
+    char cmd[16], arg[256] = "";
+    while (*line == ' ' || *line == '\t') line++;
+    if (!*line || *line == '#' || *line == '\n') return;
+    if (sscanf(line, "%15s %255[^\n]", cmd, arg) < 1) return;
+
+    if (strcmp(cmd, "wait") == 0) {
+        sim_wait((uint32_t)atoi(arg));
+    } else if (strcmp(cmd, "tap") == 0) {
+        int x = 0, y = 0;
+        sscanf(arg, "%d %d", &x, &y);
+        sim_tap((lv_coord_t)x, (lv_coord_t)y);
+    } else if (strcmp(cmd, "click") == 0) {
+        int nth = 1;
+        const char *text = arg;
+        if (arg[0] == '#') {
+            nth = atoi(arg + 1);
+            text = strchr(arg, ' ');
+            text = text ? text + 1 : "";
+        }
+        if (!sim_click(text, nth)) {
+            printf("[SIM] %6lu ms  no visible \"%s\" (#%d) on %s\n",
+                   (unsigned long)s_now_ms, text, nth, s_state_names[sm_get()]);
+            s_failures++;
+        }
+    } else if (strcmp(cmd, "shot") == 0) {
+        sim_shot(arg);
+    } else if (strcmp(cmd, "state") == 0) {
+        int st = state_by_name(arg);
+        if (st >= 0) { lvgl_acquire(); sm_set((app_state_t)st); lvgl_release(); }
+    } else if (strcmp(cmd, "expect") == 0) {
+        int st = state_by_name(arg);
+        if (st != (int)sm_get()) {
+            printf("[SIM] %6lu ms  expected %s, on %s\n", (unsigned long)s_now_ms,
+                   arg, s_state_names[sm_get()]);
+            s_failures++;
+        }
+    } else if (strcmp(cmd, "report") == 0) {
+        sim_report();
+    } else {
+        printf("[SIM] unknown command: %s\n", cmd);
+        s_failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *script = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)      script   = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) s_outdir = argv[++i];
+        else if (strcmp(argv[i], "-v") == 0)                 sim_net_set_verbose(true);
+        else {
+            fprintf(stderr, "usage: %s [-s script] [-o outdir] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    lv_disp_draw_buf_init(&draw_buf, s_buf, NULL, LCD_H_RES * SIM_BUF_LINES);
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res    = LCD_H_RES;
+    disp_drv.ver_res    = LCD_V_RES;
+    disp_drv.flush_cb   = sim_flush;
+    disp_drv.monitor_cb = sim_monitor;
+    disp_drv.draw_buf   = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type    = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = sim_pointer_read;
+    lv_indev_drv_register(&indev_drv);
+
+    sm_init();
+    cart_clear();
+    uint32_t t0 = now_us();
+    lvgl_acquire();
+    ui_init();
+    ui_show_screen(STATE_SPLASH);
+    lvgl_release();
+    s_stats[STATE_SPLASH].visits = 1;
+    s_stats[STATE_SPLASH].enter_us_max = now_us() - t0;
+
+    if (script) {
+        FILE *f = fopen(script, "r");
+        if (!f) { perror(script); return 2; }
+        char line[300];
+        while (fgets(line, sizeof(line), f)) run_line(line);
+        fclose(f);
+    } else {
+        for (int i = 0; s_default_script[i]; i++) run_line(s_default_script[i]);
+    }
+
+    sim_report();
+    if (s_failures) printf("[SIM] %d script step(s) failed\n", s_failures);
+    return s_failures ? 1 : 0;
+}
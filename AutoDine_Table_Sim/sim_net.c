@@ -0,0 +1,268 @@
+/* =====================================================================
+ *  sim_net.c — AutoDine host simulator: scripted autodine_net
+ * ===================================================================== */
+#include "sim_net.h"
+#include "cart.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_ORDER_ID   101
+#define SIM_BILL_MAX   CART_HARD_CAP
+
+static const char SIM_MENU[] =
+"["
+"{\"id\":1,\"name\":\"Paneer Tikka\",\"description\":\"Char-grilled cottage cheese, mint chutney\",\"category\":\"Starters\",\"price\":220,\"is_veg\":true,\"available\":true},"
+"{\"id\":2,\"name\":\"Chicken 65\",\"description\":\"Spicy deep-fried chicken, curry leaves\",\"category\":\"Starters\",\"price\":260,\"is_veg\":false,\"available\":true},"
+"{\"id\":3,\"name\":\"Veg Spring Rolls\",\"description\":\"Crisp rolls with sweet chilli dip\",\"category\":\"Starters\",\"price\":180,\"is_veg\":true,\"available\":true},"
+"{\"id\":4,\"name\":\"Fish Amritsari\",\"description\":\"Gram-flour battered river fish\",\"category\":\"Starters\",\"price\":320,\"is_veg\":false,\"available\":false},"
+"{\"id\":5,\"name\":\"Butter Chicken\",\"description\":\"Tandoori chicken in tomato butter gravy\",\"category\":\"Main Course\",\"price\":340,\"is_veg\":false,\"available\":true},"
+"{\"id\":6,\"name\":\"Dal Makhani\",\"description\":\"Slow-cooked black lentils, cream\",\"category\":\"Main Course\",\"price\":240,\"is_veg\":true,\"available\":true},"
+"{\"id\":7,\"name\":\"Veg Biryani\",\"description\":\"Basmati, vegetables, saffron, raita\",\"category\":\"Main Course\",\"price\":260,\"is_veg\":true,\"available\":true},"
+"{\"id\":8,\"name\":\"Mutton Rogan Josh\",\"description\":\"Kashmiri lamb curry\",\"category\":\"Main Course\",\"price\":420,\"is_veg\":false,\"available\":true},"
+"{\"id\":9,\"name\":\"Palak Paneer\",\"description\":\"Cottage cheese in spinach gravy\",\"category\":\"Main Course\",\"price\":250,\"is_veg\":true,\"available\":true},"
+"{\"id\":10,\"name\":\"Butter Naan\",\"description\":\"Tandoor-baked flatbread\",\"category\":\"Main Course\",\"price\":50,\"is_veg\":true,\"available\":true},"
+"{\"id\":11,\"name\":\"Masala Chai\",\"description\":\"Spiced milk tea\",\"category\":\"Drinks\",\"price\":60,\"is_veg\":true,\"available\":true},"
+"{\"id\":12,\"name\":\"Sweet Lassi\",\"description\":\"Chilled yoghurt drink\",\"category\":\"Drinks\",\"price\":90,\"is_veg\":true,\"available\":true},"
+"{\"id\":13,\"name\":\"Fresh Lime Soda\",\"description\":\"Sweet or salted\",\"category\":\"Drinks\",\"price\":80,\"is_veg\":true,\"available\":true},"
+"{\"id\":14,\"name\":\"Cold Coffee\",\"description\":\"With vanilla ice cream\",\"category\":\"Drinks\",\"price\":120,\"is_veg\":true,\"available\":true},"
+"{\"id\":15,\"name\":\"Gulab Jamun\",\"description\":\"Two pieces, warm syrup\",\"category\":\"Desserts\",\"price\":90,\"is_veg\":true,\"available\":true},"
+"{\"id\":16,\"name\":\"Rasmalai\",\"description\":\"Saffron milk, pistachio\",\"category\":\"Desserts\",\"price\":110,\"is_veg\":true,\"available\":true},"
+"{\"id\":17,\"name\":\"Kulfi Falooda\",\"description\":\"Rose syrup, vermicelli, basil seeds\",\"category\":\"Desserts\",\"price\":140,\"is_veg\":true,\"available\":true},"
+"{\"id\":18,\"name\":\"Green Salad\",\"description\":\"Cucumber, onion, tomato, lemon\",\"category\":\"Sides\",\"price\":70,\"is_veg\":true,\"available\":true},"
+"{\"id\":19,\"name\":\"Boondi Raita\",\"description\":\"Yoghurt with gram-flour pearls\",\"category\":\"Sides\",\"price\":60,\"is_veg\":true,\"available\":true},"
+"{\"id\":20,\"name\":\"Papad Basket\",\"description\":\"Roasted and fried\",\"category\":\"Sides\",\"price\":40,\"is_veg\":true,\"available\":true}"
+"]";
+
+typedef struct { int id; int seat; char name[CART_MAX_NAME]; int qty; int price; } bill_line_t;
+
+static bill_line_t s_bill[SIM_BILL_MAX];
+static int  s_bill_count  = 0;
+static int  s_order_polls = 0;
+static int  s_pay_polls   = 0;
+static int  s_calls       = 0;
+static bool s_verbose     = false;
+
+void sim_net_set_verbose(bool on) { s_verbose = on; }
+int  sim_net_calls(void)          { return s_calls; }
+
+void sim_net_reset(void)
+{
+    s_bill_count = s_order_polls = s_pay_polls = 0;
+}
+
+static char *dup_str(const char *s)
+{
+    size_t n = strlen(s) + 1;
+    char *p = malloc(n);
+    if (p) memcpy(p, s, n);
+    return p;
+}
+
+/* The firmware posts the cart it is about to clear; snapshot it */
+static void bill_add_cart(void)
+{
+    for (const cart_item_t *it = cart_first(); it; it = cart_next(it)) {
+        int j;
+        for (j = 0; j < s_bill_count; j++)
+            if (s_bill[j].id == it->id && s_bill[j].seat == it->seat) break;
+        if (j == s_bill_count) {
+            if (s_bill_count >= SIM_BILL_MAX) break;
+            s_bill[j].id    = it->id;
+            s_bill[j].seat  = it->seat;
+            s_bill[j].qty   = 0;
+            s_bill[j].price = it->price_paise / 100;
+            snprintf(s_bill[j].name, sizeof(s_bill[j].name), "%s", it->name);
+            s_bill_count++;
+        }
+        s_bill[j].qty += it->qty;
+    }
+}
+
+bool  net_is_wifi_ok(void)  { return true; }
+char *net_fetch_menu(void)  { s_calls++; return dup_str(SIM_MENU); }
+
+char *net_get_availability(void)
+{
+    s_calls++;
+    return dup_str("{\"1\":true,\"2\":true,\"3\":true,\"4\":false}");
+}
+
+void net_op_id_new(char *buf, int len)
+{
+    static unsigned seq;
+    snprintf(buf, len, "t%d-sim-%u", TABLE_NUMBER, ++seq);
+}
+
+void net_json_escape(const char *src, char *dst, int dst_len)
+{
+    int di = 0;
+    for (int i = 0; src[i] && di < dst_len - 3; i++) {
+        char c = src[i];
+        if (c == '"' || c == '\\') {
+            dst[di++] = '\\';
+            dst[di++] = c;
+        } else if (c == '\n') {
+            dst[di++] = '\\';
+            dst[di++] = 'n';
+        } else if (c == '\r') {
+            /* skip carriage returns */
+        } else if (c == '\t') {
+            dst[di++] = '\\';
+            dst[di++] = 't';
+        } else {
+            dst[di++] = c;
+        }
+    }
+    dst[di] = '\0';
+}
+
+int net_place_order(const char *cart_json, const char *cart_id, const char *op_id,
+                    int *out_order_id)
+{
+    (void)cart_json; (void)cart_id; (void)op_id;
+    s_calls++;
+    sim_net_reset();
+    bill_add_cart();
+    *out_order_id = SIM_ORDER_ID;
+    return 0;
+}
+
+int net_append_order(int order_id, const char *new_items_json, const char *cart_id,
+                     const char *op_id)
+{
+    (void)order_id; (void)new_items_json; (void)cart_id; (void)op_id;
+    s_calls++;
+    bill_add_cart();
+    s_order_polls = 0;
+    return 0;
+}
+
+int net_food_served(int order_id) { (void)order_id; s_calls++; return 0; }
+int net_call_waiter(int order_id) { (void)order_id; s_calls++; return 0; }
+
+void net_get_order_status(int order_id, char *out_buf, int buf_len)
+{
+    (void)order_id;
+    s_calls++;
+    snprintf(out_buf, buf_len, "%s",
+             ++s_order_polls > SIM_READY_AFTER_POLLS ? "ready" : "preparing");
+}
+
+int net_get_order_json(int order_id, char *out_buf, int buf_len)
+{
+    char st[NET_STATUS_LEN];
+    net_get_order_status(order_id, st, sizeof(st));
+    snprintf(out_buf, buf_len, "{\"id\":%d,\"status\":\"%s\"}", order_id, st);
+    return 0;
+}
+
+char *net_request_bill(int order_id, bool preview)
+{
+    (void)preview;
+    s_calls++;
+    int sub = 0;
+    size_t cap = 128 + (size_t)s_bill_count * (CART_MAX_NAME + 60);
+    char *js = malloc(cap);
+    if (!js) return NULL;
+    int n = snprintf(js, cap, "{\"order_id\":%d,\"items\":[", order_id);
+    for (int i = 0; i < s_bill_count; i++) {
+        n += snprintf(js + n, cap - n,
+                      "%s{\"item_name\":\"%s\",\"qty\":%d,\"price\":%d,\"seat\":%d}",
+                      i ? "," : "", s_bill[i].name, s_bill[i].qty, s_bill[i].price,
+                      s_bill[i].seat);
+        sub += s_bill[i].qty * s_bill[i].price;
+    }
+    int gst = sub * 5 / 100;
+    snprintf(js + n, cap - n, "],\"subtotal\":%d,\"gst\":%d,\"total\":%d}",
+             sub, gst, sub + gst);
+    return js;
+}
+
+int net_select_payment(int order_id, int seat, const char *method)
+{
+    (void)order_id; (void)seat; (void)method;
+    s_calls++;
+    s_pay_polls = 0;
+    return 0;
+}
+
+void net_get_payment_status(int order_id, int seat, char *out_buf, int buf_len)
+{
+    (void)order_id; (void)seat;
+    s_calls++;
+    snprintf(out_buf, buf_len, "%s",
+             ++s_pay_polls > SIM_PAID_AFTER_POLLS ? "paid" : "pending");
+}
+
+char *net_create_razorpay_order(int order_id, int seat, bool preview)
+{
+    (void)seat; (void)preview;
+    char js[160];
+    s_calls++;
+    snprintf(js, sizeof(js),
+             "{\"qr_url\":\"upi://pay?pa=autodine@upi&pn=AutoDine&tr=%d\"}", order_id);
+    return dup_str(js);
+}
+
+void net_get_razorpay_status(int order_id, int seat, char *out_buf, int buf_len)
+{
+    net_get_payment_status(order_id, seat, out_buf, buf_len);
+}
+
+int net_payment_timeout(int order_id, int seat)
+{
+    (void)order_id; (void)seat;
+    s_calls++;
+    return 0;
+}
+
+int net_submit_feedback(int order_id, int stars, const char *comment)
+{
+    (void)comment;
+    s_calls++;
+    if (s_verbose) printf("[SIM] feedback order=%d stars=%d\n", order_id, stars);
+    return 0;
+}
+
+int net_buzz(int pattern) { (void)pattern; s_calls++; return 0; }
+
+int net_cart_delta(const char *json)
+{
+    s_calls++;
+    if (s_verbose) printf("[SIM] cart delta %s\n", json);
+    return 0;
+}
+
+/* The sim "server" always holds the cart the table streamed */
+int net_commit_cart(const char *cart_id, int seq, int append_oid,
+                    int items, int subtotal, const char *op_id, int *out_order_id)
+{
+    if (s_verbose) printf("[SIM] commit %s seq %d: %d items, Rs %d\n",
+                          cart_id, seq, items, subtotal);
+    if (append_oid > 0) {
+        *out_order_id = append_oid;
+        return net_append_order(append_oid, NULL, cart_id, op_id);
+    }
+    return net_place_order(NULL, cart_id, op_id, out_order_id);
+}
+
+int net_post_trace(const char *json)
+{
+    s_calls++;
+    if (s_verbose) printf("[SIM] trace %s\n", json);
+    return 0;
+}
+
+void net_log(const char *fmt, ...)
+{
+    if (!s_verbose) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+/* Virtual time: the sim clock only moves in sim_main's step loop */
+void net_delay(uint32_t ms) { (void)ms; }
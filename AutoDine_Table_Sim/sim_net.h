@@ -0,0 +1,18 @@
+#pragma once
+/* =====================================================================
+ *  sim_net.h — AutoDine host simulator: scripted autodine_net
+ *
+ *  Every net_* call answers from canned data with no I/O. Orders move
+ *  to "ready" and payments to "paid" after a fixed number of polls so
+ *  the real polling paths in ui_screens.c run end to end.
+ * ===================================================================== */
+#include "autodine_net.h"
+
+#define SIM_READY_AFTER_POLLS  2   /* GET /api/order/<id> before "ready" */
+#define SIM_PAID_AFTER_POLLS   2   /* payment status polls before "paid" */
+
+void sim_net_set_verbose(bool on);
+void sim_net_reset(void);
+
+/* Count of HTTP calls the firmware made, for the run summary */
+int  sim_net_calls(void);
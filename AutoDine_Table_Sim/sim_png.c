@@ -0,0 +1,113 @@
+/* =====================================================================
+ *  sim_png.c — AutoDine host simulator: framebuffer -> PNG
+ * ===================================================================== */
+#include "sim_png.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STORED_MAX  65535u   /* bytes per stored deflate block */
+
+static uint32_t s_crc_table[256];
+
+static void crc_init(void)
+{
+    if (s_crc_table[1]) return;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        s_crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *p, size_t n)
+{
+    while (n--) crc = s_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+static int write_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+    uint8_t hdr[8];
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    uint32_t crc = crc_update(0xFFFFFFFFu, hdr + 4, 4);
+    crc = crc_update(crc, data, len) ^ 0xFFFFFFFFu;
+    uint8_t tail[4];
+    put_be32(tail, crc);
+    return (fwrite(hdr, 1, 8, f) == 8 &&
+            (len == 0 || fwrite(data, 1, len, f) == len) &&
+            fwrite(tail, 1, 4, f) == 4) ? 0 : -1;
+}
+
+int sim_png_write_rgb565(const char *path, const uint16_t *px, int w, int h)
+{
+    crc_init();
+
+    /* Raw scanlines: filter byte 0 + RGB888 */
+    size_t row = (size_t)w * 3 + 1;
+    size_t raw_len = row * (size_t)h;
+    uint8_t *raw = malloc(raw_len);
+    if (!raw) return -1;
+    for (int y = 0; y < h; y++) {
+        uint8_t *d = raw + row * y;
+        *d++ = 0;
+        for (int x = 0; x < w; x++) {
+            uint16_t c = px[y * w + x];
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            *d++ = (uint8_t)((r << 3) | (r >> 2));
+            *d++ = (uint8_t)((g << 2) | (g >> 4));
+            *d++ = (uint8_t)((b << 3) | (b >> 2));
+        }
+    }
+
+    /* zlib stream: header, stored blocks, adler32 */
+    size_t blocks = raw_len / STORED_MAX + 1;
+    size_t z_len  = 2 + raw_len + blocks * 5 + 4;
+    uint8_t *z = malloc(z_len);
+    if (!z) { free(raw); return -1; }
+    size_t o = 0;
+    z[o++] = 0x78; z[o++] = 0x01;
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw_len; i++) {
+        a = (a + raw[i]) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    for (size_t pos = 0; pos < raw_len || pos == 0; ) {
+        size_t n = raw_len - pos;
+        if (n > STORED_MAX) n = STORED_MAX;
+        z[o++] = (pos + n >= raw_len) ? 1 : 0;   /* BFINAL, BTYPE=00 */
+        z[o++] = (uint8_t)n;  z[o++] = (uint8_t)(n >> 8);
+        z[o++] = (uint8_t)~n; z[o++] = (uint8_t)(~n >> 8);
+        memcpy(z + o, raw + pos, n);
+        o += n; pos += n;
+        if (n == 0) break;
+    }
+    put_be32(z + o, (b << 16) | a);
+    o += 4;
+    free(raw);
+
+    uint8_t ihdr[13];
+    put_be32(ihdr, (uint32_t)w);
+    put_be32(ihdr + 4, (uint32_t)h);
+    ihdr[8] = 8; ihdr[9] = 2; ihdr[10] = 0; ihdr[11] = 0; ihdr[12] = 0;
+
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    FILE *f = fopen(path, "wb");
+    int rc = -1;
+    if (f) {
+        rc = (fwrite(sig, 1, 8, f) == 8 &&
+              write_chunk(f, "IHDR", ihdr, 13) == 0 &&
+              write_chunk(f, "IDAT", z, (uint32_t)o) == 0 &&
+              write_chunk(f, "IEND", NULL, 0) == 0) ? 0 : -1;
+        if (fclose(f) != 0) rc = -1;
+    }
+    free(z);
+    return rc;
+}
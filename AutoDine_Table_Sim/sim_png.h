@@ -0,0 +1,10 @@
+#pragma once
+/* =====================================================================
+ *  sim_png.h — AutoDine host simulator: framebuffer -> PNG
+ *
+ *  Writes an RGB565 buffer as an 8-bit RGB PNG using stored (level 0)
+ *  deflate blocks, so no zlib dependency. Returns 0 on success.
+ * ===================================================================== */
+#include <stdint.h>
+
+int sim_png_write_rgb565(const char *path, const uint16_t *px, int w, int h);
@@ -2,15 +2,25 @@
  * AutoDine V4.0 — Waiter Robot Firmware
  * Board:   Arduino Uno
  * Motor:   Adafruit Motor Shield V2 (I2C)
- * Sensor:  HC-SR04  TRIG=7  ECHO=8
+ * Sensor:  HC-SR04  TRIG=7  ECHO=8 (ICP1: echo timed by Timer1 capture)
+ * Encoder: single-channel wheel encoders, left D2 (INT0), right D3 (INT1)
  * BT:      HC-05 on Serial (pins 0/1, 9600 baud)
  *
  * Commands (via Bluetooth from phone / chef):
  *   'G' = Go forward until obstacle < 30 cm, then stop
- *   'B' = Reverse same distance back to home
+ *   'B' = Reverse to home (odometry position 0)
  *   'S' = Emergency stop
+ *   'D' = Report odometry (distance from home)
  *
  * Buzzer patterns handled on Host Unit (ESP32). Robot just drives.
+ *
+ * loop() never blocks: the echo pulse is timed in hardware (Timer1
+ * input capture) and the sensor is re-triggered as soon as each echo
+ * ends, so commands and obstacle checks run every pass.
+ *
+ * Distance is wheel odometry, not drive time: each leg is a closed
+ * loop on encoder ticks (sides kept level, return leg slowing into
+ * home), so battery sag, load and slip no longer move "home".
  */
 
 #include <Wire.h>
@@ -19,11 +29,27 @@
 /* ---- Pins ---------------------------------------------------- */
 #define TRIG_PIN  7
 #define ECHO_PIN  8
+#define ENC_L_PIN 2     /* INT0 */
+#define ENC_R_PIN 3     /* INT1 */
 
 /* ---- Constants ----------------------------------------------- */
 #define OBSTACLE_CM      30     /* stop if ultrasonic reads < this  */
 #define MOTOR_SPEED      180    /* 0-255                             */
 #define PULSE_TIMEOUT_US 25000  /* ~430 cm max range                */
+#define RANGE_GUARD_US   2000   /* echo end -> next trigger (ghosts) */
+#define RANGE_STUCK_US   60000  /* no echo edge at all: re-trigger   */
+
+/* ---- Odometry / distance control ------------------------------ */
+#define ENC_TICKS_PER_REV 20    /* slots on the encoder disc        */
+#define WHEEL_CIRC_MM     204   /* 65 mm wheel                      */
+#define ENC_DEBOUNCE_US   500   /* slot edges closer than this: noise */
+#define CTRL_PERIOD_MS    20    /* controller update                 */
+#define KP_BALANCE        8     /* speed units per tick L/R mismatch */
+#define KP_HOME           6     /* speed units per tick left to home */
+#define MOTOR_MIN_SPEED   70    /* slowest that still turns loaded   */
+#define HOME_TOL_TICKS    0     /* stop when this close to home      */
+#define FORWARD_MAX_CM    800   /* no obstacle by then: stop anyway  */
+#define ENC_STALL_MS      800   /* driving, no tick on either side   */
 
 /* ---- Motor Shield -------------------------------------------- */
 Adafruit_MotorShield AFMS = Adafruit_MotorShield();
@@ -36,41 +62,219 @@ Adafruit_DCMotor *motorRR = NULL;  /* Rear Right  — M4 */
 enum RobotState { IDLE, GOING_FORWARD, REVERSING, STOPPED };
 RobotState robotState = IDLE;
 
-unsigned long steps_forward = 0;   /* ms spent going forward */
 unsigned long move_start    = 0;
+unsigned long move_pings    = 0;   /* range_pings at move start */
 
 /* ================================================================
- *  Ultrasonic — returns distance in cm (0 = timeout / error)
+ *  Ultrasonic — Timer1 input capture on ICP1 (D8)
+ *  Timer1 free-runs at 16 MHz / 64 = 4 us per tick (wraps every
+ *  262 ms, longer than any echo incl. the sensor's ~38 ms no-echo
+ *  pulse). The ISR stamps the rising edge, flips to falling and
+ *  publishes the width. Timer1 is otherwise unused here (the motor
+ *  shield is I2C; no Servo, no analogWrite on D9/D10).
  * ================================================================ */
-long getDistanceCm() {
-    digitalWrite(TRIG_PIN, LOW);
-    delayMicroseconds(2);
-    digitalWrite(TRIG_PIN, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(TRIG_PIN, LOW);
-    long duration = pulseIn(ECHO_PIN, HIGH, PULSE_TIMEOUT_US);
-    if (duration == 0) return 999;          /* no echo = clear path */
-    return duration / 58L;                  /* cm */
+volatile uint16_t      echo_rise;       /* Timer1 ticks          */
+volatile uint16_t      echo_ticks;      /* last pulse width      */
+volatile unsigned long echo_fall_us;    /* micros() at its end   */
+volatile bool          echo_ready = false;
+
+ISR(TIMER1_CAPT_vect) {
+    uint16_t t = ICR1;
+    if (TCCR1B & _BV(ICES1)) {              /* rising: echo starts   */
+        echo_rise = t;
+        TCCR1B &= ~_BV(ICES1);
+    } else {                                /* falling: echo done    */
+        echo_ticks   = t - echo_rise;       /* wrap-safe, 16 bit     */
+        echo_fall_us = micros();
+        echo_ready   = true;
+        TCCR1B |= _BV(ICES1);
+    }
+    TIFR1 = _BV(ICF1);                      /* edge change can set it */
+}
+
+void ranging_begin() {
+    TCCR1A = 0;
+    TCCR1B = _BV(ICNC1) | _BV(ICES1) | _BV(CS11) | _BV(CS10);  /* /64, rising */
+    TIFR1  = _BV(ICF1);
+    TIMSK1 = _BV(ICIE1);
+}
+
+/* Measurement cycle: ARMED waits out the guard and triggers, WAITING
+ * waits for the capture ISR. Returns true with a fresh distance (cm,
+ * 999 = no echo = clear path) and the micros() the echo ended. */
+enum RangeState { RANGE_ARMED, RANGE_WAITING };
+RangeState    rangeState  = RANGE_ARMED;
+unsigned long range_t0    = 0;     /* next trigger / last trigger time */
+unsigned long range_pings = 0;
+
+bool ranging_poll(long *cm, unsigned long *fall_us) {
+    unsigned long now = micros();
+    if (rangeState == RANGE_ARMED) {
+        if ((long)(now - range_t0) < 0) return false;
+        if (digitalRead(ECHO_PIN) == HIGH) return false;   /* old echo still up */
+        noInterrupts();
+        echo_ready = false;
+        TCCR1B |= _BV(ICES1);
+        TIFR1   = _BV(ICF1);
+        interrupts();
+        digitalWrite(TRIG_PIN, HIGH);
+        delayMicroseconds(10);
+        digitalWrite(TRIG_PIN, LOW);
+        range_t0   = now;
+        rangeState = RANGE_WAITING;
+        return false;
+    }
+    if (!echo_ready) {
+        if (now - range_t0 > RANGE_STUCK_US) {              /* lost the edge */
+            rangeState = RANGE_ARMED;
+            range_t0   = now;
+        }
+        return false;
+    }
+    noInterrupts();
+    unsigned long us = (unsigned long)echo_ticks * 4UL;
+    *fall_us   = echo_fall_us;
+    echo_ready = false;
+    interrupts();
+    *cm = (us > PULSE_TIMEOUT_US) ? 999 : (long)(us / 58UL);
+    rangeState = RANGE_ARMED;
+    range_t0   = *fall_us + RANGE_GUARD_US;
+    range_pings++;
+    return true;
+}
+
+/* ================================================================
+ *  Wheel encoders — one counter per side, signed by the drive
+ *  direction (single-channel discs cannot tell). The sign is kept
+ *  after a stop, so the coast is counted the way it actually rolls.
+ * ================================================================ */
+volatile long          enc_pos_l = 0, enc_pos_r = 0;   /* ticks from home */
+volatile unsigned long enc_last_l = 0, enc_last_r = 0; /* micros()        */
+volatile int8_t        enc_dir   = 1;
+
+void enc_left_isr() {
+    unsigned long now = micros();
+    if (now - enc_last_l < ENC_DEBOUNCE_US) return;
+    enc_last_l = now;
+    enc_pos_l += enc_dir;
+}
+
+void enc_right_isr() {
+    unsigned long now = micros();
+    if (now - enc_last_r < ENC_DEBOUNCE_US) return;
+    enc_last_r = now;
+    enc_pos_r += enc_dir;
+}
+
+void enc_read(long *l, long *r) {
+    noInterrupts();
+    *l = enc_pos_l;
+    *r = enc_pos_r;
+    interrupts();
+}
+
+long ticks_to_cm(long ticks) {
+    return ticks * WHEEL_CIRC_MM / (ENC_TICKS_PER_REV * 10L);
+}
+
+/* Distance from home in ticks (mean of both sides) */
+long odo_ticks() {
+    long l, r;
+    enc_read(&l, &r);
+    return (l + r) / 2;
 }
 
 /* ================================================================
  *  Motor helpers
  * ================================================================ */
+int speed_l = -1, speed_r = -1;    /* last written (I2C is slow) */
+
+void set_side_speeds(int left, int right) {
+    if (left != speed_l) {
+        motorFL->setSpeed(left);
+        motorRL->setSpeed(left);
+        speed_l = left;
+    }
+    if (right != speed_r) {
+        motorFR->setSpeed(right);
+        motorRR->setSpeed(right);
+        speed_r = right;
+    }
+}
+
 void set_all_motors(int dir, int speed) {
-    motorFL->setSpeed(speed);
-    motorFR->setSpeed(speed);
-    motorRL->setSpeed(speed);
-    motorRR->setSpeed(speed);
+    set_side_speeds(speed, speed);
     motorFL->run(dir);
     motorFR->run(dir);
     motorRL->run(dir);
     motorRR->run(dir);
 }
 
-void drive_forward()  { set_all_motors(FORWARD,  MOTOR_SPEED); }
-void drive_backward() { set_all_motors(BACKWARD, MOTOR_SPEED); }
+void drive_forward()  { enc_dir =  1; set_all_motors(FORWARD,  MOTOR_SPEED); }
+void drive_backward() { enc_dir = -1; set_all_motors(BACKWARD, MOTOR_SPEED); }
 void stop_motors()    { set_all_motors(RELEASE,  0); }
 
+void report_odometry(const char *what) {
+    long l, r;
+    enc_read(&l, &r);
+    Serial.print(what);
+    Serial.print(" ");
+    Serial.print(ticks_to_cm((l + r) / 2));
+    Serial.print(" cm from home (L ");
+    Serial.print(ticks_to_cm(l));
+    Serial.print(" / R ");
+    Serial.print(ticks_to_cm(r));
+    Serial.println(" cm)");
+}
+
+/* ================================================================
+ *  Distance controller — one step per CTRL_PERIOD_MS while driving.
+ *  Both legs: the side that has covered more ticks since the leg
+ *  started is slowed, so the robot tracks straight. Return leg: base
+ *  speed falls with the distance left, then stops at home.
+ *  Returns false when the leg is over (home reached or stalled).
+ * ================================================================ */
+long          leg_l0 = 0, leg_r0 = 0;      /* encoder counts at leg start */
+unsigned long ctrl_last = 0;
+
+void leg_start() {
+    enc_read(&leg_l0, &leg_r0);
+    ctrl_last = millis();
+}
+
+bool control_step() {
+    unsigned long now = millis();
+    if (now - ctrl_last < CTRL_PERIOD_MS) return true;
+    ctrl_last = now;
+
+    long l, r;
+    enc_read(&l, &r);
+    long dl = labs(l - leg_l0), dr = labs(r - leg_r0);
+
+    noInterrupts();
+    unsigned long last_us = (enc_last_l - enc_last_r < 0x80000000UL) ? enc_last_l : enc_last_r;
+    interrupts();
+    /* Same clock as the ISRs; a leg that never ticked counts from its start */
+    if (micros() - last_us > ENC_STALL_MS * 1000UL &&
+        now - move_start > ENC_STALL_MS) {
+        stop_motors();
+        Serial.println("Encoder stall — stopped. Check wheels / encoder wiring.");
+        return false;
+    }
+
+    int base = MOTOR_SPEED;
+    if (robotState == REVERSING) {
+        long left_ticks = (l + r) / 2 - HOME_TOL_TICKS;
+        if (left_ticks <= 0) return false;
+        base = constrain(MOTOR_MIN_SPEED + left_ticks * KP_HOME, MOTOR_MIN_SPEED, MOTOR_SPEED);
+    } else if (ticks_to_cm(dl > dr ? dl : dr) >= FORWARD_MAX_CM) {
+        return false;
+    }
+    int corr = (int)constrain((dl - dr) * KP_BALANCE, -base, base);
+    set_side_speeds(constrain(base - corr, 0, 255), constrain(base + corr, 0, 255));
+    return true;
+}
+
 /* ================================================================
  *  setup
  * ================================================================ */
@@ -80,6 +284,13 @@ void setup() {
 
     pinMode(TRIG_PIN, OUTPUT);
     pinMode(ECHO_PIN, INPUT);
+    digitalWrite(TRIG_PIN, LOW);
+    ranging_begin();
+
+    pinMode(ENC_L_PIN, INPUT_PULLUP);
+    pinMode(ENC_R_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(ENC_L_PIN), enc_left_isr,  RISING);
+    attachInterrupt(digitalPinToInterrupt(ENC_R_PIN), enc_right_isr, RISING);
 
     AFMS.begin();         /* I2C, default 1.6 kHz */
 
@@ -90,7 +301,7 @@ void setup() {
 
     stop_motors();
     robotState = IDLE;
-    Serial.println("Motors initialised. Waiting for command (G/B/S)...");
+    Serial.println("Motors initialised. Waiting for command (G/B/S/D)...");
 }
 
 /* ================================================================
@@ -106,48 +317,73 @@ void loop() {
         if (cmd == 'G' || cmd == 'g') {
             if (robotState != GOING_FORWARD) {
                 Serial.println("CMD: GO FORWARD");
-                robotState   = GOING_FORWARD;
-                steps_forward = 0;
-                move_start    = millis();
+                robotState = GOING_FORWARD;
+                move_start = millis();
+                move_pings = range_pings;
+                leg_start();
                 drive_forward();
             }
         } else if (cmd == 'B' || cmd == 'b') {
             if (robotState != REVERSING) {
                 Serial.println("CMD: REVERSE");
-                robotState = REVERSING;
-                move_start = millis();
-                drive_backward();
+                if (odo_ticks() <= HOME_TOL_TICKS) {
+                    report_odometry("Already home:");
+                } else {
+                    robotState = REVERSING;
+                    move_start = millis();
+                    leg_start();
+                    drive_backward();
+                }
             }
         } else if (cmd == 'S' || cmd == 's') {
             Serial.println("CMD: EMERGENCY STOP");
             stop_motors();
             robotState = STOPPED;
+            report_odometry("Stopped");     /* 'B' still returns home */
+        } else if (cmd == 'D' || cmd == 'd') {
+            report_odometry("Position:");
         }
     }
 
+    /* ---- Ranging: one step of the measurement cycle ------------ */
+    long          dist    = 999;
+    unsigned long fall_us = 0;
+    bool fresh = ranging_poll(&dist, &fall_us);
+
     /* ---- State machine ----------------------------------------- */
     switch (robotState) {
 
         case GOING_FORWARD: {
-            long dist = getDistanceCm();
-            if (dist < OBSTACLE_CM) {
+            if (fresh && dist < OBSTACLE_CM) {
                 stop_motors();
-                steps_forward = millis() - move_start; /* record travel time */
-                robotState    = IDLE;
-                Serial.print("Obstacle! Stopped after ");
-                Serial.print(steps_forward);
+                /* echo end -> motors released (I2C writes included) */
+                unsigned long react_us = micros() - fall_us;
+                unsigned long run_ms   = millis() - move_start;
+                robotState = IDLE;
+                Serial.print("Obstacle at ");
+                Serial.print(dist);
+                Serial.print(" cm! Stopped after ");
+                Serial.print(run_ms);
                 Serial.println(" ms. Send 'B' to return.");
+                Serial.print("Reaction ");
+                Serial.print(react_us);
+                Serial.print(" us, ");
+                Serial.print((range_pings - move_pings) * 1000UL / (run_ms ? run_ms : 1));
+                Serial.println(" pings/s");
+                report_odometry("Out:");
+            } else if (!control_step()) {
+                stop_motors();
+                robotState = STOPPED;
+                report_odometry("Forward leg ended:");
             }
             break;
         }
 
         case REVERSING: {
-            unsigned long elapsed = millis() - move_start;
-            if (elapsed >= steps_forward) {
+            if (!control_step()) {
                 stop_motors();
-                robotState    = IDLE;
-                steps_forward = 0;
-                Serial.println("Returned to home position.");
+                robotState = IDLE;
+                report_odometry("Returned to home position:");
             }
             break;
         }
@@ -157,6 +393,4 @@ void loop() {
         default:
             break;
     }
-
-    delay(50); /* 20 Hz sensor poll rate */
 }
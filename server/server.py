@@ -21,12 +21,13 @@ try:
 except ImportError:
     pass  # python-dotenv not installed; keys must be set as real env vars
 
-from flask import Flask, request, jsonify, render_template, session, redirect, url_for, Response, stream_with_context
+from flask import Flask, request, jsonify, render_template, session, redirect, url_for, Response, stream_with_context, make_response, g
 from flask_cors import CORS
 
 # ── Firebase Admin SDK ────────────────────────────────────────────────
 import firebase_admin
 from firebase_admin import credentials, firestore
+from google.api_core.exceptions import AlreadyExists, FailedPrecondition
 
 # ── Optional QR code ──────────────────────────────────────────────────
 try:
@@ -239,6 +240,83 @@ def api_owner_required(f):
         return f(*args, **kwargs)
     return wrapped
 
+OP_CLAIM_STALE_S = 60    # a "running" claim older than this was orphaned
+
+def idempotent(f):
+    """Table mutations carry X-Op-Id ("t<table>-<boot>-<seq>") and are
+    retried on short timeouts. The first request with an id runs; a
+    repeat gets the stored reply, so a lost response never turns into a
+    second order or kitchen ticket. A repeat that races the first gets
+    503 and is retried by the table. A claim still "running" after
+    OP_CLAIM_STALE_S (worker died mid-request) is taken over by the
+    next repeat, guarded on the doc's update time so only one wins.
+    Claims are per endpoint: the table reuses one id for a whole order,
+    including the full post that follows a refused live-cart commit.
+    A handler that fails before writing anything drops its claim so the
+    retry starts clean; one that fails after _op_started() leaves it
+    "failed" with the order id, and the retry resumes that order."""
+    @wraps(f)
+    def wrapped(*args, **kwargs):
+        op = request.headers.get("X-Op-Id")
+        if not op:
+            return f(*args, **kwargs)
+        ref   = _doc("table_ops", f"{op}:{request.endpoint}")
+        g.op_id, g.op_ref, g.op_oid = op, ref, None
+        claim = {"state": "running", "path": request.path,
+                 "created_at": datetime.now().isoformat(), "claimed_at": time.time()}
+        try:
+            ref.create(claim)
+        except AlreadyExists:
+            snap = ref.get()
+            d = snap.to_dict() or {}
+            if d.get("state") == "done":
+                app.logger.info(f"op {op}: duplicate, replaying reply")
+                return jsonify(d.get("body", {})), d.get("code", 200)
+            if (d.get("state") != "failed"
+                    and time.time() - d.get("claimed_at", 0) < OP_CLAIM_STALE_S):
+                return jsonify({"error": "in progress", "op_id": op}), 503
+            try:
+                ref.update(claim, option=get_db().write_option(last_update_time=snap.update_time))
+            except FailedPrecondition:
+                return jsonify({"error": "in progress", "op_id": op}), 503
+            g.op_oid = d.get("oid")
+            app.logger.warning(f"op {op}: {d.get('state')} claim, running it again"
+                               + (f" on order #{g.op_oid}" if g.op_oid else ""))
+        try:
+            resp = make_response(f(*args, **kwargs))
+        except Exception:
+            _op_failed(ref)
+            raise
+        if resp.status_code >= 500:
+            _op_failed(ref)       # let the retry run (or resume) it
+        else:
+            ref.set({"state": "done", "code": resp.status_code,
+                     "body": resp.get_json(silent=True) or {}}, merge=True)
+        return resp
+    return wrapped
+
+def _op_failed(ref):
+    if g.get("op_oid") is None:
+        ref.delete()          # nothing written: the retry starts clean
+    else:
+        ref.update({"state": "failed"})
+
+def _op_started(oid):
+    """Record the order an idempotent op is about to write, before the
+    first write, so a retry after a partial failure finishes that order
+    instead of creating a second one."""
+    if g.get("op_ref") is not None and g.get("op_oid") != oid:
+        g.op_ref.update({"oid": oid})
+    g.op_oid = oid
+
+def _op_drop_items(oid):
+    """A resumed op: remove the lines its failed run got to write."""
+    if g.get("op_oid") != oid:
+        return
+    for d in _col("order_items").where("order_id", "==", oid).stream():
+        if d.to_dict().get("op") == g.op_id:
+            d.reference.delete()
+
 # ═════════════════════════════════════════════════════════════════════
 #  PAGES
 # ═════════════════════════════════════════════════════════════════════
@@ -319,42 +397,64 @@ def api_item_status():
 # ═════════════════════════════════════════════════════════════════════
 #  ORDER APIs
 # ═════════════════════════════════════════════════════════════════════
+def _write_order_items(oid, items):
+    """One order_items doc per cart line. Not batched: _next_id() runs its
+    own Firestore transaction, which conflicts with an open batch."""
+    for item in items:
+        iid = _next_id("order_items")
+        _doc("order_items", iid).set({
+            "id":        iid,
+            "order_id":  oid,
+            "item_id":   item.get("id"),
+            "item_name": item.get("name", ""),
+            "qty":       item.get("qty", 1),
+            "price":     item.get("price", 0),
+            "seat":      item.get("seat", 0),  # 0 = shared by the table
+            "op":        g.get("op_id")        # the table op that wrote it
+        })
+
+def _new_order(table, items):
+    now = datetime.now().isoformat()
+    oid = g.get("op_oid")           # resuming a half-written order
+    if oid is None:
+        oid = _next_id("orders")
+        _op_started(oid)
+    else:
+        _op_drop_items(oid)
+    _doc("orders", oid).set({
+        "id":        oid,
+        "table_num": table,
+        "status":    "pending",
+        "stage":     "ordered",   # customer journey stage
+        "created_at": now,
+        "updated_at": now
+    })
+    _write_order_items(oid, items)
+    _buzz_host(1)
+    app.logger.info(f"Order #{oid} placed — table {table}, {len(items)} items")
+    notify_dashboard("new_order", {"order_id": oid, "table_num": table, "items_count": len(items)})
+    return oid
+
+def _append_items(oid, items):
+    _op_drop_items(oid)
+    _op_started(oid)
+    _write_order_items(oid, items)
+    # Set status back to "preparing" so kitchen sees it again
+    _doc("orders", oid).update({
+        "status": "pending",
+        "stage":  "ordered",
+        "updated_at": datetime.now().isoformat()
+    })
+    _buzz_host(1)
+    app.logger.info(f"Appended {len(items)} items to order #{oid}")
+
 @app.route("/api/order", methods=["POST"])
+@idempotent
 def api_place_order():
     try:
         data  = request.get_json(force=True)
-        table = data.get("table", 1)
-        items = data.get("items", [])
-
-        now = datetime.now().isoformat()
-        oid = _next_id("orders")
-
-        _doc("orders", oid).set({
-            "id":        oid,
-            "table_num": table,
-            "status":    "pending",
-            "stage":     "ordered",   # customer journey stage
-            "created_at": now,
-            "updated_at": now
-        })
-
-        # Write items individually — do NOT use batch when _next_id() is called
-        # inside the loop (each _next_id() runs its own Firestore transaction,
-        # which conflicts with an open batch)
-        for item in items:
-            iid = _next_id("order_items")
-            _doc("order_items", iid).set({
-                "id":        iid,
-                "order_id":  oid,
-                "item_id":   item.get("id"),
-                "item_name": item.get("name", ""),
-                "qty":       item.get("qty", 1),
-                "price":     item.get("price", 0)
-            })
-
-        _buzz_host(1)
-        app.logger.info(f"Order #{oid} placed — table {table}, {len(items)} items")
-        notify_dashboard("new_order", {"order_id": oid, "table_num": table, "items_count": len(items)})
+        oid   = _new_order(data.get("table", 1), data.get("items", []))
+        _drop_live_cart(data.get("cart_id"))
         return jsonify({"ok": True, "order_id": oid})
     except Exception as e:
         app.logger.error(f"api_place_order error: {e}")
@@ -401,6 +501,7 @@ def api_food_ready():
         return jsonify({"error": str(e)}), 500
 
 @app.route("/api/order/food-served", methods=["POST"])
+@idempotent
 def api_food_served():
     """BUG 2 FIX: guarantee DB update and return status in response."""
     oid = request.get_json(force=True).get("order_id")
@@ -425,6 +526,7 @@ def api_food_served():
 
 # BUG 1 FIX: Append items to existing order (Add More Items flow)
 @app.route("/api/order/append", methods=["POST"])
+@idempotent
 def api_append_order():
     """Append new items to an existing order (append_mode=true on table).
     Returns the SAME order_id, not a new one."""
@@ -437,25 +539,8 @@ def api_append_order():
         snap = _doc("orders", oid).get()
         if not snap.exists:
             return jsonify({"error": "order not found"}), 404
-        # Append new order_items
-        for item in items:
-            iid = _next_id("order_items")
-            _doc("order_items", iid).set({
-                "id":        iid,
-                "order_id":  oid,
-                "item_id":   item.get("id"),
-                "item_name": item.get("name", ""),
-                "qty":       item.get("qty", 1),
-                "price":     item.get("price", 0)
-            })
-        # Set status back to "preparing" so kitchen sees it again
-        _doc("orders", oid).update({
-            "status": "pending",
-            "stage":  "ordered",
-            "updated_at": datetime.now().isoformat()
-        })
-        _buzz_host(1)
-        app.logger.info(f"Appended {len(items)} items to order #{oid}")
+        _append_items(oid, items)
+        _drop_live_cart(data.get("cart_id"))
         return jsonify({"ok": True, "order_id": oid})
     except Exception as e:
         app.logger.error(f"api_append_order error: {e}")
@@ -463,6 +548,106 @@ def api_append_order():
 
 
 
+# ═════════════════════════════════════════════════════════════════════
+#  LIVE CART — the table streams +/- deltas while the guest browses
+#  (LIVE_CART_SYNC); placing the order is then a small commit.
+#  live_carts/<cart_id>: {"table_num","seq","items":{"<id>:<seat>":{...}}}
+# ═════════════════════════════════════════════════════════════════════
+def _drop_live_cart(cid):
+    """The table gave up live sync and posted its full cart: the copy it
+    streamed is ordered now and must stop counting as forming demand."""
+    if cid:
+        _doc("live_carts", cid).delete()
+
+@app.route("/api/cart/delta", methods=["POST"])
+def api_cart_delta():
+    """Batches arrive in order from one table; seq must be the next one.
+    A repeat (seq already applied) is acknowledged, a gap is refused and
+    the table falls back to posting its full cart at order time."""
+    data = request.get_json(force=True)
+    cid  = data.get("cart_id")
+    seq  = data.get("seq", 0)
+    if not cid:
+        return jsonify({"error": "missing cart_id"}), 400
+    ref  = _doc("live_carts", cid)
+    snap = ref.get()
+    cart = snap.to_dict() if snap.exists else {"table_num": data.get("table"), "seq": 0, "items": {}}
+    if not snap.exists:
+        # A table has one cart at a time: an older one (the table rebooted
+        # or moved on without posting it) is abandoned
+        for old in _col("live_carts").where("table_num", "==", cart["table_num"]).stream():
+            old.reference.delete()
+    if seq <= cart["seq"]:
+        return jsonify({"ok": True, "seq": cart["seq"], "duplicate": True})
+    if seq != cart["seq"] + 1:
+        return jsonify({"error": "gap", "seq": cart["seq"]}), 409
+    for d in data.get("deltas", []):
+        key = f"{d.get('id')}:{d.get('seat', 0)}"
+        it  = cart["items"].get(key, {"id": d.get("id"), "seat": d.get("seat", 0), "qty": 0})
+        it["qty"] = it["qty"] + d.get("dq", 0)
+        if "name" in d:  it["name"]  = d["name"]
+        if "price" in d: it["price"] = d["price"]
+        if it["qty"] > 0: cart["items"][key] = it
+        else:             cart["items"].pop(key, None)
+    cart["seq"] = seq
+    cart["updated_at"] = datetime.now().isoformat()
+    ref.set(cart)
+    notify_dashboard("cart_update", {"table_num": cart["table_num"], "cart_id": cid,
+                                     "items_count": sum(i["qty"] for i in cart["items"].values())})
+    return jsonify({"ok": True, "seq": seq})
+
+@app.route("/api/order/commit", methods=["POST"])
+@idempotent
+def api_order_commit():
+    """Turn a live cart into an order (or an append when order_id is set).
+    The table states what it believes it sent (seq, item count, subtotal);
+    any mismatch is 409 and the table posts the full cart instead."""
+    try:
+        data = request.get_json(force=True)
+        cid  = data.get("cart_id")
+        oid  = data.get("order_id")
+        ref  = _doc("live_carts", cid) if cid else None
+        snap = ref.get() if ref else None
+        if not snap or not snap.exists:
+            return jsonify({"error": "unknown cart"}), 409
+        cart  = snap.to_dict()
+        items = list(cart["items"].values())
+        count = sum(i["qty"] for i in items)
+        sub   = sum(i["qty"] * i.get("price", 0) for i in items)
+        if (cart["seq"] != data.get("seq") or count != data.get("items")
+                or sub != data.get("subtotal")):
+            return jsonify({"error": "mismatch", "seq": cart["seq"],
+                            "items": count, "subtotal": sub}), 409
+        if oid:
+            if not _doc("orders", oid).get().exists:
+                return jsonify({"error": "order not found"}), 404
+            _append_items(oid, items)
+        else:
+            oid = _new_order(cart.get("table_num", 1), items)
+        ref.delete()
+        return jsonify({"ok": True, "order_id": oid})
+    except Exception as e:
+        app.logger.error(f"api_order_commit error: {e}")
+        return jsonify({"error": str(e)}), 500
+
+@app.route("/api/chef/live-carts", methods=["GET"])
+@api_chef_required
+def api_chef_live_carts():
+    """Demand forming at the tables: carts touched in the last 30 min,
+    and the total qty per dish across them for prep planning."""
+    from datetime import timedelta
+    since  = (datetime.now() - timedelta(minutes=30)).isoformat()
+    carts, demand = [], {}
+    for d in _col("live_carts").where("updated_at", ">=", since).stream():
+        c = d.to_dict()
+        carts.append({"cart_id": d.id, "table_num": c.get("table_num"),
+                      "updated_at": c.get("updated_at"), "items": list(c["items"].values())})
+        for it in c["items"].values():
+            row = demand.setdefault(it["id"], {"item_id": it["id"], "name": it.get("name", ""), "qty": 0})
+            row["qty"] += it["qty"]
+    return jsonify({"carts": carts,
+                    "demand": sorted(demand.values(), key=lambda r: -r["qty"])})
+
 # ═════════════════════════════════════════════════════════════════════
 #  CHEF ACTIVE ORDER — live customer journey
 # ═════════════════════════════════════════════════════════════════════
@@ -483,6 +668,8 @@ def api_chef_active():
             # Attach payment info
             psnap = get_db().collection("payments").document(f"ord_{o['id']}").get()
             o["payment"] = psnap.to_dict() if psnap.exists else None
+            if o["payment"] and o["payment"].get("split"):
+                o["seat_payments"] = _seat_payments(o["id"])
             orders.append(o)
         
         # Sort by status priority (billing/timeout first)
@@ -522,27 +709,110 @@ def api_chef_stats_today():
 # ═════════════════════════════════════════════════════════════════════
 #  BILL
 # ═════════════════════════════════════════════════════════════════════
+# ═════════════════════════════════════════════════════════════════════
+#  SPLIT BILL — per-seat groups (seat 0 = shared)
+#  Same rule as the table unit (bill_split.c): GST is 5% of the table
+#  subtotal (floored); each seat gets its floored share and the rupees
+#  left over go to the largest dropped fractions, lower seat on ties.
+# ═════════════════════════════════════════════════════════════════════
+def _bill_split(items):
+    subs = {}
+    for d in items:
+        seat = int(d.get("seat", 0) or 0)
+        subs[seat] = subs.get(seat, 0) + d.get("qty", 1) * d.get("price", 0)
+    seats = [{"seat": k, "subtotal": v, "gst": v * 5 // 100} for k, v in sorted(subs.items())]
+    left = sum(subs.values()) * 5 // 100 - sum(g["gst"] for g in seats)
+    for g in sorted(seats, key=lambda g: (-(g["subtotal"] * 5 % 100), g["seat"]))[:left]:
+        g["gst"] += 1
+    for g in seats:
+        g["total"] = g["subtotal"] + g["gst"]
+    return seats
+
+def _seat_arg(v):
+    """Optional seat from a request; None (or < 0) = the whole table."""
+    try:
+        v = int(v)
+    except (TypeError, ValueError):
+        return None
+    return v if v >= 0 else None
+
+def _pay_doc(oid, seat=None):
+    return f"ord_{oid}" if seat is None else f"ord_{oid}_s{seat}"
+
+def _seat_total(oid, seat):
+    """Rupee total owed by one seat group (0 if it ordered nothing)."""
+    items = [i.to_dict() for i in _col("order_items").where("order_id", "==", oid).stream()]
+    return next((g["total"] for g in _bill_split(items) if g["seat"] == seat), 0)
+
+def _settle_seat(oid, seat, method):
+    """Mark one seat paid; the order is paid once every group is. Returns
+    True when that closed the order."""
+    get_db().collection("payments").document(_pay_doc(oid, seat)).set(
+        {"order_id": oid, "seat": seat, "status": "paid", "method": method}, merge=True)
+    items = [i.to_dict() for i in _col("order_items").where("order_id", "==", oid).stream()]
+    for g in _bill_split(items):
+        snap = get_db().collection("payments").document(_pay_doc(oid, g["seat"])).get()
+        if not snap.exists or snap.to_dict().get("status") != "paid":
+            return False
+    get_db().collection("payments").document(_pay_doc(oid)).set({"status": "paid"}, merge=True)
+    _doc("orders", oid).update({"status": "paid", "payment_method": method,
+                                 "updated_at": datetime.now().isoformat()})
+    return True
+
+def _seat_payments(oid):
+    """Per-seat payment docs of a split bill, one per seat group."""
+    items = [i.to_dict() for i in _col("order_items").where("order_id", "==", oid).stream()]
+    out = []
+    for g in _bill_split(items):
+        snap = get_db().collection("payments").document(_pay_doc(oid, g["seat"])).get()
+        d = snap.to_dict() if snap.exists else {}
+        out.append({"seat": g["seat"], "amount": g["total"],
+                    "method": d.get("method"), "status": d.get("status", "unpaid")})
+    return out
+
+def _split_seat_to_verify(oid):
+    """A chef confirm without a seat on a split bill: the one seat with a
+    payment under way, or None when that is ambiguous (or nothing is)."""
+    pending = [p["seat"] for p in _seat_payments(oid)
+               if p["method"] and p["status"] != "paid"]
+    return pending[0] if len(pending) == 1 else None
+
+def _seat_status(oid, seat):
+    """A seat is paid if its own doc is, or the whole table was settled."""
+    whole = get_db().collection("payments").document(_pay_doc(oid)).get()
+    if whole.exists and whole.to_dict().get("status") == "paid":
+        return "paid"
+    snap = get_db().collection("payments").document(_pay_doc(oid, seat)).get()
+    return snap.to_dict().get("status", "pending") if snap.exists else "pending"
+
 @app.route("/api/order/bill", methods=["POST"])
 def api_generate_bill():
-    oid   = request.get_json(force=True).get("order_id")
+    """preview: the table prefetching while the guest eats - same bill,
+    but the order is not moved to billing and nobody is notified."""
+    data    = request.get_json(force=True)
+    oid     = data.get("order_id")
+    preview = bool(data.get("preview"))
     items = list(_col("order_items").where("order_id", "==", oid).stream())
     subtotal = sum(i.to_dict()["qty"] * i.to_dict()["price"] for i in items)
     gst      = subtotal * 5 // 100
     total    = subtotal + gst
-    _doc("orders", oid).update({"status": "billing", "updated_at": datetime.now().isoformat()})
+    if not preview:
+        _doc("orders", oid).update({"status": "billing", "updated_at": datetime.now().isoformat()})
     
     # Pre-generate QR bit-matrix for the table
     upi_link = f"upi://pay?pa={UPI_ID}&pn=AutoDine&am={total}&tr=ord_{oid}&mc=0000"
     qr_data  = _get_qr_matrix(upi_link)
     
-    _buzz_host(1)
-    notify_dashboard("order_update", {"order_id": oid, "status": "billing"})
+    if not preview:
+        _buzz_host(1)
+        notify_dashboard("order_update", {"order_id": oid, "status": "billing"})
     return jsonify({
         "order_id": oid,
         "items":    [i.to_dict() for i in items],
         "subtotal": subtotal,
         "gst":      gst,
         "total":    total,
+        "seats":    _bill_split([i.to_dict() for i in items]),
         "qr_matrix": qr_data["matrix"],
         "qr_size":   qr_data["size"]
     })
@@ -555,11 +825,26 @@ def api_payment_method():
     data   = request.get_json(force=True)
     oid    = data.get("order_id")
     method = data.get("method", "cash")
+    seat   = _seat_arg(data.get("seat"))
 
     items    = list(_col("order_items").where("order_id", "==", oid).stream())
     subtotal = sum(i.to_dict()["qty"] * i.to_dict()["price"] for i in items)
     total    = subtotal + subtotal * 5 // 100
 
+    if seat is not None:
+        # One seat of a split bill: its own doc; the table doc just shows
+        # the chef that a (split) payment is under way
+        total = _seat_total(oid, seat)
+        get_db().collection("payments").document(_pay_doc(oid, seat)).set({
+            "order_id": oid, "seat": seat, "method": method, "amount": total,
+            "status": "pending", "created_at": datetime.now().isoformat()
+        }, merge=True)
+        get_db().collection("payments").document(_pay_doc(oid)).set(
+            {"order_id": oid, "method": method, "split": True}, merge=True)
+        _buzz_host(2)
+        notify_dashboard("payment_initiated", {"order_id": oid, "method": method, "seat": seat})
+        return jsonify({"ok": True, "total": total, "seat": seat})
+
     # Upsert payment document (use order_id as document id for easy lookup)
     pref = get_db().collection("payments").document(f"ord_{oid}")
     if pref.get().exists:
@@ -582,6 +867,10 @@ def api_payment_status():
         oid = request.args.get("order_id", type=int)
         if not oid:
             return jsonify({"status": "pending", "method": None})
+        seat = _seat_arg(request.args.get("seat"))
+        if seat is not None:
+            return jsonify({"order_id": oid, "seat": seat,
+                            "status": _seat_status(oid, seat)})
         snap = get_db().collection("payments").document(f"ord_{oid}").get()
         if not snap.exists:
             return jsonify({"status": "pending", "method": None})
@@ -627,7 +916,19 @@ def api_payment_static_qr():
 @app.route("/api/payment/verify-manual", methods=["POST"])
 @api_chef_required
 def api_verify_manual():
-    oid  = request.get_json(force=True).get("order_id")
+    data = request.get_json(force=True)
+    oid  = data.get("order_id")
+    seat = _seat_arg(data.get("seat"))
+    whole = get_db().collection("payments").document(_pay_doc(oid)).get()
+    if seat is None and whole.exists and whole.to_dict().get("split"):
+        # Never settle the whole table for one seat's payment
+        seat = _split_seat_to_verify(oid)
+        if seat is None:
+            return jsonify({"ok": False, "error": "split bill: seat required"}), 409
+    if seat is not None:
+        _settle_seat(oid, seat, "manual")
+        _buzz_host(3)
+        return jsonify({"ok": True, "seat": seat})
     now  = datetime.now().isoformat()
     # BUG FIX: set payment_status="paid" (matches firmware check)
     get_db().collection("payments").document(f"ord_{oid}").update(
@@ -684,6 +985,65 @@ def api_feedback():
     })
     return jsonify({"ok": True})
 
+# ═════════════════════════════════════════════════════════════════════
+#  UI TRACE (table state-machine transitions, batched by the unit)
+# ═════════════════════════════════════════════════════════════════════
+DWELL_EDGES_S = [1, 5, 15, 30, 60, 120, 300, 600, 1200]   # same buckets as the unit
+
+@app.route("/api/trace", methods=["POST"])
+def api_trace():
+    data   = request.get_json(force=True)
+    table  = data.get("table")
+    events = data.get("events", [])[:64]
+    now    = datetime.now().isoformat()
+    batch  = get_db().batch()
+    for e in events:
+        batch.set(_col("ui_trace").document(), {
+            "table_num": table, "t_ms": e.get("t", 0),
+            "from": e.get("from", ""), "to": e.get("to", ""), "event": e.get("ev", ""),
+            "dwell_ms": e.get("dwell_ms", 0), "queued_us": e.get("queued_us", 0),
+            "run_us": e.get("run_us", 0), "render_ms": e.get("render_ms", 0),
+            "frames": e.get("frames", 0), "created_at": now
+        })
+    batch.commit()
+    if data.get("lost"):
+        print(f"[TRACE] table {table}: {data['lost']} transition(s) lost before upload")
+    return jsonify({"ok": True, "stored": len(events)})
+
+@app.route("/api/owner/analytics/screens", methods=["GET"])
+@api_owner_required
+def api_analytics_screens():
+    """Per screen, all tables: dwell histogram and percentiles, and what
+    entering it costs the UI (build + first 600 ms of rendering)."""
+    from datetime import timedelta
+    days  = request.args.get("days", 1, type=int)
+    since = (datetime.now() - timedelta(days=days)).isoformat()
+    dwell, cost = {}, {}
+    for d in _col("ui_trace").where("created_at", ">=", since).stream():
+        e = d.to_dict()
+        dwell.setdefault(e.get("from", "?"), []).append(e.get("dwell_ms", 0))
+        cost.setdefault(e.get("to", "?"), []).append((e.get("run_us", 0), e.get("render_ms", 0)))
+
+    def pct(v, p):
+        return v[min(len(v) - 1, int(len(v) * p))] if v else 0
+
+    screens = {}
+    for name in set(dwell) | set(cost):
+        v = sorted(dwell.get(name, []))
+        hist = [0] * (len(DWELL_EDGES_S) + 1)
+        for ms in v:
+            hist[next((i for i, e in enumerate(DWELL_EDGES_S) if ms < e * 1000),
+                      len(DWELL_EDGES_S))] += 1
+        c = cost.get(name, [])
+        screens[name] = {
+            "visits":     len(v),
+            "dwell_p50":  pct(v, 0.5), "dwell_p90": pct(v, 0.9),
+            "dwell_hist": hist,
+            "enter_run_us_avg":    sum(r for r, _ in c) // len(c) if c else 0,
+            "enter_render_ms_avg": sum(r for _, r in c) // len(c) if c else 0,
+        }
+    return jsonify({"days": days, "dwell_edges_s": DWELL_EDGES_S, "screens": screens})
+
 # ═════════════════════════════════════════════════════════════════════
 #  OWNER STATS
 # ═════════════════════════════════════════════════════════════════════
@@ -1004,11 +1364,15 @@ def api_chef_stream():
 @app.route("/api/razorpay/create-order", methods=["POST"])
 def api_razorpay_create_order():
     """Consolidated: Calculates order total and creates a Razorpay Payment Link.
-    Ensures browser opens for test mode auto-verification."""
+    Ensures browser opens for test mode auto-verification.
+    preview: link prefetched before the guest picks UPI - the payment
+    method is left alone and the dashboard is not told yet."""
     try:
         data = request.get_json(force=True)
         oid = data.get("order_id")
         if not oid: return jsonify({"error": "Missing order_id"}), 400
+        seat = _seat_arg(data.get("seat"))
+        preview = bool(data.get("preview"))
 
         # Calculate exact total from DB order_items
         items_ref = _col("order_items").where("order_id", "==", oid).stream()
@@ -1019,6 +1383,9 @@ def api_razorpay_create_order():
         
         if subtotal <= 0: return jsonify({"error": "Empty order"}), 400
         total_paise = int(subtotal * 1.05 * 100) # 5% GST
+        if seat is not None:
+            total_paise = _seat_total(oid, seat) * 100
+            if total_paise <= 0: return jsonify({"error": "Empty seat"}), 400
         
         ord_snap = _doc("orders", oid).get()
         table_num = ord_snap.to_dict().get("table_num", 1) if ord_snap.exists else 1
@@ -1040,11 +1407,12 @@ def api_razorpay_create_order():
                     "amount": total_paise,
                     "currency": "INR",
                     "accept_partial": False,
-                    "description": f"AutoDine Order #{oid} (Table {table_num})",
+                    "description": f"AutoDine Order #{oid} (Table {table_num})"
+                                   + (f" Seat {seat}" if seat else ""),
                     "customer": { "name": f"Table {table_num}", "contact": "+919000000001", "email": "customer@autodine.com" },
                     "notify": { "sms": False, "email": False },
                     "reminder_enable": False,
-                    "notes": { "order_id": str(oid) }
+                    "notes": { "order_id": str(oid), "seat": "" if seat is None else str(seat) }
                 }
                 pl = client.payment_link.create(pl_data)
                 plink_id = pl.get("id")
@@ -1055,14 +1423,20 @@ def api_razorpay_create_order():
                 qr_url = "https://bit.ly/AD-Payment-Error"
 
         # Update payments record in DB
-        _doc("payments", f"ord_{oid}").set({
+        pay = {
             "order_id": oid,
+            "seat": seat,
             "amount_paise": total_paise,
             "status": "pending",
-            "method": "upi",
             "razorpay_link_id": plink_id,
             "created_at": datetime.now().isoformat()
-        }, merge=True)
+        }
+        if not preview:
+            pay["method"] = "upi"
+        _doc("payments", _pay_doc(oid, seat)).set(pay, merge=True)
+        if seat is not None and not preview:
+            _doc("payments", _pay_doc(oid)).set(
+                {"order_id": oid, "method": "upi", "split": True}, merge=True)
         
         resp_data = {
             "ok": True, 
@@ -1071,7 +1445,9 @@ def api_razorpay_create_order():
             "plink_id": plink_id
         }
         print(f"📡 RESPONSE TO ESP32: {resp_data}")
-        notify_dashboard("payment_initiated", {"order_id": oid, "method": "upi", "table_num": table_num})
+        if not preview:
+            notify_dashboard("payment_initiated", {"order_id": oid, "method": "upi", "seat": seat,
+                                                   "table_num": table_num})
         return jsonify(resp_data)
 
     except Exception as e:
@@ -1086,7 +1462,10 @@ def api_razorpay_status(oid):
     """ESP32 polls this to check if Razorpay payment link has been paid.
     Uses razorpay SDK payment_link.fetch() if available, otherwise DB."""
     try:
-        snap = get_db().collection("payments").document(f"ord_{oid}").get()
+        seat = _seat_arg(request.args.get("seat"))
+        if seat is not None and _seat_status(oid, seat) == "paid":
+            return jsonify({"status": "paid"})
+        snap = get_db().collection("payments").document(_pay_doc(oid, seat)).get()
         if not snap.exists:
             return jsonify({"status": "pending"})
         d = snap.to_dict()
@@ -1112,10 +1491,13 @@ def api_razorpay_status(oid):
 
                     # Auto-confirm in DB
                     now = datetime.now().isoformat()
-                    get_db().collection("payments").document(f"ord_{oid}").update({"status": "paid"})
-                    _doc("orders", oid).update({
-                        "status": "paid", "payment_method": "upi", "updated_at": now
-                    })
+                    if seat is not None:
+                        _settle_seat(oid, seat, "upi")
+                    else:
+                        get_db().collection("payments").document(f"ord_{oid}").update({"status": "paid"})
+                        _doc("orders", oid).update({
+                            "status": "paid", "payment_method": "upi", "updated_at": now
+                        })
                     _buzz_host(3)
                     app.logger.info(f"Razorpay auto-confirm: Order #{oid} paid")
                     notify_dashboard("payment_update", {"order_id": oid, "status": "paid", "table_num": table_num})
@@ -1179,22 +1561,35 @@ def api_payment_confirm():
 @app.route("/api/payment/timeout", methods=["POST"])
 def api_payment_timeout():
     """Called when 5-minute UPI QR countdown expires without payment."""
-    oid = request.get_json(force=True).get("order_id")
+    data = request.get_json(force=True)
+    oid  = data.get("order_id")
+    seat = _seat_arg(data.get("seat"))
     _doc("orders", oid).update({"payment_status": "timeout",
                                   "updated_at": datetime.now().isoformat()})
-    get_db().collection("payments").document(f"ord_{oid}").update(
-        {"status": "timeout"})
+    get_db().collection("payments").document(_pay_doc(oid, seat)).set(
+        {"status": "timeout"}, merge=True)
     return jsonify({"ok": True})
 
 
 @app.route("/api/chef/verify_payment", methods=["POST"])
 @api_chef_required
 def api_chef_verify_payment():
-    """Chef manually confirms payment after timeout."""
-    oid = request.get_json(force=True).get("order_id")
-    now = datetime.now().isoformat()
-    get_db().collection("payments").document(f"ord_{oid}").update({"status": "paid"})
-    _doc("orders", oid).update({"status": "paid", "payment_method": "manual", "updated_at": now})
+    """Chef manually confirms payment after timeout. With "seat", only
+    that group of a split bill; without, the whole table."""
+    data = request.get_json(force=True)
+    oid  = data.get("order_id")
+    seat = _seat_arg(data.get("seat"))
+    now  = datetime.now().isoformat()
+    whole = get_db().collection("payments").document(_pay_doc(oid)).get()
+    if seat is None and whole.exists and whole.to_dict().get("split"):
+        seat = _split_seat_to_verify(oid)
+        if seat is None:
+            return jsonify({"ok": False, "error": "split bill: seat required"}), 409
+    if seat is not None:
+        _settle_seat(oid, seat, "manual")
+    else:
+        get_db().collection("payments").document(f"ord_{oid}").update({"status": "paid"})
+        _doc("orders", oid).update({"status": "paid", "payment_method": "manual", "updated_at": now})
     
     ord_snap = _doc("orders", oid).get()
     table_num = ord_snap.to_dict().get("table_num", 1) if ord_snap.exists else 1
@@ -1301,6 +1696,15 @@ def api_razorpay_webhook():
         oid = int(order_id)
         now = datetime.now().isoformat()
 
+        # Split bill: a seat's link settles only that seat
+        seat = _seat_arg(notes.get("seat"))
+        if seat is not None:
+            _settle_seat(oid, seat, "upi")
+            _buzz_host(3)
+            notify_dashboard("payment_update", {"order_id": oid, "seat": seat,
+                                                "status": "paid", "source": "webhook"})
+            return jsonify({"ok": True, "order_id": oid, "seat": seat, "status": "paid"})
+
         # ── 3. Mark paid in DB ──
         get_db().collection("payments").document(f"ord_{oid}").set({
             "order_id": oid,